@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include "gzip/bgzf_reader.hpp"
+#include "gzip/bgzf_writer.hpp"
+
+namespace zipper::gzip {
+
+namespace {
+
+// 8 MB of text-like data in BGZF blocks, written once per process
+const std::filesystem::path& sample_file() {
+    static const std::filesystem::path path = [] {
+        auto p = std::filesystem::temp_directory_path() / "zipper-bgzf-bench.gz";
+        std::mt19937 rng(7);
+        std::vector<uint8_t> data(8 << 20);
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = static_cast<uint8_t>(rng() % 8 == 0 ? rng() : 'a' + i % 17);
+        }
+        thread_pool pool;
+        auto writer = bgzf_writer::create(pool, p, bgzf_options{.deflate = {.iterations = 0}});
+        writer->write(data.data(), data.size());
+        writer->finish();
+        return p;
+    }();
+    return path;
+}
+
+void BM_BgzfReadAll(benchmark::State& state) {
+    auto reader = bgzf_reader::open(sample_file());
+    thread_pool pool(state.range(0));
+    std::vector<uint8_t> target(reader->size());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(reader->read_all(pool, target.data(), target.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * reader->size());
+}
+
+} // namespace
+
+// worker threads; throughput should grow with them up to the number of cores
+BENCHMARK(BM_BgzfReadAll)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+}
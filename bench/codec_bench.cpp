@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "codec_registry.hpp"
+
+namespace zipper {
+
+namespace {
+
+// cache values: short JSON records with repeated keys
+std::vector<uint8_t> records(size_t size) {
+    const std::string fields[] = {"{\"key\":", "\"session:", "\",\"ttl\":3600", ",\"hits\":", "}\n"};
+    std::mt19937 rng(11);
+    std::vector<uint8_t> result;
+    while (result.size() < size) {
+        const auto& f = fields[rng() % 5];
+        result.insert(result.end(), f.begin(), f.end());
+        for (uint32_t i = rng() % 6; i > 0; i--) {
+            result.push_back(static_cast<uint8_t>('0' + rng() % 10));
+        }
+    }
+    result.resize(size);
+    return result;
+}
+
+const codec& builtin(int index) {
+    static const codec_registry registry = codec_registry::with_builtin();
+    static const char* names[] = {"lz", "deflate"};
+    return *registry.find(names[index]);
+}
+
+void BM_Encode(benchmark::State& state) {
+    const codec& c = builtin(state.range(0));
+    const auto input = records(state.range(1));
+    std::vector<uint8_t> output(c.compress_bound(input.size()));
+    auto e = c.make_encoder();
+    size_t written = 0;
+    for (auto _ : state) {
+        auto r = e->encode(input.data(), input.size(), output.data(), output.size());
+        written = r->bytes_written;
+    }
+    state.SetLabel(c.name);
+    state.counters["ratio"] = static_cast<double>(input.size()) / written;
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+void BM_Decode(benchmark::State& state) {
+    const codec& c = builtin(state.range(0));
+    auto input = records(state.range(1));
+    std::vector<uint8_t> compressed(c.compress_bound(input.size()));
+    auto r = c.make_encoder()->encode(input.data(), input.size(), compressed.data(), compressed.size());
+    compressed.resize(r->bytes_written);
+    for (auto _ : state) {
+        auto d = c.make_decoder(compressed.data(), compressed.size());
+        benchmark::DoNotOptimize(d->decode(input.data(), input.size()));
+    }
+    state.SetLabel(c.name);
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+} // namespace
+
+// codec 0 is lz, 1 raw deflate
+BENCHMARK(BM_Encode)->ArgsProduct({{0, 1}, {1 << 10, 64 << 10}});
+BENCHMARK(BM_Decode)->ArgsProduct({{0, 1}, {1 << 10, 64 << 10}});
+
+}
@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "gzip/decoder.hpp"
+#include "gzip/encoder.hpp"
+#include "service/decode_client.hpp"
+#include "service/decode_server.hpp"
+
+namespace zipper::service {
+
+namespace {
+
+std::vector<uint8_t> gzip_message(size_t size, std::vector<uint8_t>& plain) {
+    std::mt19937 rng(29);
+    std::string text;
+    while (text.size() < size) {
+        text += "{\"id\":" + std::to_string(rng() % 100000) + ",\"state\":\"" + (rng() % 2 ? "open" : "closed") + "\"}\n";
+    }
+    text.resize(size);
+    plain.assign(text.begin(), text.end());
+    gzip::encoder encoder(deflate::optimal_options{.iterations = 1});
+    std::vector<uint8_t> out(size + size / 8 + 1024);
+    auto r = encoder.encode(plain.data(), plain.size(), out.data(), out.size());
+    out.resize(r ? r->bytes_written : 0);
+    return out;
+}
+
+// Decodes a gzip message of range(0) uncompressed bytes in the process, the baseline for the
+// service round trip below.
+void BM_LocalDecode(benchmark::State& state) {
+    std::vector<uint8_t> plain;
+    auto compressed = gzip_message(state.range(0), plain);
+    std::vector<uint8_t> out(plain.size());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(gzip::decoder(compressed.data(), compressed.size()).decode(out.data(), out.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * plain.size());
+}
+
+// The same message sent to a decode service in this process through a shared segment, so the
+// difference is the cost of the socket round trip and the hand-over to the pool.
+void BM_ServiceDecode(benchmark::State& state) {
+    std::vector<uint8_t> plain;
+    auto compressed = gzip_message(state.range(0), plain);
+    thread_pool pool(1);
+    decode_server server(pool);
+    const auto path = std::filesystem::temp_directory_path() / ("zipper-service-bench-" + std::to_string(getpid()) + ".sock");
+    if (!server.start(path)) {
+        state.SkipWithError("cannot start the service");
+        return;
+    }
+    auto client = decode_client::connect(path);
+    auto segment = shared_segment::create(compressed.size() + plain.size());
+    auto number = client->attach(*segment);
+    std::memcpy(segment->data(), compressed.data(), compressed.size());
+    const decode_job job{.segment = *number, .format = stream_format::gzip, .input_length = compressed.size(),
+                         .output_offset = compressed.size(), .output_capacity = plain.size()};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(client->decode(job));
+    }
+    state.SetBytesProcessed(state.iterations() * plain.size());
+    const auto stats = server.stats();
+    state.counters["p99_us"] = static_cast<double>(stats.latency_percentile_us(0.99));
+}
+
+} // namespace
+
+BENCHMARK(BM_LocalDecode)->Arg(1 << 10)->Arg(64 << 10)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ServiceDecode)->Arg(1 << 10)->Arg(64 << 10)->Arg(1 << 20)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+}
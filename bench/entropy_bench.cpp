@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "deflate/block_writer.hpp"
+#include "deflate/optimal_encoder.hpp"
+#include "histogram.hpp"
+
+namespace zipper::deflate {
+
+namespace {
+
+// a parse of about 1 MB: skewed literals and matches of all lengths and distances
+struct symbol_sample {
+    std::vector<lz77_symbol> symbols;
+    std::vector<uint8_t> data;
+
+    symbol_sample() {
+        std::mt19937 rng(5);
+        std::geometric_distribution<int> literal(0.05);
+        size_t length = 0;
+        while (length < (1 << 20)) {
+            if (rng() % 4 != 0) {
+                symbols.push_back(lz77_symbol::literal(static_cast<uint8_t>('a' + literal(rng) % 64)));
+                length++;
+            } else {
+                const uint32_t len = MIN_MATCH + rng() % 32;
+                symbols.push_back(lz77_symbol::match(len, 1 + rng() % 32768));
+                length += len;
+            }
+        }
+        data.resize(length);
+    }
+};
+
+const symbol_sample& sample() {
+    static const symbol_sample s;
+    return s;
+}
+
+void BM_BlockStatistics(benchmark::State& state) {
+    const auto& s = sample();
+    for (auto _ : state) {
+        auto stats = block_statistics::from_symbols(s.symbols);
+        benchmark::DoNotOptimize(stats);
+    }
+    state.SetItemsProcessed(state.iterations() * s.symbols.size());
+}
+
+void BM_WriteBlock(benchmark::State& state) {
+    const auto& s = sample();
+    std::vector<uint8_t> target(compress_bound(s.data.size()));
+    for (auto _ : state) {
+        bit_buffer buffer(target.data(), target.size(), 0);
+        block_writer writer(buffer);
+        benchmark::DoNotOptimize(writer.write_block(s.symbols, s.data.data(), s.data.size(), true));
+    }
+    state.SetItemsProcessed(state.iterations() * s.symbols.size());
+}
+
+void BM_ByteHistogram(benchmark::State& state) {
+    std::vector<uint8_t> data(1 << 20);
+    std::mt19937 rng(6);
+    for (auto& b : data) {
+        // long runs are the worst case for a single table
+        b = rng() % 8 == 0 ? static_cast<uint8_t>(rng()) : ' ';
+    }
+    for (auto _ : state) {
+        std::array<uint32_t, 256> counts{};
+        byte_histogram(data.data(), data.size(), counts);
+        benchmark::DoNotOptimize(counts);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_BlockStatistics);
+BENCHMARK(BM_ByteHistogram);
+BENCHMARK(BM_WriteBlock);
+
+}
@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "deflate/decoder.hpp"
+#include "deflate/lockstep_decode.hpp"
+#include "deflate/optimal_encoder.hpp"
+
+namespace zipper::deflate {
+
+namespace {
+
+// many small independent streams of text-like data, as in one batch of requests
+struct corpus {
+    std::vector<std::vector<uint8_t>> compressed;
+    std::vector<std::vector<uint8_t>> outputs;
+    std::vector<stream_job> jobs;
+    size_t total = 0;
+
+    corpus(size_t streams, size_t size) {
+        static const char* words[] = {"alpha", "beta", "gamma", "delta", "user", "id", "status", "active", "{", "}", ":", ",", "\"", " "};
+        std::mt19937 rng(42);
+        optimal_encoder encoder(optimal_options{.iterations = 2});
+        for (size_t s = 0; s < streams; s++) {
+            std::vector<uint8_t> input;
+            while (input.size() < size) {
+                const char* w = words[rng() % std::size(words)];
+                input.insert(input.end(), w, w + std::char_traits<char>::length(w));
+                if (rng() % 4 == 0) {
+                    input.push_back(static_cast<uint8_t>('0' + rng() % 10));
+                }
+            }
+            input.resize(size);
+            std::vector<uint8_t> out(compress_bound(size));
+            out.resize(encoder.encode(input.data(), input.size(), out.data(), out.size())->bytes_written);
+            compressed.push_back(std::move(out));
+            outputs.emplace_back(size);
+            total += size;
+        }
+        for (size_t s = 0; s < streams; s++) {
+            jobs.push_back(stream_job{compressed[s].data(), compressed[s].size(), outputs[s].data(), outputs[s].size()});
+        }
+    }
+};
+
+corpus& shared_corpus(size_t size) {
+    static corpus small(256, 4 << 10);
+    static corpus large(32, 64 << 10);
+    return size == small.outputs[0].size() ? small : large;
+}
+
+// the same streams one after another with `decoder::decode`, on one core
+void BM_SequentialDecode(benchmark::State& state) {
+    auto& c = shared_corpus(state.range(0));
+    for (auto _ : state) {
+        for (auto& job : c.jobs) {
+            decoder d(job.source, job.source_length);
+            benchmark::DoNotOptimize(d.decode(job.target, job.target_length));
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * c.total);
+}
+
+// `range(1)` decoders taking turns a symbol at a time on one core; one lane is sequential
+// decoding through the stepping interface
+void BM_LockstepDecode(benchmark::State& state) {
+    auto& c = shared_corpus(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decode_lockstep(c.jobs, state.range(1)));
+    }
+    state.SetBytesProcessed(state.iterations() * c.total);
+}
+
+} // namespace
+
+BENCHMARK(BM_SequentialDecode)->Arg(4 << 10)->Arg(64 << 10);
+BENCHMARK(BM_LockstepDecode)->ArgsProduct({{4 << 10, 64 << 10}, {1, 2, 3, 4}});
+
+}
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "deflate/stream_encoder.hpp"
+
+namespace zipper::deflate {
+
+namespace {
+
+std::vector<uint8_t> backup_sample(size_t size) {
+    static const char* words[] = {"user=", "alice", "bob", " action=", "login", "upload", " size=", " ok\n", " failed\n"};
+    std::mt19937 rng(17);
+    std::vector<uint8_t> result;
+    while (result.size() < size) {
+        std::string w = words[rng() % std::size(words)];
+        if (rng() % 4 == 0) {
+            w += std::to_string(rng() % 100000);
+        }
+        result.insert(result.end(), w.begin(), w.end());
+    }
+    result.resize(size);
+    return result;
+}
+
+std::vector<uint8_t> compress(const std::vector<uint8_t>& input, const stream_options& options) {
+    stream_encoder e(options);
+    std::vector<uint8_t> out(input.size() + input.size() / 8 + 1024);
+    auto r = e.encode(input.data(), input.size(), out.data(), out.size(), flush_mode::finish);
+    out.resize(r ? r->bytes_written : 0);
+    return out;
+}
+
+// segments of the stream ending with an empty stored block, as a deduplicating store would cut it
+std::vector<std::vector<uint8_t>> segments(const std::vector<uint8_t>& compressed) {
+    static const uint8_t marker[] = {0x00, 0x00, 0xFF, 0xFF};
+    std::vector<std::vector<uint8_t>> result;
+    auto begin = compressed.begin();
+    for (auto it = compressed.begin(); (it = std::search(it, compressed.end(), std::begin(marker), std::end(marker))) != compressed.end();) {
+        it += sizeof(marker);
+        result.emplace_back(begin, it);
+        begin = it;
+    }
+    result.emplace_back(begin, compressed.end());
+    return result;
+}
+
+// Compresses 4 MB with content-defined cut points every 2^range(0) bytes on average, 0 for none.
+// `ratio` is compressed / input size; `resent` is the share of the compressed bytes of a copy with
+// a few small edits which a store holding the original segments still has to take.
+void BM_Rsyncable(benchmark::State& state) {
+    const auto original = backup_sample(4 << 20);
+    auto edited = original;
+    std::mt19937 rng(3);
+    for (int i = 0; i < 8; i++) {
+        const size_t pos = rng() % edited.size();
+        edited.insert(edited.begin() + pos, 'x');
+    }
+
+    stream_options options;
+    options.rsyncable = state.range(0) != 0;
+    options.rsync_bits = static_cast<uint32_t>(state.range(0));
+    std::vector<uint8_t> compressed;
+    for (auto _ : state) {
+        compressed = compress(original, options);
+        benchmark::DoNotOptimize(compressed.data());
+    }
+    state.SetBytesProcessed(state.iterations() * original.size());
+
+    const auto stored = segments(compressed);
+    const std::set<std::vector<uint8_t>> known(stored.begin(), stored.end());
+    const auto update = compress(edited, options);
+    size_t resent = 0;
+    for (const auto& segment : segments(update)) {
+        resent += known.count(segment) ? 0 : segment.size();
+    }
+    state.counters["ratio"] = static_cast<double>(compressed.size()) / original.size();
+    state.counters["resent"] = static_cast<double>(resent) / update.size();
+}
+
+} // namespace
+
+BENCHMARK(BM_Rsyncable)->Arg(0)->Arg(10)->Arg(12)->Arg(14)->Arg(16)->Unit(benchmark::kMillisecond);
+
+}
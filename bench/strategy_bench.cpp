@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "deflate/stream_encoder.hpp"
+
+namespace zipper::deflate {
+
+namespace {
+
+enum message_class { text, noise, runs };
+
+std::vector<uint8_t> message(message_class kind, size_t size) {
+    static const char* fields[] = {"{\"id\":", "\"user\":\"alice\"", "\"user\":\"bob\"", ",\"status\":\"ok\"", ",\"items\":[", "]}\n"};
+    std::mt19937 rng(23);
+    std::vector<uint8_t> result;
+    while (result.size() < size) {
+        if (kind == noise) {
+            result.push_back(static_cast<uint8_t>(rng()));
+        } else if (kind == runs) {
+            result.insert(result.end(), 1 + rng() % 64, static_cast<uint8_t>(rng() % 8));
+        } else {
+            std::string f = fields[rng() % std::size(fields)];
+            f += std::to_string(rng() % 1000);
+            result.insert(result.end(), f.begin(), f.end());
+        }
+    }
+    result.resize(size);
+    return result;
+}
+
+// Compresses one message of range(2) bytes of class range(1) with strategy range(0), reusing the
+// encoder as a server would. `latency` is the time per KiB of input, `ratio` compressed / input.
+void BM_Strategy(benchmark::State& state) {
+    const auto strategy = static_cast<compression_strategy>(state.range(0));
+    const auto input = message(static_cast<message_class>(state.range(1)), static_cast<size_t>(state.range(2)));
+    stream_encoder e(stream_options{.strategy = strategy});
+    std::vector<uint8_t> out(input.size() + input.size() / 8 + 64);
+    size_t compressed = 0;
+    for (auto _ : state) {
+        e.reset();
+        auto r = e.encode(input.data(), input.size(), out.data(), out.size(), flush_mode::finish);
+        compressed = r ? r->bytes_written : 0;
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+    state.counters["latency"] = benchmark::Counter(state.iterations() * input.size() / 1024.0,
+                                                   benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["ratio"] = static_cast<double>(compressed) / input.size();
+}
+
+} // namespace
+
+BENCHMARK(BM_Strategy)
+    ->ArgNames({"strategy", "class", "size"})
+    ->ArgsProduct({{0, 1, 2, 3}, {text, noise, runs}, {256, 4096, 65536}})
+    ->Unit(benchmark::kMicrosecond);
+
+}
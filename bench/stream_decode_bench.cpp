@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "deflate/optimal_encoder.hpp"
+#include "deflate/stream_decoder.hpp"
+
+namespace zipper::deflate {
+
+namespace {
+
+// 1 MB of log-like text, decoded through targets of `range(0)` bytes
+struct stream_sample {
+    std::vector<uint8_t> compressed;
+    size_t size;
+
+    stream_sample() : size(1 << 20) {
+        static const char* words[] = {"GET", "POST", "/api/v1/items", "/index.html", "200", "404", "bytes", " ", "\n"};
+        std::mt19937 rng(9);
+        std::vector<uint8_t> input;
+        while (input.size() < size) {
+            const char* w = words[rng() % std::size(words)];
+            input.insert(input.end(), w, w + std::char_traits<char>::length(w));
+            if (rng() % 3 == 0) {
+                input.push_back(static_cast<uint8_t>('0' + rng() % 10));
+            }
+        }
+        input.resize(size);
+        compressed.resize(compress_bound(size));
+        optimal_encoder e(optimal_options{.iterations = 1, .master_block_size = 1 << 16});
+        compressed.resize(e.encode(input.data(), input.size(), compressed.data(), compressed.size())->bytes_written);
+    }
+};
+
+void BM_StreamDecoder(benchmark::State& state) {
+    static const stream_sample sample;
+    std::vector<uint8_t> target(state.range(0));
+    for (auto _ : state) {
+        stream_decoder d;
+        d.feed(sample.compressed.data(), sample.compressed.size());
+        size_t written = 0;
+        while (*d.decode(target.data(), target.size(), written) != stream_status::done) {
+        }
+        benchmark::DoNotOptimize(target.data());
+    }
+    state.SetBytesProcessed(state.iterations() * sample.size);
+}
+
+} // namespace
+
+BENCHMARK(BM_StreamDecoder)->Arg(4 << 10)->Arg(64 << 10);
+
+}
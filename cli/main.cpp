@@ -1,12 +1,237 @@
-#include <iostream>
+#include <charconv>
+#include <csignal>
 #include <cstdint>
-#include "decoder_if.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "logger.hpp"
+#include "mapped_file.hpp"
+#include "service/decode_server.hpp"
+#include "transcoder.hpp"
+
+namespace {
+
+int usage() {
+    std::cerr << "usage: zipper-compression-cli transcode [options] <input> <output>\n"
+                 "  input and output may be - for stdin and stdout\n"
+                 "  --from deflate|zlib|gzip      input format, gzip by default\n"
+                 "  --to deflate|zlib|gzip|bgzf   output format, gzip by default\n"
+                 "  --threads N                   encoder threads, 0 (default) for one per core\n"
+                 "  --chunk BYTES                 uncompressed bytes per encoder job, 1048576 by default\n"
+                 "  --iterations N                optimal parsing passes, 15 by default\n"
+                 "  --stats                       print per-stage counters to stderr\n"
+                 "       zipper-compression-cli serve [options] <socket>\n"
+                 "  runs the local decode service until SIGINT or SIGTERM, SIGUSR1 prints its counters\n"
+                 "  --threads N                   decoder threads, 0 (default) for one per core\n"
+                 "  --dictionary FILE             preset dictionary offered to clients, may be repeated\n"
+                 "  --max-segments N              shared memory segments per client, 64 by default\n"
+                 "  --max-in-flight N             decode requests per client queued or running, 64 by default\n";
+    return 2;
+}
+
+std::optional<zipper::stream_format> parse_format(std::string_view name) {
+    if (name == "deflate") {
+        return zipper::stream_format::deflate;
+    }
+    if (name == "zlib") {
+        return zipper::stream_format::zlib;
+    }
+    if (name == "gzip") {
+        return zipper::stream_format::gzip;
+    }
+    return std::nullopt;
+}
+
+template<typename T>
+bool parse_number(std::string_view text, T& value) {
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size();
+}
+
+// throughput is counted in uncompressed bytes for both stages, so that they compare directly
+void print_stage(const char* name, const zipper::stage_stats& stage, uint64_t uncompressed) {
+    const double busy = std::chrono::duration<double>(stage.busy).count();
+    const double stalled = std::chrono::duration<double>(stage.stalled).count();
+    std::cerr << name << ": " << stage.bytes << " bytes out, busy " << busy << " s";
+    if (busy > 0) {
+        std::cerr << " (" << uncompressed / busy / 1e6 << " MB/s)";
+    }
+    std::cerr << ", pipeline waited " << stalled << " s\n";
+}
+
+int transcode_command(int argc, char** argv) {
+    zipper::transcode_options opts;
+    size_t threads = 0;
+    bool stats = false;
+    std::string_view paths[2];
+    size_t n_paths = 0;
+    for (int i = 0; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--from" && has_value) {
+            auto f = parse_format(argv[++i]);
+            if (!f) {
+                return usage();
+            }
+            opts.from = *f;
+        } else if (arg == "--to" && has_value) {
+            const std::string_view name = argv[++i];
+            opts.bgzf = name == "bgzf";
+            auto f = opts.bgzf ? zipper::stream_format::gzip : parse_format(name);
+            if (!f) {
+                return usage();
+            }
+            opts.to = *f;
+        } else if (arg == "--threads" && has_value) {
+            if (!parse_number(argv[++i], threads)) {
+                return usage();
+            }
+        } else if (arg == "--chunk" && has_value) {
+            if (!parse_number(argv[++i], opts.chunk_size) || opts.chunk_size == 0) {
+                return usage();
+            }
+        } else if (arg == "--iterations" && has_value) {
+            if (!parse_number(argv[++i], opts.deflate.iterations)) {
+                return usage();
+            }
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (n_paths < 2 && (arg == "-" || !arg.starts_with("--"))) {
+            paths[n_paths++] = arg;
+        } else {
+            return usage();
+        }
+    }
+    if (n_paths != 2) {
+        return usage();
+    }
+
+    zipper::logger lgr(std::cerr, zipper::log_level::error);
+    std::ifstream in_file;
+    std::ofstream out_file;
+    if (paths[0] != "-") {
+        in_file.open(std::string(paths[0]), std::ios::binary);
+        if (!in_file) {
+            lgr.log(zipper::log_level::error, "Cannot open", paths[0]);
+            return 1;
+        }
+    }
+    if (paths[1] != "-") {
+        out_file.open(std::string(paths[1]), std::ios::binary | std::ios::trunc);
+        if (!out_file) {
+            lgr.log(zipper::log_level::error, "Cannot create", paths[1]);
+            return 1;
+        }
+    }
+    std::istream& in = paths[0] == "-" ? std::cin : in_file;
+    std::ostream& out = paths[1] == "-" ? std::cout : out_file;
 
-int main() {
-    zipper::decoder_if* d = nullptr;
-    // std::cout << "Hello world" << std::endl << reinterpret_cast<uint64_t>(d) << std::endl;
-    zipper::logger lgr(std::cout, zipper::log_level::debug);
-    lgr.log(zipper::log_level::debug, "Hello world ", reinterpret_cast<uint64_t>(d));
+    zipper::thread_pool pool(threads);
+    auto result = zipper::transcode(pool, in, out, opts);
+    if (!result) {
+        lgr.log(zipper::log_level::error, result.error().message, "after", result.error().offset, "bytes");
+        return 1;
+    }
+    if (stats) {
+        print_stage("decode", result->decode, result->decode.bytes);
+        print_stage("encode", result->encode, result->decode.bytes);
+        std::cerr << "elapsed " << std::chrono::duration<double>(result->elapsed).count() << " s, bottleneck: "
+                  << (result->decode.stalled > result->encode.stalled ? "decode" : "encode") << "\n";
+    }
     return 0;
-}
\ No newline at end of file
+}
+
+void print_service(const zipper::service::service_stats& stats) {
+    const double mean = stats.requests == 0 ? 0 : stats.latency_total_ns / 1e3 / stats.requests;
+    std::cerr << stats.connections << " clients, " << stats.requests << " requests (" << stats.failures << " failed), "
+              << stats.bytes_in << " bytes in, " << stats.bytes_out << " bytes out\n"
+              << "queue depth " << stats.queue_depth << " (max " << stats.max_queue_depth << "), latency mean " << mean
+              << " us, p50 < " << stats.latency_percentile_us(0.5) << " us, p99 < " << stats.latency_percentile_us(0.99)
+              << " us, max " << stats.latency_max_ns / 1000 << " us\n";
+}
+
+int serve_command(int argc, char** argv) {
+    zipper::service::server_options opts;
+    size_t threads = 0;
+    std::vector<std::string_view> dictionaries;
+    std::string_view socket_path;
+    for (int i = 0; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--threads" && has_value) {
+            if (!parse_number(argv[++i], threads)) {
+                return usage();
+            }
+        } else if (arg == "--dictionary" && has_value) {
+            dictionaries.push_back(argv[++i]);
+        } else if (arg == "--max-segments" && has_value) {
+            if (!parse_number(argv[++i], opts.max_segments)) {
+                return usage();
+            }
+        } else if (arg == "--max-in-flight" && has_value) {
+            if (!parse_number(argv[++i], opts.max_in_flight)) {
+                return usage();
+            }
+        } else if (socket_path.empty() && !arg.starts_with("--")) {
+            socket_path = arg;
+        } else {
+            return usage();
+        }
+    }
+    if (socket_path.empty()) {
+        return usage();
+    }
+
+    // the signals are taken by sigwait, every thread started from here on inherits the mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    zipper::logger lgr(std::cerr, zipper::log_level::error);
+    zipper::thread_pool pool(threads);
+    zipper::service::decode_server server(pool, opts);
+    for (auto path : dictionaries) {
+        auto file = zipper::mapped_file::open(std::string(path));
+        if (!file) {
+            lgr.log(zipper::log_level::error, "Cannot open", path);
+            return 1;
+        }
+        server.add_dictionary(std::make_shared<const zipper::deflate::dictionary>(file->data(), file->size()));
+    }
+    if (auto r = server.start(std::string(socket_path)); !r) {
+        lgr.log(zipper::log_level::error, "Cannot listen on", socket_path, std::strerror(r.error()));
+        return 1;
+    }
+
+    for (;;) {
+        int signal = 0;
+        sigwait(&signals, &signal);
+        if (signal != SIGUSR1) {
+            break;
+        }
+        print_service(server.stats());
+    }
+    server.stop();
+    print_service(server.stats());
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::string_view(argv[1]) == "transcode") {
+        return transcode_command(argc - 2, argv + 2);
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "serve") {
+        return serve_command(argc - 2, argv + 2);
+    }
+    return usage();
+}
@@ -0,0 +1,91 @@
+#ifndef ASYNC_EVENT_LOOP_HPP
+#define ASYNC_EVENT_LOOP_HPP
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <sys/types.h>
+#include <unordered_map>
+#include "async/task.hpp"
+
+namespace zipper::async
+{
+
+// Single-threaded epoll loop resuming coroutines which wait for file descriptors.
+// Regular files cannot be polled and are always reported as ready.
+class event_loop {
+    struct waiters {
+        std::coroutine_handle<> reader;
+        std::coroutine_handle<> writer;
+    };
+
+    int epoll_fd;
+    int create_error = 0;
+    std::deque<std::coroutine_handle<>> ready;
+    std::unordered_map<int, waiters> waiting;
+    size_t active = 0;
+
+    void wait_for(int fd, bool write, std::coroutine_handle<> h);
+
+    struct readiness {
+        event_loop& loop;
+        int fd;
+        bool write;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop.wait_for(fd, write, h); }
+        void await_resume() const noexcept {}
+    };
+
+    template<typename T, typename F>
+    static detached run_detached(event_loop& loop, task<T> t, F on_done) {
+        on_done(co_await t);
+        loop.active--;
+    }
+public:
+    event_loop();
+    ~event_loop();
+    event_loop(const event_loop&) = delete;
+    event_loop& operator=(const event_loop&) = delete;
+
+    readiness readable(int fd) { return readiness{*this, fd, false}; }
+    readiness writable(int fd) { return readiness{*this, fd, true}; }
+
+    // Starts `t` right away; `on_done` receives its result once it finishes.
+    template<typename T, typename F>
+    void spawn(task<T> t, F on_done) {
+        active++;
+        run_detached(*this, std::move(t), std::move(on_done));
+    }
+
+    // errno of creating the epoll instance, 0 if that succeeded
+    int error() const { return create_error; }
+
+    // Runs until every spawned task has finished. Returns false if tasks are left
+    // which wait for nothing and can never finish, and right away if `error` is set.
+    bool run();
+};
+
+// Reads from a non-blocking file descriptor, suspending while it has no data.
+class fd_source {
+    event_loop& loop;
+    int fd;
+public:
+    fd_source(event_loop& l, int descriptor) : loop(l), fd(descriptor) {}
+    // bytes read, 0 at the end of input, -1 on error
+    task<ssize_t> read(std::span<uint8_t> buffer);
+};
+
+// Writes to a non-blocking file descriptor, suspending while it cannot take more data.
+class fd_sink {
+    event_loop& loop;
+    int fd;
+public:
+    fd_sink(event_loop& l, int descriptor) : loop(l), fd(descriptor) {}
+    // writes the whole buffer, returns its size or -1 on error
+    task<ssize_t> write(std::span<const uint8_t> buffer);
+};
+
+} // namespace zipper::async
+
+#endif
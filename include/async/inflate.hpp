@@ -0,0 +1,65 @@
+#ifndef ASYNC_INFLATE_HPP
+#define ASYNC_INFLATE_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <sys/types.h>
+#include <vector>
+#include "async/task.hpp"
+#include "decoder_if.hpp"
+#include "deflate/stream_decoder.hpp"
+
+namespace zipper::async
+{
+
+template<typename S>
+concept byte_source = requires(S& s, std::span<uint8_t> buffer) {
+    { s.read(buffer) } -> std::same_as<task<ssize_t>>;
+};
+
+template<typename S>
+concept byte_sink = requires(S& s, std::span<const uint8_t> buffer) {
+    { s.write(buffer) } -> std::same_as<task<ssize_t>>;
+};
+
+// Decodes a raw DEFLATE stream from `source` into `sink`. The coroutine suspends whenever the
+// decoder needs more input or its output buffer is full and resumes when the read or write
+// completes, so many streams can be decoded concurrently by one thread.
+// On success `bytes_written` is the decoded size and `bits_read` the size of the stream in bits.
+template<byte_source Source, byte_sink Sink>
+task<decode_result> inflate(deflate::stream_decoder& decoder, Source& source, Sink& sink, size_t buffer_size = 16384) {
+    std::vector<uint8_t> in(buffer_size);
+    std::vector<uint8_t> out(buffer_size);
+    size_t total = 0;
+
+    for (;;) {
+        size_t written = 0;
+        auto status = decoder.decode(out.data(), out.size(), written);
+        if (!status) {
+            co_return std::unexpected(status.error());
+        }
+        if (written > 0) {
+            if (co_await sink.write(std::span<const uint8_t>(out.data(), written)) < 0) {
+                co_return std::unexpected(decode_failure{decoder.total_in(), decoder.total_in() * 8, 0, "Writing decoded data failed"});
+            }
+            total += written;
+        }
+
+        if (*status == deflate::stream_status::done) {
+            co_return decode_success{total, decoder.total_in() * 8};
+        }
+        if (*status == deflate::stream_status::need_input) {
+            const ssize_t n = co_await source.read(std::span<uint8_t>(in));
+            if (n <= 0) {
+                co_return std::unexpected(decode_failure{decoder.total_in(), decoder.total_in() * 8, 0,
+                    n == 0 ? "Unexpected end of input" : "Reading compressed data failed"});
+            }
+            decoder.feed(in.data(), n);
+        }
+    }
+}
+
+} // namespace zipper::async
+
+#endif
@@ -21,6 +21,25 @@ public:
         } else {
             ptr[curr_index/8] &= ~(1 << (curr_index % 8));
         }
+        curr_index++;
+        return true;
+    }
+
+    template<typename T>
+    size_t write_bits(T value, uint32_t length) {
+        length = size_bytes * 8 - curr_index < length ? size_bytes * 8 - curr_index : length;
+
+        for (uint32_t offset = 0; offset < length;) {
+            const uint32_t bit_in_byte = curr_index % 8;
+            const uint32_t rest_in_byte = 8 - bit_in_byte; // unwritten bits in the current byte
+            const uint32_t to_cur_byte = (length - offset) < rest_in_byte ? (length - offset) : rest_in_byte; // bits to write to the current byte
+            const uint8_t mask = ((1 << to_cur_byte) - 1) << bit_in_byte;
+
+            ptr[curr_index / 8] = (ptr[curr_index / 8] & ~mask) | ((static_cast<uint32_t>(value >> offset) << bit_in_byte) & mask);
+            offset += to_cur_byte;
+            curr_index += to_cur_byte;
+        }
+        return length;
     }
 
     bool eob() const { return size_bytes * 8 <= curr_index; }
@@ -51,8 +70,9 @@ public:
     }
     
     void skip(size_t bits) { curr_index += bits; }
+    void seek(size_t bit_index) { curr_index = bit_index; }
     void skipt_to_byte() { 
-        if(curr_index == 0) {
+        if(curr_index % 8 == 0) {
             return;
         }
         curr_index += (8 - (curr_index % 8));
@@ -61,6 +81,7 @@ public:
     size_t offset() const {return curr_index;}
 
     uint8_t* data() const { return ptr; }
+    size_t size() const { return size_bytes; }
 
     size_t left_bits() const { return size_bytes * 8 - curr_index;}
 };
@@ -0,0 +1,73 @@
+#ifndef BIT_WRITER_HPP
+#define BIT_WRITER_HPP
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+namespace zipper
+{
+
+// LSB-first bit writer with a 64-bit accumulator for the hot loops of the encoders. Codes are
+// collected with `add` (up to 57 bits between two `flush`es, enough for a whole DEFLATE match
+// with its extra bits) and `flush` stores the complete bytes with one unaligned 8-byte write
+// while at least 8 bytes of the target remain.
+//
+// Unlike `bit_buffer` the writer does not check each write against the end of the target, the
+// caller reserves space up front; bytes past the target are never touched. Bytes after the
+// current position may be overwritten with zeros.
+class bit_writer {
+    uint8_t* begin;
+    uint8_t* out;
+    uint8_t* end;
+    uint64_t bits;
+    uint32_t count;
+public:
+    // continues a stream ending at bit `bit_index` of `p`, keeping the bits already written there
+    bit_writer(uint8_t* p, size_t size_in_bytes, size_t bit_index)
+        : begin(p), out(p + bit_index / 8), end(p + size_in_bytes), bits(0), count(bit_index % 8) {
+        if (count != 0) {
+            bits = *out & ((1u << count) - 1);
+        }
+    }
+
+    void add(uint64_t value, uint32_t length) {
+        bits |= value << count;
+        count += length;
+    }
+
+    void flush() {
+        const uint32_t bytes = count / 8;
+        if (end - out >= 8) {
+            const uint64_t le = std::endian::native == std::endian::little ? bits : std::byteswap(bits);
+            std::memcpy(out, &le, 8);
+        } else {
+            for (uint32_t i = 0; i < bytes && out + i < end; i++) {
+                out[i] = static_cast<uint8_t>(bits >> (8 * i));
+            }
+        }
+        out += bytes;
+        bits = count == 64 ? 0 : bits >> (8 * bytes);
+        count %= 8;
+    }
+
+    void write(uint64_t value, uint32_t length) {
+        add(value, length);
+        flush();
+    }
+
+    // stores the partial last byte, zero padded
+    void finish() {
+        flush();
+        if (count != 0 && out < end) {
+            *out = static_cast<uint8_t>(bits);
+        }
+    }
+
+    // bits written since the start of the target
+    size_t offset() const { return static_cast<size_t>(out - begin) * 8 + count; }
+};
+
+} // namespace zipper
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef BUFFER_RING_HPP
+#define BUFFER_RING_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace zipper {
+
+// Fixed set of equally sized buffers handed from one producer thread to one consumer thread in
+// order. The producer blocks while every buffer is filled or held, the consumer while none is
+// filled, so memory stays bounded however far apart the two run.
+class buffer_ring {
+    std::vector<std::vector<char>> buffers;
+    std::vector<size_t> lengths;
+    std::vector<bool> marks;
+    size_t produced = 0;
+    size_t consumed = 0;
+    bool holding = false;
+    bool closed = false;
+    bool cancelled = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+public:
+    struct slot {
+        std::span<char> data;
+        // set by the producer with `publish`, e.g. to ask for a flush after this buffer
+        bool mark;
+    };
+
+    buffer_ring(size_t count, size_t size);
+
+    // producer: the next buffer to fill, empty once the consumer cancelled
+    std::span<char> acquire();
+    // producer: hands the buffer from `acquire` with `length` bytes to the consumer
+    void publish(size_t length, bool mark = false);
+    // producer: no more buffers follow
+    void close();
+    // producer: waits until the consumer has come back for a buffer after the last published one
+    void drain();
+
+    // consumer: releases the buffer returned before and waits for the next one, nullopt at the end
+    std::optional<slot> next();
+    // consumer: stops taking buffers, a waiting producer returns
+    void cancel();
+};
+
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef CHECKSUM_HPP
+#define CHECKSUM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace zipper {
+
+// Adler-32 as used by the zlib container, `adler` continues a previous call.
+uint32_t adler32(const uint8_t* data, size_t length, uint32_t adler = 1);
+
+// CRC-32 (ISO-HDLC) as used by gzip and ZIP, `crc` continues a previous call.
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+}
+
+#endif
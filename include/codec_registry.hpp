@@ -0,0 +1,55 @@
+#ifndef CODEC_REGISTRY_HPP
+#define CODEC_REGISTRY_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "decoder_if.hpp"
+#include "encoder_if.hpp"
+
+namespace zipper {
+
+// A compression format: how to recognise its streams and how to make its coders.
+struct codec {
+    std::string name;
+    // true if `data`, the first bytes of a stream, look like this format
+    std::function<bool(std::span<const uint8_t> data)> detect;
+    // the source has to outlive the decoder
+    std::function<std::unique_ptr<decoder_if>(uint8_t* source, size_t source_length)> make_decoder;
+    std::function<std::unique_ptr<encoder_if>()> make_encoder;
+    // worst case encoder output for `source_length` bytes
+    std::function<size_t(size_t source_length)> compress_bound;
+};
+
+// Codecs by name and by the magic bytes of their streams, so that the choice between ratio and
+// speed is data rather than code.
+class codec_registry {
+    std::vector<codec> codecs;
+public:
+    codec_registry() = default;
+
+    // "lz", "gzip", "zlib" and "deflate"; raw deflate has no magic bytes and is detected last.
+    // The deflate formats encode with `deflate::stream_encoder`, a caller after the best ratio
+    // registers a codec of the same name making `deflate::optimal_encoder`s.
+    static codec_registry with_builtin();
+
+    // Codecs added later are tried first by `detect`, so a permissive one should be added early.
+    // A codec with the name of a registered one replaces it.
+    void add(codec c);
+
+    const codec* find(std::string_view name) const;
+    // the codec whose `detect` accepts `data` first, nullptr if none does
+    const codec* detect(std::span<const uint8_t> data) const;
+    // decoder for a stream of any registered format, nullptr if it is not recognised
+    std::unique_ptr<decoder_if> open(uint8_t* source, size_t source_length) const;
+
+    std::span<const codec> all() const { return codecs; }
+};
+
+} // namespace zipper
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef COMPRESSION_STREAMBUF_HPP
+#define COMPRESSION_STREAMBUF_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include "buffer_ring.hpp"
+#include "deflate/stream_decoder.hpp"
+#include "deflate/stream_encoder.hpp"
+
+namespace zipper {
+
+enum class stream_format { deflate, zlib, gzip };
+
+struct streambuf_options {
+    stream_format format = stream_format::gzip;
+    // size and number of the buffers between the worker thread and the stream
+    size_t buffer_size = 64 * 1024;
+    size_t buffers = 4;
+    // compression only
+    deflate::stream_options deflate{};
+};
+
+// Input stream buffer over compressed data. A worker thread reads `source` and decompresses
+// ahead of the reader into a ring of buffers, so parsing and inflating overlap. Multi-member
+// gzip is read as one stream; zlib streams with a preset dictionary are refused.
+// The stream ends early on corrupt data, `error` tells it apart from a normal end.
+class decompress_streambuf : public std::streambuf {
+    std::istream& source;
+    streambuf_options options;
+    buffer_ring ring;
+    deflate::stream_decoder decoder;
+    std::atomic<const char*> failure{nullptr};
+    std::atomic<int64_t> busy_ns{0};
+    std::thread worker;
+
+    void run();
+protected:
+    int_type underflow() override;
+public:
+    // `compressed` is only read by the worker thread and has to outlive the stream buffer
+    explicit decompress_streambuf(std::istream& compressed, streambuf_options opts = streambuf_options{});
+    // stops the worker, which may first have to finish a pending read of the source
+    ~decompress_streambuf() override;
+    decompress_streambuf(const decompress_streambuf&) = delete;
+    decompress_streambuf& operator=(const decompress_streambuf&) = delete;
+
+    // why the data ended before the end of the compressed stream, nullptr if it did not
+    const char* error() const { return failure.load(); }
+    // time the worker has spent inflating so far, without reading the source and waiting for the reader
+    std::chrono::nanoseconds decode_time() const { return std::chrono::nanoseconds(busy_ns.load()); }
+};
+
+// Output stream buffer compressing into `sink` on a worker thread with `deflate::stream_encoder`.
+// `pubsync` (std::flush) waits until everything written so far is compressed, ends the output on
+// a byte boundary with a sync flush and flushes `sink`. `close`, or the destructor, ends the stream.
+class compress_streambuf : public std::streambuf {
+    std::ostream& sink;
+    streambuf_options options;
+    buffer_ring ring;
+    deflate::stream_encoder encoder;
+    std::atomic<bool> failed{false};
+    bool closed = false;
+    std::thread worker;
+
+    void run();
+    bool write(const uint8_t* data, size_t length, deflate::flush_mode flush, std::vector<uint8_t>& out);
+    bool next_buffer();
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+public:
+    // `compressed` is only written by the worker thread and has to outlive the stream buffer
+    explicit compress_streambuf(std::ostream& compressed, streambuf_options opts = streambuf_options{});
+    ~compress_streambuf() override;
+    compress_streambuf(const compress_streambuf&) = delete;
+    compress_streambuf& operator=(const compress_streambuf&) = delete;
+
+    // writes the rest and the trailer, false if writing to the sink failed at any point
+    bool close();
+};
+
+}
+
+#endif
@@ -22,6 +22,7 @@ using std::expected;
 using decode_result = expected<decode_success, decode_failure>;
 class decoder_if {
 public:
+    virtual ~decoder_if() = default;
     virtual decode_result decode(uint8_t* target, size_t target_length) = 0;
 };
 
@@ -0,0 +1,119 @@
+#ifndef DEFLATE_BLOCK_WRITER_HPP
+#define DEFLATE_BLOCK_WRITER_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include "bit_buffer.hpp"
+#include "bit_writer.hpp"
+#include "encoder_if.hpp"
+#include "decoder.hpp"
+#include "huffman_encoding.hpp"
+#include "lz77.hpp"
+
+namespace zipper::deflate
+{
+
+using std::unexpected;
+
+constexpr uint32_t MAX_STORED_BLOCK = 65535;
+
+struct block_statistics {
+    std::array<uint32_t, LITLEN_CODES> litlen{};
+    std::array<uint32_t, DISTANCE_CODES> distance{};
+
+    void add(const lz77_symbol& symbol) {
+        if (symbol.is_literal()) {
+            litlen[symbol.value]++;
+        } else {
+            litlen[length_symbol(symbol.length)]++;
+            distance[distance_symbol(symbol.value)]++;
+        }
+    }
+
+    // counts `symbols` plus the end of block code
+    static block_statistics from_symbols(std::span<const lz77_symbol> symbols) {
+        block_statistics result;
+        for (const auto& s : symbols) {
+            result.add(s);
+        }
+        result.litlen[END_OF_BLOCK]++;
+        return result;
+    }
+};
+
+// Code lengths of a dynamic block and their run-length encoded representation.
+struct dynamic_header {
+    huffman_code<LITLEN_CODES> litlen;
+    huffman_code<DISTANCE_CODES> distance;
+    huffman_code<CL_CODES> codelen;
+    uint32_t hlit;
+    uint32_t hdist;
+    uint32_t hclen;
+    // code length symbol in the low byte, value of its extra bits in the high byte
+    std::array<uint16_t, LITLEN_CODES + DISTANCE_CODES> rle;
+    uint32_t rle_length;
+    size_t header_bits;
+
+    static dynamic_header build(const block_statistics& stats);
+};
+
+class block_writer {
+    bit_buffer& buffer;
+
+    static const huffman_code<LITLEN_CODES> static_litlen;
+    static const huffman_code<DISTANCE_CODES> static_distance;
+
+    template<size_t n_codes>
+    static size_t symbols_cost(const block_statistics& stats, const huffman_code<n_codes>& litlen, const huffman_code<DISTANCE_CODES>& distance);
+
+    template<size_t n_codes>
+    static void write_symbols(bit_writer& out, std::span<const lz77_symbol> symbols, const huffman_code<n_codes>& litlen, const huffman_code<DISTANCE_CODES>& distance);
+    template<size_t n_codes>
+    static void write_literals(bit_writer& out, const uint8_t* data, size_t length, const huffman_code<n_codes>& litlen);
+    static void write_dynamic_header(bit_writer& out, const dynamic_header& header, bool final);
+
+    // the fast writer continuing at the current position, the caller has checked the space
+    bit_writer writer() const { return bit_writer(buffer.data(), buffer.size(), buffer.offset()); }
+    void finish(bit_writer& out) {
+        out.finish();
+        buffer.seek(out.offset());
+    }
+
+    encode_result no_space() const {
+        return unexpected(encode_failure{buffer.byte_offset(), "Target buffer is too small"});
+    }
+
+    encode_result written(size_t bytes_read) const {
+        return encode_success{bytes_read, (buffer.offset() + 7) / 8};
+    }
+public:
+    explicit block_writer(bit_buffer& b) : buffer(b) {}
+
+    // costs in bits, including the 3-bit block header
+    static size_t stored_cost(size_t length, size_t bit_offset);
+    static size_t static_cost(const block_statistics& stats);
+    static size_t dynamic_cost(const block_statistics& stats, const dynamic_header& header);
+    static size_t dynamic_cost(const block_statistics& stats) { return dynamic_cost(stats, dynamic_header::build(stats)); }
+    // cheapest of the three block types when written at `bit_offset`
+    static size_t best_cost(const block_statistics& stats, size_t length, size_t bit_offset);
+
+    encode_result write_stored(const uint8_t* data, size_t length, bool final);
+    encode_result write_static(std::span<const lz77_symbol> symbols, bool final);
+    encode_result write_dynamic(std::span<const lz77_symbol> symbols, const dynamic_header& header, bool final);
+
+    // Writes `symbols` (which decode to `data[0..length)`) using the cheapest block type.
+    encode_result write_block(std::span<const lz77_symbol> symbols, const uint8_t* data, size_t length, bool final);
+    // As write_block but choosing only between static and stored, no dynamic code is built.
+    encode_result write_fixed_block(std::span<const lz77_symbol> symbols, const uint8_t* data, size_t length, bool final);
+    // Writes `data` as literals only, in the cheapest block type. The statistics come from a byte
+    // histogram, so no symbols are needed.
+    encode_result write_literal_block(const uint8_t* data, size_t length, bool final);
+
+    // Pads the stream with zero bits up to the next byte boundary.
+    void align() { buffer.write_bits(0u, (8 - buffer.offset() % 8) % 8); }
+};
+
+} // namespace zipper::deflate
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef DEFLATE_BT_MATCH_FINDER_HPP
+#define DEFLATE_BT_MATCH_FINDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "dictionary.hpp"
+#include "lz77.hpp"
+
+namespace zipper::deflate
+{
+
+// Binary-tree match finder: every position of the window is a node of a binary search tree
+// ordered by the bytes that follow it, which yields the closest match of every length.
+class bt_match_finder {
+    // positions are absolute offsets into the source, which may be longer than 4 GiB
+    static constexpr size_t NIL = SIZE_MAX;
+    static constexpr uint32_t HASH_BITS = 16;
+
+    const uint8_t* data;
+    size_t length;
+    uint32_t max_depth;
+    const dictionary* dict;
+    std::vector<size_t> head;
+    std::vector<size_t> tree; // two children per window slot
+
+    size_t advance(size_t pos, match* matches, bool collect);
+public:
+    // `preset`, when given, is searched for matches reaching before the start of `source`
+    bt_match_finder(const uint8_t* source, size_t source_length, uint32_t depth = 64, const dictionary* preset = nullptr);
+
+    // Finds matches at `pos` ordered by increasing length and decreasing closeness,
+    // then inserts `pos` into the tree. Positions have to be visited in order.
+    size_t find_matches(size_t pos, match* matches) { return advance(pos, matches, true); }
+
+    // Inserts `pos` into the tree without reporting matches.
+    void skip(size_t pos) { advance(pos, nullptr, false); }
+
+    // candidates visited per position from now on
+    void set_depth(uint32_t depth) { max_depth = depth; }
+};
+
+} // namespace zipper::deflate
+
+#endif
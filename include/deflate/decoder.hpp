@@ -5,11 +5,11 @@
 #include "bit_buffer.hpp"
 #include "code_lendist_table.hpp"
 #include "decoder_if.hpp"
+#include "dictionary.hpp"
 #include "huffman_tree.hpp"
 #include "huffman_dfa.hpp"
 
-
-#include <functional>
+#include <optional>
 
 namespace zipper::deflate
 {
@@ -27,7 +27,7 @@ constexpr uint32_t CL_CODES = 19;
 constexpr uint32_t DISTANCE_CODES = 32;
 constexpr uint32_t LITLEN_CODES = 288;
 
-class decoder: decoder_if {
+class decoder : public decoder_if {
     
     static huffman_tree<LITLEN_CODES> build_static_huffman_tree();
 
@@ -39,15 +39,52 @@ class decoder: decoder_if {
     };
     
 
+    // between blocks, inside a static or dynamic Huffman block, or stopped
+    enum class block_state { header, huffman, done };
+
     bit_buffer read_buffer;
+    const dictionary* dict = nullptr;
+    uint8_t* output_begin = nullptr;
+    size_t output_length = 0;
+    size_t output_idx = 0;
+    size_t block_number = 0;
+    block_state state = block_state::done;
+    bool last_block = false;
+    bool dynamic_block = false;
+    dynamic_block_trees trees;
+    std::optional<decode_failure> failure;
+    bool finished = false;
+    bool output_truncated = false;
+
+    decode_result decode_block_header();
+    void end_block();
 
 public:
+    static const huffman_tree<LITLEN_CODES>& static_litlen_tree() { return static_huffman_tree; }
+
     decoder(uint8_t* source, size_t source_length, size_t start_bit_offset = 0): read_buffer(source, source_length, start_bit_offset) {}
+    // back-references may reach before the start of the target into `preset`, which has to outlive the decoder
+    decoder(uint8_t* source, size_t source_length, const dictionary& preset, size_t start_bit_offset = 0)
+        : read_buffer(source, source_length, start_bit_offset), dict(&preset) {}
 
+    // Decodes as much as fits into the target; see `stream_end` and `truncated` for why it stopped.
     decode_result decode(uint8_t* target, size_t target_length) override;
 
+    // `decode` in steps, so that several streams can take turns on one thread: `start` sets the
+    // target, each `step` reads a block header, a stored block or up to `symbols` Huffman symbols
+    // and returns false once decoding has stopped. `progress` is then what `decode` returns.
+    void start(uint8_t* target, size_t target_length);
+    bool step(size_t symbols);
+    decode_result progress() const;
+
+    // the last block was decoded completely, `bits_read` of the result is the end of the stream
+    bool stream_end() const { return finished; }
+    // decoding stopped because the target was full
+    bool truncated() const { return output_truncated; }
+
     decode_result decode_no_compress(uint8_t* target, size_t length);
-    decode_result decode_with_huffman(uint8_t* target, size_t length, const huffman_tree<LITLEN_CODES>& tree, std::function<decode_result(uint32_t&)> dist_decode);
+    // decodes up to `symbols` symbols of the current Huffman block
+    decode_result decode_symbols(size_t symbols);
     decode_result decode_static_huffman_distance(uint32_t& dist_code);
     decode_result decode_dynamic_huffman_distance_prototype(uint32_t& dist_code, const huffman_tree<DISTANCE_CODES>& tree);
     decode_result decode_dynamic_huffman_header(dynamic_block_trees& trees);
@@ -66,24 +103,22 @@ public:
             return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Error during decoding using huffman compression: Unknown symbol"});
         }
 
-        if (read_buffer.eob()) {
+        if (!dfa.accepted() && read_buffer.eob()) {
             return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Unexpected end of buffer."});
         }
 
-        if (!dfa.accepted()) {
-            return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Incorrect value parsed from buffer"});
-        }
         // dfa accepted
         result = dfa.value();
 
         return decode_success{0, n};
     }
     
+    // Reads `hcodes` code lengths; runs of repeated lengths may continue from one table into the next,
+    // so literal/length and distance lengths are read as a single sequence.
     template<size_t n_codes>
-    decode_result decode_tree_with_codelens(const huffman_tree<CL_CODES>& tree, uint32_t hcodes, huffman_tree<n_codes>& result) {
+    decode_result decode_codelens(const huffman_tree<CL_CODES>& tree, uint32_t hcodes, std::array<uint32_t, n_codes>& lengths) {
         huffman_dfa<CL_CODES> dfa(tree);
 
-        std::array<uint32_t, n_codes> lengths;
         lengths.fill(0);
         size_t n = 0;
         
@@ -111,6 +146,9 @@ public:
             }
 
             repeats += base_value;
+            if (i + repeats > hcodes || (value == 16 && i == 0)) {
+                return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Invalid repeat of code length"});
+            }
             uint32_t length_to_repeat = value == 16 ? lengths[i - 1] : 0;
             for(size_t j = 0; j < repeats; j++) {
                 lengths[i + j] = length_to_repeat;
@@ -118,7 +156,6 @@ public:
             i += repeats;
         }
 
-        huffman_tree<n_codes>::from_lengths(result, lengths);
         return decode_success{0, n};
     }
 };
@@ -0,0 +1,41 @@
+#ifndef DEFLATE_DICTIONARY_HPP
+#define DEFLATE_DICTIONARY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "lz77.hpp"
+
+namespace zipper::deflate
+{
+
+// Preset dictionary: history which back-references of a message may reach before its first byte.
+// The hash chains over the dictionary are built once by the constructor, afterwards the object is
+// immutable and can be shared by any number of encoders and decoders across threads.
+class dictionary {
+    static constexpr uint32_t HASH_BITS = 15;
+    static constexpr uint16_t NIL = 0xFFFF;
+
+    std::vector<uint8_t> bytes;
+    std::vector<uint16_t> head;
+    std::vector<uint16_t> prev;
+    uint32_t id;
+public:
+    // only the last WINDOW_SIZE bytes of `source` are reachable and kept
+    dictionary(const uint8_t* source, size_t source_length);
+
+    const uint8_t* data() const { return bytes.data(); }
+    size_t size() const { return bytes.size(); }
+    // Adler-32 of the whole `source`, the DICTID of the zlib container
+    uint32_t adler32() const { return id; }
+
+    // Writes to `matches` the matches for `message + pos` found in the dictionary which are longer
+    // than `longer_than` and not farther than `max_distance`, ordered by increasing length.
+    // A match may run past the end of the dictionary into the message. Returns the number of matches.
+    size_t find_matches(const uint8_t* message, size_t message_length, size_t pos, uint32_t longer_than,
+                        uint32_t max_chain, uint32_t max_distance, match* matches) const;
+};
+
+} // namespace zipper::deflate
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef DEFLATE_HUFFMAN_ENCODING_HPP
+#define DEFLATE_HUFFMAN_ENCODING_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace zipper::deflate
+{
+
+// Computes length-limited Huffman code lengths for `frequencies`.
+// Symbols with zero frequency get length 0. Alphabets of up to LITLEN_CODES symbols.
+void build_code_lengths(std::span<const uint32_t> frequencies, std::span<uint8_t> lengths, uint32_t max_bits);
+
+// Computes canonical codes for `lengths`, bit-reversed so that they can be written LSB-first.
+void build_codes(std::span<const uint8_t> lengths, std::span<uint16_t> codes);
+
+template<size_t n_codes>
+struct huffman_code {
+    std::array<uint16_t, n_codes> codes;
+    std::array<uint8_t, n_codes> lengths;
+
+    static huffman_code from_lengths(const std::array<uint8_t, n_codes>& lengths) {
+        huffman_code result;
+        result.lengths = lengths;
+        build_codes(result.lengths, result.codes);
+        return result;
+    }
+
+    static huffman_code from_frequencies(const std::array<uint32_t, n_codes>& frequencies, uint32_t max_bits) {
+        huffman_code result;
+        build_code_lengths(frequencies, result.lengths, max_bits);
+        build_codes(result.lengths, result.codes);
+        return result;
+    }
+};
+
+} // namespace zipper::deflate
+
+#endif
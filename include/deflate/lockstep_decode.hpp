@@ -0,0 +1,30 @@
+#ifndef DEFLATE_LOCKSTEP_DECODE_HPP
+#define DEFLATE_LOCKSTEP_DECODE_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "decoder_if.hpp"
+
+namespace zipper::deflate
+{
+
+// One raw DEFLATE stream and the buffer it is decoded into.
+struct stream_job {
+    uint8_t* source;
+    size_t source_length;
+    uint8_t* target;
+    size_t target_length;
+};
+
+constexpr size_t MAX_LOCKSTEP_LANES = 4;
+
+// Decodes independent raw DEFLATE streams on the calling thread with `lanes` `decoder`s, 1 to
+// MAX_LOCKSTEP_LANES, which take turns one symbol at a time, so that the dependent lookups of one
+// stream can overlap with those of the others. A lane whose stream has stopped takes the next job.
+// One result per job, in the same order, as `decoder::decode` would give it.
+std::vector<decode_result> decode_lockstep(std::span<const stream_job> jobs, size_t lanes = MAX_LOCKSTEP_LANES);
+
+} // namespace zipper::deflate
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef DEFLATE_LZ77_HPP
+#define DEFLATE_LZ77_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "code_lendist_table.hpp"
+
+namespace zipper::deflate
+{
+
+constexpr uint32_t MIN_MATCH = 3;
+constexpr uint32_t MAX_MATCH = 258;
+constexpr uint32_t WINDOW_SIZE = 32768;
+constexpr uint32_t END_OF_BLOCK = 256;
+
+// Output of the dictionary coder: a literal byte when `length` is 0,
+// otherwise a back-reference of `length` bytes at distance `value`.
+struct lz77_symbol {
+    uint16_t length;
+    uint16_t value;
+
+    static constexpr lz77_symbol literal(uint8_t byte) { return lz77_symbol{0, byte}; }
+    static constexpr lz77_symbol match(uint32_t length, uint32_t distance) {
+        return lz77_symbol{static_cast<uint16_t>(length), static_cast<uint16_t>(distance)};
+    }
+
+    bool is_literal() const { return length == 0; }
+};
+
+struct match {
+    uint16_t length;
+    uint16_t distance;
+};
+
+// index into `code_lengths_table` for every match length in [MIN_MATCH, MAX_MATCH]
+constexpr std::array<uint8_t, MAX_MATCH + 1> length_index_table = [] {
+    std::array<uint8_t, MAX_MATCH + 1> result{};
+    for (uint8_t idx = 0; idx < 29; idx++) {
+        const uint32_t first = code_lengths_table[idx].base_value;
+        const uint32_t last = idx == 28 ? MAX_MATCH : first + (1u << code_lengths_table[idx].extra_bits) - 1;
+        for (uint32_t len = first; len <= last && len <= MAX_MATCH; len++) {
+            result[len] = idx;
+        }
+    }
+    // 258 has its own code, it must not be encoded as 284 with all extra bits set
+    result[MAX_MATCH] = 28;
+    return result;
+}();
+
+// distance code for distances 1..256 and for (distance - 1) >> 7 of larger ones
+constexpr std::array<uint8_t, 512> distance_code_table = [] {
+    std::array<uint8_t, 512> result{};
+    for (uint8_t code = 0; code < 30; code++) {
+        const uint32_t first = code_dist_table[code].base_value;
+        const uint32_t last = first + (1u << code_dist_table[code].extra_bits) - 1;
+        for (uint32_t dist = first; dist <= last; dist++) {
+            if (dist <= 256) {
+                result[dist - 1] = code;
+            } else {
+                result[256 + ((dist - 1) >> 7)] = code;
+            }
+        }
+    }
+    return result;
+}();
+
+inline uint32_t length_symbol(uint32_t length) { return 257 + length_index_table[length]; }
+
+inline uint32_t distance_symbol(uint32_t distance) {
+    return distance <= 256 ? distance_code_table[distance - 1] : distance_code_table[256 + ((distance - 1) >> 7)];
+}
+
+inline uint32_t length_extra_bits(uint32_t length) { return code_lengths_table[length_index_table[length]].extra_bits; }
+inline uint32_t distance_extra_bits(uint32_t distance) { return code_dist_table[distance_symbol(distance)].extra_bits; }
+
+inline uint32_t hash3(const uint8_t* p, uint32_t bits) {
+    const uint32_t v = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16);
+    return (v * 0x9E3779B1u) >> (32 - bits);
+}
+
+} // namespace zipper::deflate
+
+#endif
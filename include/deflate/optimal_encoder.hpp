@@ -0,0 +1,50 @@
+#ifndef DEFLATE_OPTIMAL_ENCODER_HPP
+#define DEFLATE_OPTIMAL_ENCODER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include "encoder_if.hpp"
+#include "dictionary.hpp"
+
+namespace zipper::deflate
+{
+
+struct optimal_options {
+    // passes of cost-model refinement, both over the whole input and per block
+    uint32_t iterations = 15;
+    // wall-clock budget of one encode call, zero means unlimited; when it runs out
+    // the encoder keeps the best parse found so far and searches the rest of the
+    // input for matches with a depth of 4
+    std::chrono::milliseconds time_budget{0};
+    // upper bound of blocks created by splitting one master block
+    uint32_t max_blocks = 15;
+    // how many candidates the binary-tree match finder visits per position
+    uint32_t search_depth = 64;
+    // input is parsed in master blocks of this size to bound the match cache
+    size_t master_block_size = 1 << 20;
+    // false leaves the stream open: no block is marked final and the output ends on a byte
+    // boundary with an empty stored block, so that more DEFLATE data can be appended to it
+    bool last = true;
+};
+
+// Worst case size of raw DEFLATE output for `source_length` bytes of input.
+size_t compress_bound(size_t source_length);
+
+// High-ratio encoder producing raw DEFLATE: binary-tree match finding, iterative
+// cost-model optimal parsing and cost-driven block splitting with per-block
+// choice between stored, static and dynamic blocks.
+class optimal_encoder : public encoder_if {
+    optimal_options options;
+    std::shared_ptr<const dictionary> dict;
+public:
+    // with `dictionary` the output has to be decoded with the same dictionary
+    explicit optimal_encoder(optimal_options opts = optimal_options{}, std::shared_ptr<const dictionary> dictionary = nullptr)
+        : options(opts), dict(std::move(dictionary)) {}
+
+    encode_result encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) override;
+};
+
+} // namespace zipper::deflate
+
+#endif
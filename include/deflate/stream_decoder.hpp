@@ -0,0 +1,99 @@
+#ifndef DEFLATE_STREAM_DECODER_HPP
+#define DEFLATE_STREAM_DECODER_HPP
+
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <vector>
+#include "bit_buffer.hpp"
+#include "decoder.hpp"
+#include "dictionary.hpp"
+#include "huffman_tree.hpp"
+#include "mirrored_buffer.hpp"
+
+namespace zipper::deflate
+{
+
+enum class stream_status {
+    need_input,  // all input was consumed, feed more
+    need_output, // the target is full, call again with more space
+    done         // the last block was decoded
+};
+
+using stream_result = expected<stream_status, decode_failure>;
+
+// Resumable DEFLATE decoder for data which arrives and leaves in pieces. Input given to `feed`
+// is buffered until it is consumed, the last WINDOW_SIZE bytes of output are kept as history,
+// so neither input nor target buffers have to outlive a call.
+class stream_decoder {
+    enum class state {
+        block_header,
+        stored_header,
+        stored_data,
+        huffman_symbols,
+        done
+    };
+
+    std::vector<uint8_t> input;
+    size_t input_bit = 0;
+    size_t consumed = 0;
+
+    // output history; twice the window so a match copy never has to wrap, and bytes written a
+    // few past its end land on history which is out of reach anyway
+    static constexpr size_t RING_SIZE = 2 * WINDOW_SIZE;
+    mirrored_buffer window;
+    size_t produced = 0;
+    const dictionary* dict;
+
+    state current = state::block_header;
+    bool last_block = false;
+    size_t block_number = 0;
+    uint32_t stored_left = 0;
+    bool static_block = false;
+    huffman_tree<LITLEN_CODES> litlen_tree;
+    huffman_tree<DISTANCE_CODES> distance_tree;
+    uint32_t pending_length = 0;
+    uint32_t pending_distance = 0;
+
+    enum class step { ok, incomplete, invalid };
+
+    template<size_t n_codes>
+    static step read_symbol(bit_buffer& in, const huffman_tree<n_codes>& tree, uint32_t& value);
+    step read_dynamic_header(bit_buffer& in, const char*& message);
+
+    void emit(uint8_t* target, size_t& written, uint8_t byte) {
+        target[written++] = byte;
+        const size_t pos = produced++ & (RING_SIZE - 1);
+        window.data()[pos] = byte;
+        window.commit(pos, 1);
+    }
+    void copy_match(uint8_t* target, size_t target_length, size_t& written);
+
+    decode_failure failure(const bit_buffer& in, const char* message) const {
+        return decode_failure{consumed + in.byte_offset(), consumed * 8 + in.offset(), block_number, message};
+    }
+public:
+    // back-references may reach before the first output byte into `preset`, which has to outlive the decoder
+    explicit stream_decoder(const dictionary* preset = nullptr);
+
+    // Appends `length` bytes to the buffered input.
+    void feed(const uint8_t* data, size_t length);
+
+    // Decodes into `target` until input runs out, the target is full or the stream ends.
+    // `written` receives the number of bytes stored in `target`.
+    stream_result decode(uint8_t* target, size_t target_length, size_t& written);
+
+    bool finished() const { return current == state::done; }
+    // bytes of input consumed, including the partially used last one
+    size_t total_in() const { return consumed + (input_bit + 7) / 8; }
+    size_t total_out() const { return produced; }
+    // fed input following the end of the stream, e.g. a container trailer
+    std::span<const uint8_t> unused_input() const;
+
+    // prepares the decoder for a new stream with the same dictionary
+    void reset();
+};
+
+} // namespace zipper::deflate
+
+#endif
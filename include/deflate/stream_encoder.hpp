@@ -0,0 +1,132 @@
+#ifndef DEFLATE_STREAM_ENCODER_HPP
+#define DEFLATE_STREAM_ENCODER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "encoder_if.hpp"
+#include "lz77.hpp"
+
+namespace zipper::deflate
+{
+
+enum class flush_mode {
+    no_flush,   // buffer as much as the compression needs
+    sync_flush, // emit all input followed by an empty stored block, the output ends on a byte boundary
+    full_flush, // as sync_flush, and later data does not refer to anything before the flush point
+    finish      // emit all input and the final block
+};
+
+enum class compression_strategy {
+    lz77,         // greedy matching over hash chains, the cheapest block type
+    huffman_only, // literals only, coded from a byte histogram; for data without repeats
+    rle,          // matches at distance 1 only, no hash chains; for runs such as image rows
+    static_only   // as lz77 but never builds dynamic codes; for small messages
+};
+
+struct stream_options {
+    // history of 2^window_bits bytes, 9..15; the encoder keeps two windows of input
+    uint32_t window_bits = 15;
+    // 1..9, hash table of 2^(memory_level + 7) entries and blocks of up to 2^(memory_level + 6) symbols
+    uint32_t memory_level = 8;
+    // hash chain candidates examined per position
+    uint32_t max_chain = 32;
+    // every strategy falls back to stored blocks where the data does not compress
+    compression_strategy strategy = compression_strategy::lz77;
+    // Cuts the stream at content-defined points, on average every 2^rsync_bits bytes and at most
+    // a window apart, with a full flush, so that equal stretches of input give equal compressed
+    // bytes wherever they occur.
+    bool rsyncable = false;
+    // 8..window_bits - 2, a window holds about four cut points at the most
+    uint32_t rsync_bits = 12;
+};
+
+// Worst case size of the raw DEFLATE stream `stream_encoder` makes from `source_length` bytes in
+// one go. It depends on the options: every block may fall back to stored blocks of its own, and
+// smaller blocks and windows end blocks more often.
+size_t compress_bound(size_t source_length, const stream_options& options);
+
+// Raw DEFLATE encoder for data which arrives and leaves in pieces, with a fixed memory footprint
+// set by `stream_options`. Matching follows the chosen strategy. Output which does not fit the
+// target is kept until the next call, so a flush is complete once `pending()` is zero.
+class stream_encoder : public encoder_if {
+    uint32_t window_size;
+    uint32_t max_distance;
+    uint32_t hash_bits;
+    uint32_t max_chain;
+    size_t block_symbols;
+    compression_strategy strategy;
+    // only lz77 and static_only keep the hash chains up to date
+    bool hashing;
+    bool rsyncable;
+    uint64_t rsync_mask;
+    size_t rsync_min;
+    size_t rsync_max;
+
+    // positions are window indices, 0 doubles as the empty chain so position 0 is never matched
+    std::vector<uint8_t> window;
+    std::vector<uint16_t> head;
+    std::vector<uint16_t> prev;
+    size_t strstart = 0;
+    size_t lookahead = 0;
+    size_t block_start = 0;
+    // first position whose preceding bytes may be referenced, moved by a full flush
+    size_t history_start = 0;
+    std::vector<lz77_symbol> symbols;
+
+    // rolling hash over the input up to window index `scanned`; the parse stops at `boundary`
+    static constexpr size_t NO_BOUNDARY = SIZE_MAX;
+    uint64_t rolling = 0;
+    size_t scanned = 0;
+    size_t since_boundary = 0;
+    size_t boundary = NO_BOUNDARY;
+
+    std::vector<uint8_t> pending_output;
+    size_t pending_bits = 0;
+    size_t pending_offset = 0;
+
+    size_t consumed = 0;
+    size_t produced = 0;
+    bool dirty = false;
+    bool done = false;
+
+    uint32_t insert(size_t pos);
+    match longest_match(size_t pos, uint32_t candidate, uint32_t limit) const;
+    match run_match(size_t pos, uint32_t limit) const;
+    bool block_full() const {
+        // a literal-only block keeps no symbols, its length counts instead
+        return strategy == compression_strategy::huffman_only ? strstart - block_start >= block_symbols : symbols.size() == block_symbols;
+    }
+    void find_boundary();
+    void compress(bool flushing);
+    void slide();
+    size_t fill_window(const uint8_t* source, size_t length);
+    void emit_block(bool final);
+    void emit_flush(flush_mode flush);
+    size_t drain(uint8_t* target, size_t length);
+public:
+    explicit stream_encoder(stream_options options = stream_options{});
+
+    // Consumes input from `source` and writes compressed data to `target` until the input is used
+    // up or the target is full. With a flush mode other than no_flush all input is compressed and
+    // the flush completes once `pending()` is zero; call again with no input and the same mode to
+    // get the rest. Once a finish is complete the encoder only accepts `reset`.
+    encode_result encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length, flush_mode flush);
+    // Compresses `source` as a stream of its own, starting with `reset`; fails if the whole
+    // stream does not fit the target. `compress_bound` with this encoder's options is always enough.
+    encode_result encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) override;
+
+    // compressed bytes waiting for target space
+    size_t pending() const { return pending_bits / 8 - pending_offset; }
+    bool finished() const { return done; }
+    size_t total_in() const { return consumed; }
+    size_t total_out() const { return produced; }
+    // bytes allocated for the stream state
+    size_t memory_usage() const;
+
+    // prepares the encoder for a new stream, keeping its buffers
+    void reset();
+};
+
+} // namespace zipper::deflate
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef ENCODER_HPP
+#define ENCODER_HPP
+
+#include <expected>
+#include <stddef.h>
+#include <cstdint>
+
+namespace zipper {
+
+struct encode_failure {
+    size_t byte_offset;
+    const char* message;
+};
+
+struct encode_success {
+    size_t bytes_read;
+    size_t bytes_written;
+};
+
+using std::expected;
+using encode_result = expected<encode_success, encode_failure>;
+class encoder_if {
+public:
+    virtual ~encoder_if() = default;
+    virtual encode_result encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef GZIP_BGZF_HPP
+#define GZIP_BGZF_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace zipper::gzip
+{
+
+// Blocked gzip as in the SAM/BAM specification: a file of independent gzip members, each with
+// an extra subfield "BC" holding the size of the member minus one, so that members can be
+// found without decoding. Ordinary gzip readers see a multi-member file.
+constexpr size_t BGZF_MAX_BLOCK_SIZE = 65536;
+// uncompressed bytes per block, small enough that a stored block still fits BGZF_MAX_BLOCK_SIZE
+constexpr size_t BGZF_BLOCK_DATA = 65280;
+constexpr size_t BGZF_HEADER_SIZE = 18;
+constexpr size_t BGZF_TRAILER_SIZE = 8;
+
+// empty block closing every file, readers use it to tell a complete file from a truncated one
+constexpr std::array<uint8_t, 28> BGZF_EOF = {
+    0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+    0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+struct bgzf_failure {
+    // position in the compressed file
+    uint64_t offset;
+    const char* message;
+};
+
+struct bgzf_block {
+    uint64_t compressed_offset;
+    uint64_t uncompressed_offset;
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+};
+
+// Virtual offsets address a byte as the file offset of its block and the position inside the
+// block's uncompressed data, so a reader can seek with a single block decode.
+inline uint64_t make_virtual_offset(uint64_t block_offset, uint32_t within_block) {
+    return (block_offset << 16) | within_block;
+}
+inline uint64_t block_offset(uint64_t virtual_offset) { return virtual_offset >> 16; }
+inline uint32_t within_block(uint64_t virtual_offset) { return virtual_offset & 0xFFFF; }
+
+} // namespace zipper::gzip
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef GZIP_BGZF_READER_HPP
+#define GZIP_BGZF_READER_HPP
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <vector>
+#include "gzip/bgzf.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+namespace zipper::gzip
+{
+
+// BGZF file read through a memory mapping. The block list comes from the block headers, or from
+// a bgzip index, without decoding anything; blocks are then decoded independently.
+class bgzf_reader {
+    mapped_file file;
+    std::vector<bgzf_block> list;
+    uint64_t total = 0;
+
+    bgzf_reader(mapped_file f, std::vector<bgzf_block> blocks);
+public:
+    // walks the chain of block headers; plain gzip members without the size subfield are refused
+    static std::expected<bgzf_reader, bgzf_failure> open(const std::filesystem::path& path);
+    // takes block boundaries from a ".gzi" index, touching only the last block of the file
+    static std::expected<bgzf_reader, bgzf_failure> open(const std::filesystem::path& path, const std::filesystem::path& index);
+
+    const std::vector<bgzf_block>& blocks() const { return list; }
+    // total uncompressed size
+    uint64_t size() const { return total; }
+
+    // index of the block holding uncompressed byte `offset`, blocks().size() past the end
+    size_t find_block(uint64_t offset) const;
+    uint64_t virtual_offset(uint64_t uncompressed_offset) const;
+    // uncompressed offset of a virtual offset, fails if it does not point into a block
+    std::expected<uint64_t, bgzf_failure> uncompressed_offset(uint64_t virtual_offset) const;
+
+    // decodes block `i` into `target` of at least its uncompressed size and checks its CRC-32
+    std::expected<void, bgzf_failure> read_block(size_t i, uint8_t* target) const;
+
+    // Copies up to `length` bytes starting at `virtual_offset`, decoding only the blocks involved.
+    // Returns the number of bytes copied, less than `length` at the end of the file.
+    std::expected<size_t, bgzf_failure> read(uint64_t virtual_offset, uint8_t* target, size_t length) const;
+
+    // decodes the whole file into `target` of at least size() bytes, runs of blocks in parallel
+    std::expected<void, bgzf_failure> read_all(thread_pool& pool, uint8_t* target, size_t target_length) const;
+};
+
+// (compressed, uncompressed) offsets of every block but the first, as written by `bgzip -i`
+std::expected<std::vector<std::pair<uint64_t, uint64_t>>, bgzf_failure> read_index(const std::filesystem::path& index);
+
+} // namespace zipper::gzip
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef GZIP_BGZF_WRITER_HPP
+#define GZIP_BGZF_WRITER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <vector>
+#include "deflate/optimal_encoder.hpp"
+#include "gzip/bgzf.hpp"
+#include "thread_pool.hpp"
+
+namespace zipper::gzip
+{
+
+struct bgzf_options {
+    deflate::optimal_options deflate{};
+    // uncompressed bytes per block, at most BGZF_BLOCK_DATA
+    size_t block_size = BGZF_BLOCK_DATA;
+    // also writes `path` + ".gzi", the block index format of bgzip
+    bool write_index = false;
+};
+
+// One complete BGZF block (gzip member with the BC subfield) holding `length` <= BGZF_BLOCK_DATA
+// bytes; fails if even the compressed data does not fit into BGZF_MAX_BLOCK_SIZE.
+std::expected<std::vector<uint8_t>, bgzf_failure> bgzf_compress_block(const uint8_t* data, size_t length, const deflate::optimal_options& opts);
+
+// Writes a BGZF file. Every full block is compressed by its own job on the pool, finished blocks
+// are written in order while later ones are still compressed; at most two blocks per worker are
+// held in memory.
+class bgzf_writer {
+    // compressed block, or why it could not be made
+    using block_job = std::future<std::expected<std::vector<uint8_t>, bgzf_failure>>;
+
+    thread_pool& pool;
+    bgzf_options options;
+    std::filesystem::path path;
+    std::ofstream out;
+    std::vector<uint8_t> current;
+    std::deque<std::pair<block_job, uint32_t>> in_flight;
+    std::vector<bgzf_block> written;
+    uint64_t compressed_offset = 0;
+    uint64_t uncompressed_offset = 0;
+
+    bgzf_writer(thread_pool& workers, bgzf_options opts, std::filesystem::path p, std::ofstream o);
+
+    void submit();
+    std::expected<void, bgzf_failure> retire();
+public:
+    static std::expected<bgzf_writer, bgzf_failure> create(thread_pool& workers, const std::filesystem::path& path,
+                                                            bgzf_options opts = bgzf_options{});
+
+    std::expected<void, bgzf_failure> write(const uint8_t* data, size_t length);
+
+    // Ends the current block even if it is not full, e.g. so that a record does not span two
+    // blocks. Does nothing if no data was written since the last block.
+    std::expected<void, bgzf_failure> flush();
+
+    // writes the remaining blocks, the EOF block and the index
+    std::expected<void, bgzf_failure> finish();
+
+    // blocks written so far, without the EOF block
+    const std::vector<bgzf_block>& blocks() const { return written; }
+};
+
+} // namespace zipper::gzip
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef GZIP_DECODER_HPP
+#define GZIP_DECODER_HPP
+
+#include <cstdint>
+#include "decoder_if.hpp"
+
+namespace zipper::gzip
+{
+
+// gzip file (RFC 1952): one or more members, each a header, raw DEFLATE data, CRC-32 and the
+// size of its uncompressed data. The output of all members is concatenated.
+class decoder : public decoder_if {
+    uint8_t* source;
+    size_t source_length;
+public:
+    decoder(uint8_t* source, size_t source_length) : source(source), source_length(source_length) {}
+
+    decode_result decode(uint8_t* target, size_t target_length) override;
+
+    // Size of the member header at the start of `data`, or a failure if it is not a valid one.
+    static expected<size_t, decode_failure> header_size(const uint8_t* data, size_t length);
+};
+
+} // namespace zipper::gzip
+
+#endif
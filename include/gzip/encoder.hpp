@@ -0,0 +1,48 @@
+#ifndef GZIP_ENCODER_HPP
+#define GZIP_ENCODER_HPP
+
+#include <cstdint>
+#include <memory>
+#include "encoder_if.hpp"
+#include "deflate/optimal_encoder.hpp"
+#include "deflate/stream_encoder.hpp"
+
+namespace zipper::gzip
+{
+
+constexpr size_t HEADER_SIZE = 10;
+constexpr size_t TRAILER_SIZE = 8;
+
+constexpr uint8_t ID1 = 0x1F;
+constexpr uint8_t ID2 = 0x8B;
+constexpr uint8_t CM_DEFLATE = 8;
+
+constexpr uint8_t FLAG_TEXT = 0x01;
+constexpr uint8_t FLAG_HCRC = 0x02;
+constexpr uint8_t FLAG_EXTRA = 0x04;
+constexpr uint8_t FLAG_NAME = 0x08;
+constexpr uint8_t FLAG_COMMENT = 0x10;
+
+// Worst case size of a gzip member for `source_length` bytes of input.
+size_t compress_bound(size_t source_length);
+// The same for an encoder made with `options`, see `deflate::compress_bound`.
+size_t compress_bound(size_t source_length, const deflate::stream_options& options);
+
+// Writes one gzip member (RFC 1952) without file name and modification time.
+class encoder : public encoder_if {
+    std::unique_ptr<encoder_if> raw;
+    // XFL of the header, 2 for maximum compression and 4 for the fastest
+    uint8_t extra_flags;
+public:
+    explicit encoder(deflate::optimal_options options = deflate::optimal_options{})
+        : raw(std::make_unique<deflate::optimal_encoder>(options)), extra_flags(2) {}
+    // compresses with the streaming LZ77 encoder, much faster at a lower ratio
+    explicit encoder(deflate::stream_options options)
+        : raw(std::make_unique<deflate::stream_encoder>(options)), extra_flags(4) {}
+
+    encode_result encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) override;
+};
+
+} // namespace zipper::gzip
+
+#endif
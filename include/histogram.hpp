@@ -0,0 +1,15 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace zipper {
+
+// Adds the number of occurrences of every byte value in `data` to `counts`.
+void byte_histogram(const uint8_t* data, size_t length, std::array<uint32_t, 256>& counts);
+
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef LZ_DECODER_HPP
+#define LZ_DECODER_HPP
+
+#include <cstdint>
+#include "decoder_if.hpp"
+
+namespace zipper::lz
+{
+
+class decoder : public decoder_if {
+    const uint8_t* source;
+    size_t source_length;
+public:
+    decoder(const uint8_t* source, size_t source_length) : source(source), source_length(source_length) {}
+
+    // Fails unless the whole uncompressed size stated in the header fits into the target.
+    decode_result decode(uint8_t* target, size_t target_length) override;
+
+    // uncompressed size from the header, 0 if `data` does not start with one
+    static uint64_t content_size(const uint8_t* data, size_t length);
+};
+
+} // namespace zipper::lz
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef LZ_ENCODER_HPP
+#define LZ_ENCODER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "encoder_if.hpp"
+
+namespace zipper::lz
+{
+
+// Worst case size of an lz stream for `source_length` bytes of input.
+size_t compress_bound(size_t source_length);
+
+// Single-probe hash matching over the whole input, for data where decoding speed matters more
+// than ratio. Runs of input without matches are skipped in growing steps.
+class encoder : public encoder_if {
+    std::vector<uint32_t> table;
+public:
+    encoder() = default;
+
+    encode_result encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) override;
+};
+
+} // namespace zipper::lz
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef LZ_FORMAT_HPP
+#define LZ_FORMAT_HPP
+
+#include <cstdint>
+#include <cstring>
+
+namespace zipper::lz
+{
+
+// Byte-oriented LZ77 without an entropy stage, in the spirit of LZ4: a header with the magic
+// bytes and the uncompressed size (LE64), then sequences of
+//   token        literal count in the high nibble, match length - MIN_MATCH in the low one
+//   [lengths]    a nibble of 15 continues in bytes which are added up until one is below 255
+//   literals
+//   offset       LE16, 1..65535 bytes back
+//   [lengths]    continuation of the match length
+// The last sequence has literals only and ends where the uncompressed size is reached.
+constexpr uint8_t MAGIC[4] = {'Z', 'P', 'L', 'Z'};
+constexpr size_t HEADER_SIZE = 12;
+
+constexpr uint32_t MIN_MATCH = 4;
+constexpr uint32_t MAX_OFFSET = 65535;
+constexpr uint32_t RUN_MASK = 15;
+// the encoder ends every stream with this many literals and starts no match closer to its end
+// than MATCH_END_LIMIT, so that the decoder's wide copies rarely have to be bounded
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MATCH_END_LIMIT = 12;
+
+inline uint32_t load32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace zipper::lz
+
+#endif
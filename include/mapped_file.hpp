@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+
+namespace zipper {
+
+// Memory mapping of a whole file, unmapped on destruction.
+class mapped_file {
+    uint8_t* ptr = nullptr;
+    size_t length = 0;
+
+    mapped_file(uint8_t* p, size_t size) : ptr(p), length(size) {}
+public:
+    mapped_file() = default;
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+    ~mapped_file();
+
+    // read-only mapping of an existing file; the error is an errno value
+    static std::expected<mapped_file, int> open(const std::filesystem::path& path);
+    // creates or truncates `path` to `size` bytes and maps it for writing
+    static std::expected<mapped_file, int> create(const std::filesystem::path& path, size_t size);
+
+    uint8_t* data() const { return ptr; }
+    size_t size() const { return length; }
+};
+
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef MIRRORED_BUFFER_HPP
+#define MIRRORED_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace zipper {
+
+// Ring buffer of `size()` bytes whose addresses [size(), 2 * size()) show the same bytes as
+// [0, size()), so a run of up to size() bytes starting anywhere in the first half is read and
+// written linearly, without splitting it at the end of the ring.
+//
+// The mirror maps the pages of one memfd twice, back to back. Where that fails (no memfd, no
+// address space, a size that is not a multiple of the page size) the buffer is plain memory of
+// twice the size and `commit` copies written runs into the other half.
+class mirrored_buffer {
+    uint8_t* base = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::unique_ptr<uint8_t[]> fallback;
+
+    void mirror(size_t pos, size_t n);
+public:
+    // `use_mapping` false always takes the fallback
+    explicit mirrored_buffer(size_t size, bool use_mapping = true);
+    mirrored_buffer(mirrored_buffer&& other) noexcept;
+    mirrored_buffer& operator=(mirrored_buffer&& other) noexcept;
+    ~mirrored_buffer();
+
+    uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+    // both halves are the same memory, `commit` does nothing
+    bool mirrored() const { return mapped; }
+
+    // Makes a run written at data() + pos, pos + n <= 2 * size(), visible through both halves.
+    void commit(size_t pos, size_t n) {
+        if (!mapped) {
+            mirror(pos, n);
+        }
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SERVICE_DECODE_CLIENT_HPP
+#define SERVICE_DECODE_CLIENT_HPP
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include "service/protocol.hpp"
+#include "service/shared_segment.hpp"
+
+namespace zipper::service
+{
+
+struct service_failure {
+    service_error error;
+    // decode_failed: byte offset in the input where decoding stopped
+    uint64_t offset;
+    std::string message;
+};
+
+// Decodes the compressed bytes at [input_offset, +input_length) of an attached segment into
+// [output_offset, +output_capacity) of the same segment.
+struct decode_job {
+    uint32_t segment = 0;
+    stream_format format = stream_format::gzip;
+    size_t input_offset = 0;
+    size_t input_length = 0;
+    size_t output_offset = 0;
+    size_t output_capacity = 0;
+    // raw DEFLATE only, the Adler-32 of a dictionary loaded by the service; zlib streams name theirs
+    std::optional<uint32_t> dictionary{};
+};
+
+// Connection to a `decode_server`. Calls block until the service answers; a client is meant for
+// one thread, a process with several threads opens a connection per thread.
+class decode_client {
+    int fd = -1;
+    uint32_t next_id = 0;
+
+    explicit decode_client(int socket) : fd(socket) {}
+    std::expected<response, service_failure> call(request r, int segment_fd = -1);
+public:
+    decode_client() = default;
+    decode_client(decode_client&& other) noexcept;
+    decode_client& operator=(decode_client&& other) noexcept;
+    ~decode_client();
+
+    // the error is an errno value
+    static std::expected<decode_client, int> connect(const std::filesystem::path& socket_path);
+
+    // Shares `segment` with the service, which maps it until the connection closes. Returns the
+    // number to put in `decode_job::segment`. The segment itself may go away after the call.
+    std::expected<uint32_t, service_failure> attach(const shared_segment& segment);
+    // bytes written to the output range
+    std::expected<size_t, service_failure> decode(const decode_job& job);
+    std::expected<service_stats, service_failure> stats();
+};
+
+} // namespace zipper::service
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef SERVICE_DECODE_SERVER_HPP
+#define SERVICE_DECODE_SERVER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "deflate/dictionary.hpp"
+#include "service/protocol.hpp"
+#include "service/shared_segment.hpp"
+#include "thread_pool.hpp"
+
+namespace zipper::service
+{
+
+struct server_options {
+    // segments a connection may attach
+    size_t max_segments = 64;
+    // decode requests a connection may have queued or running, further ones are refused
+    size_t max_in_flight = 64;
+};
+
+// Local decompression service. Worker processes connect over a Unix domain socket, attach shared
+// memory segments and send decode requests naming ranges in them; the payload is decoded from
+// the segment straight into it on `pool`. The processes share one set of threads, the
+// preset dictionaries with their hash chains and the static Huffman tables, which stay warm
+// while the clients come and go.
+//
+// One thread accepts connections and reads requests; attach and stats requests are answered
+// right away, decode requests once a worker of the pool has run them, so a client may have
+// up to `max_in_flight` of them in flight. Responses are sent without blocking; a client which
+// lets them pile up unread is disconnected.
+class decode_server {
+    struct connection;
+
+    thread_pool& pool;
+    server_options options;
+    std::unordered_map<uint32_t, std::shared_ptr<const deflate::dictionary>> dictionaries;
+
+    std::filesystem::path path;
+    int listen_fd = -1;
+    int wake_fd = -1;
+    std::thread io;
+    std::map<int, std::shared_ptr<connection>> connections;
+
+    std::mutex stats_mutex;
+    std::condition_variable drained;
+    service_stats totals;
+
+    void serve();
+    // false once the connection is closed
+    bool receive(const std::shared_ptr<connection>& c);
+    void attach(connection& c, const request& r, int fd);
+    void submit(const std::shared_ptr<connection>& c, const request& r);
+    response decode(const request& r, const shared_segment& segment) const;
+public:
+    explicit decode_server(thread_pool& workers, server_options opts = server_options{});
+    // stops the service
+    ~decode_server();
+    decode_server(const decode_server&) = delete;
+    decode_server& operator=(const decode_server&) = delete;
+
+    // Makes `dict` available to raw DEFLATE requests by its Adler-32 and to zlib streams with
+    // that DICTID. Only before `start`.
+    void add_dictionary(std::shared_ptr<const deflate::dictionary> dict);
+
+    // Listens on `socket_path`, replacing a stale socket file there. The error is an errno value.
+    std::expected<void, int> start(const std::filesystem::path& socket_path);
+    // Stops accepting requests, waits for the decodes in flight and removes the socket file.
+    void stop();
+
+    service_stats stats();
+};
+
+} // namespace zipper::service
+
+#endif
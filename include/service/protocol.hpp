@@ -0,0 +1,88 @@
+#ifndef SERVICE_PROTOCOL_HPP
+#define SERVICE_PROTOCOL_HPP
+
+#include <array>
+#include <cstdint>
+#include "compression_streambuf.hpp"
+
+namespace zipper::service
+{
+
+// Messages between the decode service and its clients. Both run from the same build on one
+// host, so the structs travel as they are over a SOCK_SEQPACKET socket, one per packet.
+// Payloads never pass the socket: a client attaches shared memory segments once and requests
+// refer to ranges inside them.
+
+// "ZDS" and the protocol revision
+constexpr uint32_t PROTOCOL_MAGIC = 0x5A445301;
+
+enum class request_type : uint32_t {
+    attach = 1, // maps the segment whose descriptor comes with the message
+    decode = 2, // decodes a range of an attached segment into another range of it
+    stats = 3   // reports `service_stats`
+};
+
+enum class service_error : uint32_t {
+    none = 0,
+    bad_request,        // wrong magic, type or format, overlapping ranges
+    bad_segment,        // the descriptor cannot be mapped or is not sealed against shrinking
+    too_many_segments,
+    too_many_requests,  // the connection already has `server_options::max_in_flight` decodes pending
+    unknown_segment,
+    out_of_range,       // a range does not lie inside its segment
+    unknown_dictionary,
+    decode_failed,      // the payload is corrupt or the output range too small, see the message
+    disconnected        // reported by the client when the service goes away
+};
+
+const char* describe(service_error error);
+
+struct request {
+    uint32_t magic = PROTOCOL_MAGIC;
+    request_type type = request_type::decode;
+    uint32_t id = 0;
+    uint32_t segment = 0;
+    stream_format format = stream_format::gzip;
+    // raw DEFLATE only: Adler-32 of a preset dictionary known to the service
+    uint32_t dictionary_id = 0;
+    uint32_t use_dictionary = 0;
+    uint64_t input_offset = 0;
+    uint64_t input_length = 0;
+    uint64_t output_offset = 0;
+    uint64_t output_capacity = 0;
+};
+
+struct service_stats {
+    static constexpr size_t LATENCY_BUCKETS = 24;
+
+    uint64_t connections = 0;
+    uint64_t requests = 0;
+    uint64_t failures = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    // decode requests received and not answered yet, queued or running
+    uint64_t queue_depth = 0;
+    uint64_t max_queue_depth = 0;
+    // from receiving a decode request until its response is ready
+    uint64_t latency_total_ns = 0;
+    uint64_t latency_max_ns = 0;
+    // bucket i counts latencies below 2^i microseconds, the last one also everything slower
+    std::array<uint64_t, LATENCY_BUCKETS> latency_buckets{};
+
+    void add_latency(uint64_t ns);
+    // upper bound in microseconds of the latency of the fastest `fraction` of the requests
+    uint64_t latency_percentile_us(double fraction) const;
+};
+
+struct response {
+    uint32_t id = 0;
+    service_error error = service_error::none;
+    // attach: the segment number; decode: bytes written, or the input offset of a failure
+    uint64_t value = 0;
+    char message[96] = {};
+    service_stats stats;
+};
+
+} // namespace zipper::service
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SERVICE_SHARED_SEGMENT_HPP
+#define SERVICE_SHARED_SEGMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+
+namespace zipper::service
+{
+
+// Anonymous shared memory which a process maps and hands to another one as a descriptor.
+// Segments are sealed against resizing, so the receiver cannot fault on a mapping shrunk
+// behind its back.
+class shared_segment {
+    uint8_t* ptr = nullptr;
+    size_t length = 0;
+    int descriptor = -1;
+
+    shared_segment(uint8_t* p, size_t size, int fd) : ptr(p), length(size), descriptor(fd) {}
+public:
+    shared_segment() = default;
+    shared_segment(shared_segment&& other) noexcept;
+    shared_segment& operator=(shared_segment&& other) noexcept;
+    ~shared_segment();
+
+    // a new segment of `size` bytes; the error is an errno value
+    static std::expected<shared_segment, int> create(size_t size);
+    // maps a segment received from another process and closes `fd`, which is closed on failure as well
+    static std::expected<shared_segment, int> adopt(int fd);
+
+    uint8_t* data() const { return ptr; }
+    size_t size() const { return length; }
+    // -1 for an adopted segment
+    int fd() const { return descriptor; }
+};
+
+} // namespace zipper::service
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace zipper {
+
+// Fixed set of worker threads executing submitted jobs in FIFO order.
+class thread_pool {
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping = false;
+
+    void work();
+public:
+    // zero means one thread per hardware thread
+    explicit thread_pool(size_t threads = 0);
+    // finishes the queued jobs before joining
+    ~thread_pool();
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    size_t size() const { return workers.size(); }
+    size_t queued();
+
+    template<typename F>
+    auto submit(F job) -> std::future<std::invoke_result_t<F>> {
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(job));
+        auto result = task->get_future();
+        {
+            std::lock_guard lock(mutex);
+            jobs.emplace_back([task]() { (*task)(); });
+        }
+        available.notify_one();
+        return result;
+    }
+};
+
+}
+
+#endif
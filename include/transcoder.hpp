@@ -0,0 +1,62 @@
+#ifndef TRANSCODER_HPP
+#define TRANSCODER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <istream>
+#include <ostream>
+#include "compression_streambuf.hpp"
+#include "deflate/optimal_encoder.hpp"
+#include "thread_pool.hpp"
+
+namespace zipper {
+
+struct transcode_options {
+    stream_format from = stream_format::gzip;
+    stream_format to = stream_format::gzip;
+    // with `to` gzip, writes a BGZF file (chunks of at most BGZF_BLOCK_DATA) instead of one member
+    bool bgzf = false;
+    deflate::optimal_options deflate;
+    // uncompressed bytes per encoder job
+    size_t chunk_size = 1 << 20;
+    // chunks being compressed or waiting to be written, zero means two per worker
+    size_t queue_depth = 0;
+};
+
+struct stage_stats {
+    // bytes produced by the stage
+    uint64_t bytes = 0;
+    // time spent working, summed over the threads of the stage
+    std::chrono::nanoseconds busy{0};
+    // time the pipeline waited for the stage
+    std::chrono::nanoseconds stalled{0};
+};
+
+struct transcode_stats {
+    // `stalled` is the wait for decoded data
+    stage_stats decode;
+    // `stalled` is the wait for the oldest chunk when the queue is full, and at the end
+    stage_stats encode;
+    std::chrono::nanoseconds elapsed{0};
+};
+
+struct transcode_failure {
+    // uncompressed bytes read when transcoding stopped
+    uint64_t offset;
+    const char* message;
+};
+
+// Recompresses `in` from one format to another without an intermediate file. A
+// `decompress_streambuf` inflates on its own thread, the calling thread cuts the output into
+// chunks and queues them to `pool`, where each chunk is compressed with
+// `deflate::optimal_encoder` (primed with the last 32 KiB of the chunk before it, so one stream
+// loses little ratio against serial compression), and writes finished chunks in order. At most
+// `queue_depth` chunks are held at once.
+// Whichever stage has the larger `stalled` time in the result is the bottleneck.
+std::expected<transcode_stats, transcode_failure> transcode(thread_pool& pool, std::istream& in, std::ostream& out,
+                                                            const transcode_options& opts = transcode_options{});
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef ZIP_ARCHIVE_READER_HPP
+#define ZIP_ARCHIVE_READER_HPP
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <vector>
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+#include "zip/format.hpp"
+
+namespace zipper::zip
+{
+
+// uncompressed size of the entry on success
+using extract_result = std::expected<uint64_t, zip_failure>;
+
+// receives the whole uncompressed content of an entry, may be called from several threads at once
+using entry_sink = std::function<bool(const entry&, std::span<const uint8_t>)>;
+
+// ZIP archive read through a memory mapping. The central directory (ZIP64 included) is parsed
+// on open; entries are independent and can be extracted concurrently.
+class archive_reader {
+    mapped_file file;
+    std::vector<entry> list;
+
+    archive_reader(mapped_file f, std::vector<entry> e) : file(std::move(f)), list(std::move(e)) {}
+public:
+    static std::expected<archive_reader, zip_failure> open(const std::filesystem::path& path);
+
+    const std::vector<entry>& entries() const { return list; }
+
+    // compressed bytes of `e` inside the mapping
+    std::expected<std::span<const uint8_t>, zip_failure> raw_data(const entry& e) const;
+
+    // Decompresses `e` into `target` of at least `e.uncompressed_size` bytes and checks its CRC-32.
+    extract_result extract(const entry& e, uint8_t* target, size_t target_length) const;
+
+    // Decompresses `e` straight into a file mapping below `directory`, creating parent directories.
+    // Names escaping `directory` are refused.
+    extract_result extract_to(const entry& e, const std::filesystem::path& directory) const;
+
+    // Extracts every entry on `pool`, largest first. Results are in the order of `entries()`.
+    // Of several entries with the same name the last one is written, the others report 0 bytes.
+    std::vector<extract_result> extract_all(thread_pool& pool, const std::filesystem::path& directory) const;
+    std::vector<extract_result> extract_all(thread_pool& pool, const entry_sink& sink) const;
+};
+
+} // namespace zipper::zip
+
+#endif
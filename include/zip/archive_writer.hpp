@@ -0,0 +1,55 @@
+#ifndef ZIP_ARCHIVE_WRITER_HPP
+#define ZIP_ARCHIVE_WRITER_HPP
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <vector>
+#include "deflate/optimal_encoder.hpp"
+#include "thread_pool.hpp"
+#include "zip/format.hpp"
+
+namespace zipper::zip
+{
+
+struct writer_options {
+    // METHOD_DEFLATED falls back to METHOD_STORED for entries which do not shrink
+    uint16_t method = METHOD_DEFLATED;
+    deflate::optimal_options deflate{};
+    // writes ZIP64 records even when the archive fits the classic limits
+    bool force_zip64 = false;
+};
+
+// Builds a ZIP archive from in-memory entries. Every entry is compressed by its own job on
+// the pool as soon as it is added, `write` lays them out in the order of addition.
+class archive_writer {
+    // result of the compression job of one entry
+    struct compressed {
+        uint16_t method;
+        uint32_t crc32;
+        uint64_t uncompressed_size;
+        std::vector<uint8_t> data;
+    };
+    struct pending {
+        std::string name;
+        std::future<std::expected<compressed, zip_failure>> job;
+    };
+
+    thread_pool& pool;
+    writer_options options;
+    std::vector<pending> entries;
+public:
+    explicit archive_writer(thread_pool& workers, writer_options opts = writer_options{}) : pool(workers), options(opts) {}
+
+    // names ending in '/' are directories and must have no content
+    void add(std::string name, std::vector<uint8_t> data);
+
+    // waits for the compression jobs and writes the archive to `path`
+    std::expected<void, zip_failure> write(const std::filesystem::path& path);
+};
+
+} // namespace zipper::zip
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef ZIP_FORMAT_HPP
+#define ZIP_FORMAT_HPP
+
+#include <cstdint>
+#include <expected>
+#include <string>
+
+namespace zipper::zip
+{
+
+constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+constexpr uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+constexpr uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06064b50;
+constexpr uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+constexpr uint16_t ZIP64_EXTRA_ID = 0x0001;
+
+constexpr size_t LOCAL_HEADER_SIZE = 30;
+constexpr size_t CENTRAL_HEADER_SIZE = 46;
+constexpr size_t END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+constexpr size_t ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE = 56;
+constexpr size_t ZIP64_LOCATOR_SIZE = 20;
+
+constexpr uint16_t METHOD_STORED = 0;
+constexpr uint16_t METHOD_DEFLATED = 8;
+constexpr uint16_t FLAG_ENCRYPTED = 0x0001;
+constexpr uint16_t FLAG_UTF8 = 0x0800;
+
+struct entry {
+    std::string name;
+    uint16_t method;
+    uint16_t flags;
+    uint16_t time;
+    uint16_t date;
+    uint32_t crc32;
+    uint64_t compressed_size;
+    uint64_t uncompressed_size;
+    uint64_t local_header_offset;
+
+    bool is_directory() const { return !name.empty() && name.back() == '/'; }
+};
+
+struct zip_failure {
+    std::string name; // entry the failure belongs to, empty for the archive itself
+    const char* message;
+};
+
+inline uint16_t read_le16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+inline uint32_t read_le32(const uint8_t* p) { return read_le16(p) | (static_cast<uint32_t>(read_le16(p + 2)) << 16); }
+inline uint64_t read_le64(const uint8_t* p) { return read_le32(p) | (static_cast<uint64_t>(read_le32(p + 4)) << 32); }
+
+inline uint8_t* write_le16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; return p + 2; }
+inline uint8_t* write_le32(uint8_t* p, uint32_t v) { return write_le16(write_le16(p, v), v >> 16); }
+inline uint8_t* write_le64(uint8_t* p, uint64_t v) { return write_le32(write_le32(p, v), v >> 32); }
+
+} // namespace zipper::zip
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef ZLIB_DECODER_HPP
+#define ZLIB_DECODER_HPP
+
+#include <cstdint>
+#include <memory>
+#include "decoder_if.hpp"
+#include "deflate/dictionary.hpp"
+
+namespace zipper::zlib
+{
+
+// zlib container (RFC 1950): a two byte header, optional DICTID of a preset dictionary,
+// raw DEFLATE data and the Adler-32 of the uncompressed data.
+class decoder : public decoder_if {
+    uint8_t* source;
+    size_t source_length;
+    std::shared_ptr<const deflate::dictionary> dict;
+public:
+    // `dictionary` is required by streams with the FDICT flag and has to match their DICTID
+    decoder(uint8_t* source, size_t source_length, std::shared_ptr<const deflate::dictionary> dictionary = nullptr)
+        : source(source), source_length(source_length), dict(std::move(dictionary)) {}
+
+    decode_result decode(uint8_t* target, size_t target_length) override;
+};
+
+} // namespace zipper::zlib
+
+#endif
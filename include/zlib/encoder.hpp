@@ -0,0 +1,41 @@
+#ifndef ZLIB_ENCODER_HPP
+#define ZLIB_ENCODER_HPP
+
+#include <cstdint>
+#include <memory>
+#include "encoder_if.hpp"
+#include "deflate/dictionary.hpp"
+#include "deflate/optimal_encoder.hpp"
+#include "deflate/stream_encoder.hpp"
+
+namespace zipper::zlib
+{
+
+constexpr size_t HEADER_SIZE = 2;
+constexpr size_t DICTID_SIZE = 4;
+constexpr size_t TRAILER_SIZE = 4;
+
+// Worst case size of a zlib stream for `source_length` bytes of input.
+size_t compress_bound(size_t source_length);
+// The same for an encoder made with `options`, see `deflate::compress_bound`.
+size_t compress_bound(size_t source_length, const deflate::stream_options& options);
+
+class encoder : public encoder_if {
+    std::unique_ptr<encoder_if> raw;
+    std::shared_ptr<const deflate::dictionary> dict;
+    // FLEVEL of the header, 3 for maximum compression and 0 for the fastest
+    uint8_t level;
+public:
+    // with `dictionary` the stream carries its DICTID and the data is primed with it
+    explicit encoder(deflate::optimal_options options = deflate::optimal_options{}, std::shared_ptr<const deflate::dictionary> dictionary = nullptr)
+        : raw(std::make_unique<deflate::optimal_encoder>(options, dictionary)), dict(std::move(dictionary)), level(3) {}
+    // compresses with the streaming LZ77 encoder, much faster at a lower ratio
+    explicit encoder(deflate::stream_options options)
+        : raw(std::make_unique<deflate::stream_encoder>(options)), level(0) {}
+
+    encode_result encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) override;
+};
+
+} // namespace zipper::zlib
+
+#endif
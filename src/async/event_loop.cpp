@@ -0,0 +1,132 @@
+#include <cerrno>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "async/event_loop.hpp"
+
+namespace zipper::async
+{
+
+event_loop::event_loop() : epoll_fd(epoll_create1(EPOLL_CLOEXEC)) {
+    if (epoll_fd < 0) {
+        create_error = errno;
+    }
+}
+
+event_loop::~event_loop() {
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+}
+
+static uint32_t interest(bool reader, bool writer) {
+    return uint32_t(EPOLLONESHOT) | (reader ? uint32_t(EPOLLIN) : 0u) | (writer ? uint32_t(EPOLLOUT) : 0u);
+}
+
+void event_loop::wait_for(int fd, bool write, std::coroutine_handle<> h) {
+    auto& w = waiting[fd];
+    (write ? w.writer : w.reader) = h;
+
+    // an fd is registered only while something waits for it, so it is usually new here
+    epoll_event ev{};
+    ev.events = interest(bool(w.reader), bool(w.writer));
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0) {
+        return;
+    }
+    if (errno == EEXIST && epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0) {
+        return;
+    }
+    // regular files (EPERM) are always ready, other errors surface on the next read or write
+    (write ? w.writer : w.reader) = nullptr;
+    if (!w.reader && !w.writer) {
+        waiting.erase(fd);
+    }
+    ready.push_back(h);
+}
+
+bool event_loop::run() {
+    constexpr int MAX_EVENTS = 64;
+    epoll_event events[MAX_EVENTS];
+
+    if (epoll_fd < 0) {
+        return false;
+    }
+    while (active > 0) {
+        while (!ready.empty()) {
+            auto h = ready.front();
+            ready.pop_front();
+            h.resume();
+        }
+        if (active == 0) {
+            break;
+        }
+        if (waiting.empty()) {
+            return false;
+        }
+
+        const int n = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+        if (n < 0 && errno != EINTR) {
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            auto it = waiting.find(events[i].data.fd);
+            if (it == waiting.end()) {
+                continue;
+            }
+            auto w = it->second;
+            const bool error = events[i].events & (EPOLLERR | EPOLLHUP);
+            if (w.reader && (events[i].events & EPOLLIN || error)) {
+                ready.push_back(w.reader);
+                w.reader = nullptr;
+            }
+            if (w.writer && (events[i].events & EPOLLOUT || error)) {
+                ready.push_back(w.writer);
+                w.writer = nullptr;
+            }
+            if (!w.reader && !w.writer) {
+                // the fd may be closed once its waiters have resumed
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, events[i].data.fd, nullptr);
+                waiting.erase(it);
+                continue;
+            }
+            // the one-shot registration is spent, re-arm for the remaining waiter
+            it->second = w;
+            epoll_event ev{};
+            ev.events = interest(bool(w.reader), bool(w.writer));
+            ev.data.fd = events[i].data.fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, events[i].data.fd, &ev);
+        }
+    }
+    return true;
+}
+
+task<ssize_t> fd_source::read(std::span<uint8_t> buffer) {
+    for (;;) {
+        const ssize_t n = ::read(fd, buffer.data(), buffer.size());
+        if (n >= 0) {
+            co_return n;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await loop.readable(fd);
+        } else if (errno != EINTR) {
+            co_return -1;
+        }
+    }
+}
+
+task<ssize_t> fd_sink::write(std::span<const uint8_t> buffer) {
+    size_t done = 0;
+    while (done < buffer.size()) {
+        const ssize_t n = ::write(fd, buffer.data() + done, buffer.size() - done);
+        if (n >= 0) {
+            done += n;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await loop.writable(fd);
+        } else if (errno != EINTR) {
+            co_return -1;
+        }
+    }
+    co_return static_cast<ssize_t>(done);
+}
+
+} // namespace zipper::async
@@ -0,0 +1,63 @@
+#include "buffer_ring.hpp"
+
+namespace zipper {
+
+buffer_ring::buffer_ring(size_t count, size_t size) : buffers(count, std::vector<char>(size)), lengths(count), marks(count) {}
+
+std::span<char> buffer_ring::acquire() {
+    std::unique_lock lock(mutex);
+    changed.wait(lock, [this]() { return cancelled || produced - consumed < buffers.size(); });
+    if (cancelled) {
+        return {};
+    }
+    return buffers[produced % buffers.size()];
+}
+
+void buffer_ring::publish(size_t length, bool mark) {
+    {
+        std::lock_guard lock(mutex);
+        lengths[produced % buffers.size()] = length;
+        marks[produced % buffers.size()] = mark;
+        produced++;
+    }
+    changed.notify_all();
+}
+
+void buffer_ring::close() {
+    {
+        std::lock_guard lock(mutex);
+        closed = true;
+    }
+    changed.notify_all();
+}
+
+void buffer_ring::drain() {
+    std::unique_lock lock(mutex);
+    changed.wait(lock, [this]() { return cancelled || (consumed == produced && !holding); });
+}
+
+std::optional<buffer_ring::slot> buffer_ring::next() {
+    std::unique_lock lock(mutex);
+    if (holding) {
+        holding = false;
+        consumed++;
+        changed.notify_all();
+    }
+    changed.wait(lock, [this]() { return cancelled || closed || produced > consumed; });
+    if (cancelled || produced == consumed) {
+        return std::nullopt;
+    }
+    holding = true;
+    const size_t i = consumed % buffers.size();
+    return slot{std::span<char>(buffers[i].data(), lengths[i]), marks[i]};
+}
+
+void buffer_ring::cancel() {
+    {
+        std::lock_guard lock(mutex);
+        cancelled = true;
+    }
+    changed.notify_all();
+}
+
+}
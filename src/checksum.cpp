@@ -0,0 +1,59 @@
+#include <array>
+#include "checksum.hpp"
+
+namespace zipper {
+
+uint32_t adler32(const uint8_t* data, size_t length, uint32_t adler) {
+    constexpr uint32_t MOD = 65521;
+    // largest n such that 255 * n * (n + 1) / 2 + (n + 1) * (MOD - 1) fits in 32 bits
+    constexpr size_t NMAX = 5552;
+
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (length > 0) {
+        const size_t n = length < NMAX ? length : NMAX;
+        for (size_t i = 0; i < n; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= MOD;
+        b %= MOD;
+        data += n;
+        length -= n;
+    }
+    return (b << 16) | a;
+}
+
+// slicing-by-8: table[k][b] is the CRC of byte b followed by k zero bytes
+static constexpr std::array<std::array<uint32_t, 256>, 8> crc_tables = [] {
+    std::array<std::array<uint32_t, 256>, 8> t{};
+    for (uint32_t b = 0; b < 256; b++) {
+        uint32_t c = b;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        t[0][b] = c;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+        for (size_t k = 1; k < 8; k++) {
+            t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF];
+        }
+    }
+    return t;
+}();
+
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    uint32_t c = ~crc;
+    for (; length >= 8; data += 8, length -= 8) {
+        const uint32_t lo = c ^ (data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24));
+        const uint32_t hi = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<uint32_t>(data[7]) << 24);
+        c = crc_tables[7][lo & 0xFF] ^ crc_tables[6][(lo >> 8) & 0xFF] ^ crc_tables[5][(lo >> 16) & 0xFF] ^ crc_tables[4][lo >> 24]
+          ^ crc_tables[3][hi & 0xFF] ^ crc_tables[2][(hi >> 8) & 0xFF] ^ crc_tables[1][(hi >> 16) & 0xFF] ^ crc_tables[0][hi >> 24];
+    }
+    for (; length > 0; data++, length--) {
+        c = crc_tables[0][(c ^ *data) & 0xFF] ^ (c >> 8);
+    }
+    return ~c;
+}
+
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cstring>
+#include "codec_registry.hpp"
+#include "deflate/decoder.hpp"
+#include "deflate/optimal_encoder.hpp"
+#include "deflate/stream_encoder.hpp"
+#include "gzip/decoder.hpp"
+#include "gzip/encoder.hpp"
+#include "lz/decoder.hpp"
+#include "lz/encoder.hpp"
+#include "lz/format.hpp"
+#include "zlib/decoder.hpp"
+#include "zlib/encoder.hpp"
+
+namespace zipper {
+
+namespace {
+
+bool is_lz(std::span<const uint8_t> data) {
+    return data.size() >= sizeof(lz::MAGIC) && std::memcmp(data.data(), lz::MAGIC, sizeof(lz::MAGIC)) == 0;
+}
+
+bool is_gzip(std::span<const uint8_t> data) {
+    return data.size() >= 3 && data[0] == gzip::ID1 && data[1] == gzip::ID2 && data[2] == gzip::CM_DEFLATE;
+}
+
+bool is_zlib(std::span<const uint8_t> data) {
+    // deflate method, window of at most 32K and the header check
+    return data.size() >= 2 && (data[0] & 0x0F) == 8 && (data[0] >> 4) <= 7 && ((data[0] << 8) | data[1]) % 31 == 0;
+}
+
+bool is_raw_deflate(std::span<const uint8_t> data) {
+    if (data.empty()) {
+        return false;
+    }
+    const uint32_t type = (data[0] >> 1) & 3;
+    if (type == deflate::RESERVED) {
+        return false;
+    }
+    if (type == deflate::NO_COMPRESSION && data.size() >= 5) {
+        // a stored block starts at the next byte with LEN and its complement
+        return (data[1] ^ data[3]) == 0xFF && (data[2] ^ data[4]) == 0xFF;
+    }
+    return true;
+}
+
+} // namespace
+
+codec_registry codec_registry::with_builtin() {
+    codec_registry r;
+    r.add(codec{
+        "deflate", is_raw_deflate,
+        [](uint8_t* source, size_t length) { return std::make_unique<deflate::decoder>(source, length); },
+        [] { return std::make_unique<deflate::stream_encoder>(); },
+        [](size_t length) { return deflate::compress_bound(length, deflate::stream_options{}); }});
+    r.add(codec{
+        "zlib", is_zlib,
+        [](uint8_t* source, size_t length) { return std::make_unique<zlib::decoder>(source, length); },
+        [] { return std::make_unique<zlib::encoder>(deflate::stream_options{}); },
+        [](size_t length) { return zlib::compress_bound(length, deflate::stream_options{}); }});
+    r.add(codec{
+        "gzip", is_gzip,
+        [](uint8_t* source, size_t length) { return std::make_unique<gzip::decoder>(source, length); },
+        [] { return std::make_unique<gzip::encoder>(deflate::stream_options{}); },
+        [](size_t length) { return gzip::compress_bound(length, deflate::stream_options{}); }});
+    r.add(codec{
+        "lz", is_lz,
+        [](uint8_t* source, size_t length) { return std::make_unique<lz::decoder>(source, length); },
+        [] { return std::make_unique<lz::encoder>(); },
+        lz::compress_bound});
+    return r;
+}
+
+void codec_registry::add(codec c) {
+    auto same = std::find_if(codecs.begin(), codecs.end(), [&](const codec& other) { return other.name == c.name; });
+    if (same != codecs.end()) {
+        codecs.erase(same);
+    }
+    codecs.insert(codecs.begin(), std::move(c));
+}
+
+const codec* codec_registry::find(std::string_view name) const {
+    auto it = std::find_if(codecs.begin(), codecs.end(), [&](const codec& c) { return c.name == name; });
+    return it == codecs.end() ? nullptr : &*it;
+}
+
+const codec* codec_registry::detect(std::span<const uint8_t> data) const {
+    auto it = std::find_if(codecs.begin(), codecs.end(), [&](const codec& c) { return c.detect && c.detect(data); });
+    return it == codecs.end() ? nullptr : &*it;
+}
+
+std::unique_ptr<decoder_if> codec_registry::open(uint8_t* source, size_t source_length) const {
+    const codec* c = detect(std::span<const uint8_t>(source, source_length));
+    return c == nullptr ? nullptr : c->make_decoder(source, source_length);
+}
+
+} // namespace zipper
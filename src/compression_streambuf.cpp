@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <expected>
+#include "checksum.hpp"
+#include "compression_streambuf.hpp"
+#include "gzip/decoder.hpp"
+#include "gzip/encoder.hpp"
+
+namespace zipper {
+
+namespace {
+
+// headers longer than this are taken for garbage rather than read on
+constexpr size_t MAX_HEADER_SIZE = 1 << 20;
+
+std::expected<size_t, const char*> parse_header(stream_format format, const std::vector<uint8_t>& input) {
+    if (format == stream_format::gzip) {
+        auto size = gzip::decoder::header_size(input.data(), input.size());
+        if (!size) {
+            return std::unexpected(size.error().message);
+        }
+        return *size;
+    }
+    if (input.size() < 2) {
+        return std::unexpected("Source data is too short for a zlib stream");
+    }
+    if ((input[0] & 0x0F) != 8 || (input[0] >> 4) > 7 || ((input[0] << 8) | input[1]) % 31 != 0) {
+        return std::unexpected("Corrupted zlib header");
+    }
+    if (input[1] & 0x20) {
+        return std::unexpected("Preset dictionary is required");
+    }
+    return 2;
+}
+
+uint32_t read_le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint32_t read_be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+} // namespace
+
+decompress_streambuf::decompress_streambuf(std::istream& compressed, streambuf_options opts)
+    : source(compressed), options(opts), ring(std::max<size_t>(opts.buffers, 2), std::max<size_t>(opts.buffer_size, 1)) {
+    worker = std::thread([this]() { run(); });
+}
+
+decompress_streambuf::~decompress_streambuf() {
+    ring.cancel();
+    worker.join();
+}
+
+decompress_streambuf::int_type decompress_streambuf::underflow() {
+    auto slot = ring.next();
+    if (!slot) {
+        return traits_type::eof();
+    }
+    setg(slot->data.data(), slot->data.data(), slot->data.data() + slot->data.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+void decompress_streambuf::run() {
+    std::vector<uint8_t> input;
+    bool source_end = false;
+    auto read_more = [&]() {
+        const size_t old = input.size();
+        input.resize(old + options.buffer_size);
+        source.read(reinterpret_cast<char*>(input.data() + old), options.buffer_size);
+        input.resize(old + source.gcount());
+        source_end = input.size() == old;
+        return !source_end;
+    };
+    auto fail = [&](const char* message) {
+        failure = message;
+        ring.close();
+    };
+
+    std::span<char> out;
+    size_t filled = 0;
+    auto finish = [&]() {
+        if (filled > 0) {
+            ring.publish(filled);
+        }
+        ring.close();
+    };
+
+    for (uint32_t member = 0;; member++) {
+        size_t header = 0;
+        if (options.format != stream_format::deflate) {
+            if (member > 0) {
+                // another gzip member or the end of the file
+                while (input.empty() && read_more()) {
+                }
+                if (input.empty()) {
+                    return finish();
+                }
+            }
+            for (;;) {
+                auto size = parse_header(options.format, input);
+                if (size) {
+                    header = *size;
+                    break;
+                }
+                if (input.size() > MAX_HEADER_SIZE || !read_more()) {
+                    return fail(size.error());
+                }
+            }
+        }
+
+        decoder.reset();
+        decoder.feed(input.data() + header, input.size() - header);
+        input.clear();
+        uint32_t checksum = options.format == stream_format::zlib ? 1 : 0;
+        uint64_t size = 0;
+        for (;;) {
+            if (out.empty()) {
+                out = ring.acquire();
+                filled = 0;
+                if (out.empty()) {
+                    return;
+                }
+            }
+            size_t written = 0;
+            const auto start = std::chrono::steady_clock::now();
+            auto status = decoder.decode(reinterpret_cast<uint8_t*>(out.data()) + filled, out.size() - filled, written);
+            const auto* produced = reinterpret_cast<const uint8_t*>(out.data()) + filled;
+            checksum = options.format == stream_format::zlib ? adler32(produced, written, checksum) : crc32(produced, written, checksum);
+            busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            filled += written;
+            size += written;
+            if (!status) {
+                return fail(status.error().message);
+            }
+            if (*status == deflate::stream_status::done) {
+                break;
+            }
+            if (*status == deflate::stream_status::need_output) {
+                ring.publish(filled);
+                out = {};
+            } else {
+                if (!read_more()) {
+                    return fail("Unexpected end of deflate stream");
+                }
+                decoder.feed(input.data(), input.size());
+                input.clear();
+            }
+        }
+
+        const auto unused = decoder.unused_input();
+        input.assign(unused.begin(), unused.end());
+        if (options.format == stream_format::deflate) {
+            return finish();
+        }
+        const size_t trailer = options.format == stream_format::gzip ? gzip::TRAILER_SIZE : 4;
+        while (input.size() < trailer) {
+            if (!read_more()) {
+                return fail("Unexpected end of input before the trailer");
+            }
+        }
+        if (options.format == stream_format::zlib) {
+            return read_be32(input.data()) == checksum ? finish() : fail("Adler-32 mismatch");
+        }
+        if (read_le32(input.data()) != checksum) {
+            return fail("CRC-32 mismatch");
+        }
+        if (read_le32(input.data() + 4) != static_cast<uint32_t>(size)) {
+            return fail("Uncompressed size mismatch");
+        }
+        input.erase(input.begin(), input.begin() + trailer);
+    }
+}
+
+compress_streambuf::compress_streambuf(std::ostream& compressed, streambuf_options opts)
+    : sink(compressed), options(opts), ring(std::max<size_t>(opts.buffers, 2), std::max<size_t>(opts.buffer_size, 1)),
+      encoder(opts.deflate) {
+    worker = std::thread([this]() { run(); });
+    next_buffer();
+}
+
+compress_streambuf::~compress_streambuf() {
+    close();
+}
+
+bool compress_streambuf::next_buffer() {
+    auto buffer = ring.acquire();
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return !buffer.empty();
+}
+
+compress_streambuf::int_type compress_streambuf::overflow(int_type ch) {
+    if (closed || failed) {
+        return traits_type::eof();
+    }
+    ring.publish(pptr() - pbase());
+    if (!next_buffer()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int compress_streambuf::sync() {
+    if (closed || failed) {
+        return -1;
+    }
+    ring.publish(pptr() - pbase(), true);
+    ring.drain();
+    return next_buffer() && !failed ? 0 : -1;
+}
+
+bool compress_streambuf::close() {
+    if (!closed) {
+        closed = true;
+        if (pbase() != nullptr) {
+            ring.publish(pptr() - pbase());
+        }
+        setp(nullptr, nullptr);
+        ring.close();
+        worker.join();
+    }
+    return !failed;
+}
+
+bool compress_streambuf::write(const uint8_t* data, size_t length, deflate::flush_mode flush, std::vector<uint8_t>& out) {
+    for (size_t read = 0;;) {
+        auto r = encoder.encode(data + read, length - read, out.data(), out.size(), flush);
+        if (!r) {
+            return false;
+        }
+        sink.write(reinterpret_cast<const char*>(out.data()), r->bytes_written);
+        if (!sink) {
+            return false;
+        }
+        read += r->bytes_read;
+        if (read == length && encoder.pending() == 0) {
+            return true;
+        }
+    }
+}
+
+void compress_streambuf::run() {
+    std::vector<uint8_t> out(options.buffer_size);
+    auto fail = [&]() {
+        failed = true;
+        ring.cancel();
+    };
+
+    if (options.format == stream_format::gzip) {
+        const uint8_t header[gzip::HEADER_SIZE] = {gzip::ID1, gzip::ID2, gzip::CM_DEFLATE, 0, 0, 0, 0, 0, 0, 255};
+        sink.write(reinterpret_cast<const char*>(header), sizeof(header));
+    } else if (options.format == stream_format::zlib) {
+        // window size as configured, default compression level
+        const uint8_t cmf = static_cast<uint8_t>(((std::clamp<uint32_t>(options.deflate.window_bits, 9, 15) - 8) << 4) | 8);
+        uint8_t flg = 2 << 6;
+        flg |= 31 - ((cmf << 8) | flg) % 31;
+        const uint8_t header[2] = {cmf, flg};
+        sink.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+    if (!sink) {
+        return fail();
+    }
+
+    uint32_t checksum = options.format == stream_format::zlib ? 1 : 0;
+    uint64_t size = 0;
+    while (auto slot = ring.next()) {
+        const auto* data = reinterpret_cast<const uint8_t*>(slot->data.data());
+        checksum = options.format == stream_format::zlib ? adler32(data, slot->data.size(), checksum) : crc32(data, slot->data.size(), checksum);
+        size += slot->data.size();
+        if (!write(data, slot->data.size(), slot->mark ? deflate::flush_mode::sync_flush : deflate::flush_mode::no_flush, out)) {
+            return fail();
+        }
+        if (slot->mark && !sink.flush()) {
+            return fail();
+        }
+    }
+    if (!write(nullptr, 0, deflate::flush_mode::finish, out)) {
+        return fail();
+    }
+
+    uint8_t trailer[8];
+    size_t trailer_size = 0;
+    if (options.format == stream_format::gzip) {
+        for (size_t i = 0; i < 4; i++) {
+            trailer[i] = static_cast<uint8_t>(checksum >> (8 * i));
+            trailer[4 + i] = static_cast<uint8_t>(size >> (8 * i));
+        }
+        trailer_size = 8;
+    } else if (options.format == stream_format::zlib) {
+        for (size_t i = 0; i < 4; i++) {
+            trailer[i] = static_cast<uint8_t>(checksum >> (24 - 8 * i));
+        }
+        trailer_size = 4;
+    }
+    sink.write(reinterpret_cast<const char*>(trailer), trailer_size);
+    if (!sink.flush()) {
+        fail();
+    }
+}
+
+}
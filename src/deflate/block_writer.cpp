@@ -0,0 +1,334 @@
+#include <algorithm>
+#include "deflate/block_writer.hpp"
+#include "histogram.hpp"
+
+namespace zipper::deflate
+{
+
+static huffman_code<LITLEN_CODES> build_static_litlen() {
+    std::array<uint8_t, LITLEN_CODES> lengths;
+    for (size_t i = 0; i < LITLEN_CODES; i++) {
+        lengths[i] = i <= 143 ? 8 : i <= 255 ? 9 : i <= 279 ? 7 : 8;
+    }
+    return huffman_code<LITLEN_CODES>::from_lengths(lengths);
+}
+
+static huffman_code<DISTANCE_CODES> build_static_distance() {
+    std::array<uint8_t, DISTANCE_CODES> lengths;
+    lengths.fill(5);
+    return huffman_code<DISTANCE_CODES>::from_lengths(lengths);
+}
+
+const huffman_code<LITLEN_CODES> block_writer::static_litlen = build_static_litlen();
+const huffman_code<DISTANCE_CODES> block_writer::static_distance = build_static_distance();
+
+constexpr std::array<uint8_t, CL_CODES> clen_order = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// readers such as zlib reject incomplete codes with more than one bit, so every code gets at least two symbols
+template<size_t n_codes>
+static std::array<uint32_t, n_codes> with_two_symbols(std::array<uint32_t, n_codes> frequencies) {
+    size_t used = 0;
+    for (auto f : frequencies) {
+        used += f != 0;
+    }
+    for (size_t i = 0; used < 2 && i < n_codes; i++) {
+        if (frequencies[i] == 0) {
+            frequencies[i] = 1;
+            used++;
+        }
+    }
+    return frequencies;
+}
+
+dynamic_header dynamic_header::build(const block_statistics& stats) {
+    dynamic_header h;
+    h.litlen = huffman_code<LITLEN_CODES>::from_frequencies(with_two_symbols(stats.litlen), 15);
+    h.distance = huffman_code<DISTANCE_CODES>::from_frequencies(with_two_symbols(stats.distance), 15);
+
+    h.hlit = 286;
+    while (h.hlit > 257 && h.litlen.lengths[h.hlit - 1] == 0) {
+        h.hlit--;
+    }
+    h.hdist = 30;
+    while (h.hdist > 1 && h.distance.lengths[h.hdist - 1] == 0) {
+        h.hdist--;
+    }
+
+    std::array<uint8_t, LITLEN_CODES + DISTANCE_CODES> lengths;
+    const uint32_t total = h.hlit + h.hdist;
+    for (uint32_t i = 0; i < h.hlit; i++) {
+        lengths[i] = h.litlen.lengths[i];
+    }
+    for (uint32_t i = 0; i < h.hdist; i++) {
+        lengths[h.hlit + i] = h.distance.lengths[i];
+    }
+
+    // run-length encode the code lengths, runs may cross from literal/length into distance lengths
+    h.rle_length = 0;
+    std::array<uint32_t, CL_CODES> cl_frequencies{};
+    auto emit = [&](uint32_t symbol, uint32_t extra) {
+        h.rle[h.rle_length++] = static_cast<uint16_t>(symbol | (extra << 8));
+        cl_frequencies[symbol]++;
+    };
+    for (uint32_t i = 0; i < total;) {
+        const uint8_t cur = lengths[i];
+        uint32_t run = 1;
+        while (i + run < total && lengths[i + run] == cur) {
+            run++;
+        }
+        i += run;
+
+        if (cur == 0) {
+            while (run >= 11) {
+                const uint32_t r = run < 138 ? run : 138;
+                emit(18, r - 11);
+                run -= r;
+            }
+            if (run >= 3) {
+                emit(17, run - 3);
+                run = 0;
+            }
+        } else {
+            emit(cur, 0);
+            run--;
+            while (run >= 3) {
+                const uint32_t r = run < 6 ? run : 6;
+                emit(16, r - 3);
+                run -= r;
+            }
+        }
+        for (; run > 0; run--) {
+            emit(cur, 0);
+        }
+    }
+
+    h.codelen = huffman_code<CL_CODES>::from_frequencies(with_two_symbols(cl_frequencies), 7);
+    h.hclen = CL_CODES;
+    while (h.hclen > 4 && h.codelen.lengths[clen_order[h.hclen - 1]] == 0) {
+        h.hclen--;
+    }
+
+    h.header_bits = 5 + 5 + 4 + 3 * h.hclen;
+    for (uint32_t i = 0; i < h.rle_length; i++) {
+        const uint32_t symbol = h.rle[i] & 0xFF;
+        h.header_bits += h.codelen.lengths[symbol];
+        if (symbol >= 16) {
+            h.header_bits += clcl_table[symbol - 16].extra_bits;
+        }
+    }
+    return h;
+}
+
+template<size_t n_codes>
+size_t block_writer::symbols_cost(const block_statistics& stats, const huffman_code<n_codes>& litlen, const huffman_code<DISTANCE_CODES>& distance) {
+    size_t bits = 0;
+    for (size_t i = 0; i < 286; i++) {
+        if (stats.litlen[i] == 0) {
+            continue;
+        }
+        const size_t extra = i > END_OF_BLOCK ? code_lengths_table[i - 257].extra_bits : 0;
+        bits += static_cast<size_t>(stats.litlen[i]) * (litlen.lengths[i] + extra);
+    }
+    for (size_t i = 0; i < 30; i++) {
+        bits += static_cast<size_t>(stats.distance[i]) * (distance.lengths[i] + code_dist_table[i].extra_bits);
+    }
+    return bits;
+}
+
+size_t block_writer::stored_cost(size_t length, size_t bit_offset) {
+    size_t bits = 0;
+    do {
+        const size_t chunk = length < MAX_STORED_BLOCK ? length : MAX_STORED_BLOCK;
+        const size_t header_end = bit_offset + bits + 3;
+        bits += 3 + (8 - header_end % 8) % 8 + 32 + 8 * chunk;
+        length -= chunk;
+    } while (length > 0);
+    return bits;
+}
+
+size_t block_writer::static_cost(const block_statistics& stats) {
+    return 3 + symbols_cost(stats, static_litlen, static_distance);
+}
+
+size_t block_writer::dynamic_cost(const block_statistics& stats, const dynamic_header& header) {
+    return 3 + header.header_bits + symbols_cost(stats, header.litlen, header.distance);
+}
+
+size_t block_writer::best_cost(const block_statistics& stats, size_t length, size_t bit_offset) {
+    return std::min({stored_cost(length, bit_offset), static_cost(stats), dynamic_cost(stats)});
+}
+
+template<size_t n_codes>
+void block_writer::write_symbols(bit_writer& out, std::span<const lz77_symbol> symbols, const huffman_code<n_codes>& litlen, const huffman_code<DISTANCE_CODES>& distance) {
+    for (const auto& s : symbols) {
+        if (s.is_literal()) {
+            out.write(litlen.codes[s.value], litlen.lengths[s.value]);
+            continue;
+        }
+        // at most 15 + 5 + 15 + 13 bits, one flush for the whole match
+        const uint32_t lsym = length_symbol(s.length);
+        const auto& lentry = code_lengths_table[lsym - 257];
+        out.add(litlen.codes[lsym], litlen.lengths[lsym]);
+        out.add(s.length - lentry.base_value, lentry.extra_bits);
+
+        const uint32_t dsym = distance_symbol(s.value);
+        const auto& dentry = code_dist_table[dsym];
+        out.add(distance.codes[dsym], distance.lengths[dsym]);
+        out.add(s.value - dentry.base_value, dentry.extra_bits);
+        out.flush();
+    }
+    out.write(litlen.codes[END_OF_BLOCK], litlen.lengths[END_OF_BLOCK]);
+}
+
+template<size_t n_codes>
+void block_writer::write_literals(bit_writer& out, const uint8_t* data, size_t length, const huffman_code<n_codes>& litlen) {
+    // three literals of at most 15 bits per flush
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3) {
+        out.add(litlen.codes[data[i]], litlen.lengths[data[i]]);
+        out.add(litlen.codes[data[i + 1]], litlen.lengths[data[i + 1]]);
+        out.add(litlen.codes[data[i + 2]], litlen.lengths[data[i + 2]]);
+        out.flush();
+    }
+    for (; i < length; i++) {
+        out.write(litlen.codes[data[i]], litlen.lengths[data[i]]);
+    }
+    out.write(litlen.codes[END_OF_BLOCK], litlen.lengths[END_OF_BLOCK]);
+}
+
+void block_writer::write_dynamic_header(bit_writer& out, const dynamic_header& header, bool final) {
+    out.add(static_cast<uint32_t>(final) | (DYNAMIC_HUFFMAN << 1), 3);
+    out.add(header.hlit - 257, 5);
+    out.add(header.hdist - 1, 5);
+    out.add(header.hclen - 4, 4);
+    out.flush();
+    for (uint32_t i = 0; i < header.hclen; i++) {
+        out.write(header.codelen.lengths[clen_order[i]], 3);
+    }
+    for (uint32_t i = 0; i < header.rle_length; i++) {
+        const uint32_t symbol = header.rle[i] & 0xFF;
+        out.add(header.codelen.codes[symbol], header.codelen.lengths[symbol]);
+        if (symbol >= 16) {
+            out.add(header.rle[i] >> 8, clcl_table[symbol - 16].extra_bits);
+        }
+        out.flush();
+    }
+}
+
+encode_result block_writer::write_stored(const uint8_t* data, size_t length, bool final) {
+    if (buffer.left_bits() < stored_cost(length, buffer.offset())) {
+        return no_space();
+    }
+    const size_t total = length;
+    do {
+        const size_t chunk = length < MAX_STORED_BLOCK ? length : MAX_STORED_BLOCK;
+        const bool last = final && chunk == length;
+        buffer.write_bits(static_cast<uint32_t>(last) | (NO_COMPRESSION << 1), 3);
+        align();
+        buffer.write_bits(chunk, 16);
+        buffer.write_bits(~chunk & 0xFFFF, 16);
+        std::copy_n(data, chunk, buffer.data() + buffer.byte_offset());
+        buffer.skip(8 * chunk);
+        data += chunk;
+        length -= chunk;
+    } while (length > 0);
+    return written(total);
+}
+
+encode_result block_writer::write_static(std::span<const lz77_symbol> symbols, bool final) {
+    if (buffer.left_bits() < static_cost(block_statistics::from_symbols(symbols))) {
+        return no_space();
+    }
+    bit_writer out = writer();
+    out.write(static_cast<uint32_t>(final) | (STATIC_HUFFMAN << 1), 3);
+    write_symbols(out, symbols, static_litlen, static_distance);
+    finish(out);
+    return written(0);
+}
+
+encode_result block_writer::write_dynamic(std::span<const lz77_symbol> symbols, const dynamic_header& header, bool final) {
+    if (buffer.left_bits() < dynamic_cost(block_statistics::from_symbols(symbols), header)) {
+        return no_space();
+    }
+    bit_writer out = writer();
+    write_dynamic_header(out, header, final);
+    write_symbols(out, symbols, header.litlen, header.distance);
+    finish(out);
+    return written(0);
+}
+
+encode_result block_writer::write_block(std::span<const lz77_symbol> symbols, const uint8_t* data, size_t length, bool final) {
+    const auto stats = block_statistics::from_symbols(symbols);
+    const auto header = dynamic_header::build(stats);
+
+    const size_t stored = stored_cost(length, buffer.offset());
+    const size_t fixed = static_cost(stats);
+    const size_t dynamic = dynamic_cost(stats, header);
+
+    encode_result result;
+    if (stored <= fixed && stored <= dynamic) {
+        result = write_stored(data, length, final);
+    } else if (fixed <= dynamic) {
+        result = write_static(symbols, final);
+    } else {
+        result = write_dynamic(symbols, header, final);
+    }
+    if (result) {
+        result->bytes_read = length;
+    }
+    return result;
+}
+
+encode_result block_writer::write_fixed_block(std::span<const lz77_symbol> symbols, const uint8_t* data, size_t length, bool final) {
+    const auto stats = block_statistics::from_symbols(symbols);
+    const size_t fixed = static_cost(stats);
+
+    encode_result result;
+    if (stored_cost(length, buffer.offset()) <= fixed) {
+        result = write_stored(data, length, final);
+    } else if (buffer.left_bits() < fixed) {
+        return no_space();
+    } else {
+        bit_writer out = writer();
+        out.write(static_cast<uint32_t>(final) | (STATIC_HUFFMAN << 1), 3);
+        write_symbols(out, symbols, static_litlen, static_distance);
+        finish(out);
+        result = written(0);
+    }
+    if (result) {
+        result->bytes_read = length;
+    }
+    return result;
+}
+
+encode_result block_writer::write_literal_block(const uint8_t* data, size_t length, bool final) {
+    std::array<uint32_t, 256> counts{};
+    byte_histogram(data, length, counts);
+    block_statistics stats;
+    std::copy(counts.begin(), counts.end(), stats.litlen.begin());
+    stats.litlen[END_OF_BLOCK] = 1;
+    const auto header = dynamic_header::build(stats);
+
+    const size_t stored = stored_cost(length, buffer.offset());
+    const size_t fixed = static_cost(stats);
+    const size_t dynamic = dynamic_cost(stats, header);
+    if (stored <= fixed && stored <= dynamic) {
+        return write_stored(data, length, final);
+    }
+    if (buffer.left_bits() < std::min(fixed, dynamic)) {
+        return no_space();
+    }
+    bit_writer out = writer();
+    if (fixed <= dynamic) {
+        out.write(static_cast<uint32_t>(final) | (STATIC_HUFFMAN << 1), 3);
+        write_literals(out, data, length, static_litlen);
+    } else {
+        write_dynamic_header(out, header, final);
+        write_literals(out, data, length, header.litlen);
+    }
+    finish(out);
+    return written(length);
+}
+
+} // namespace zipper::deflate
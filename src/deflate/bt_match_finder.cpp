@@ -0,0 +1,73 @@
+#include "deflate/bt_match_finder.hpp"
+
+namespace zipper::deflate
+{
+
+bt_match_finder::bt_match_finder(const uint8_t* source, size_t source_length, uint32_t depth, const dictionary* preset)
+    : data(source), length(source_length), max_depth(depth), dict(preset), head(1u << HASH_BITS, NIL), tree(2 * WINDOW_SIZE, NIL) {}
+
+size_t bt_match_finder::advance(size_t pos, match* matches, bool collect) {
+    if (length - pos < MIN_MATCH) {
+        return 0;
+    }
+    const uint32_t len_limit = length - pos < MAX_MATCH ? length - pos : MAX_MATCH;
+    const uint8_t* cur = data + pos;
+    const uint32_t h = hash3(cur, HASH_BITS);
+
+    size_t candidate = head[h];
+    head[h] = pos;
+
+    const size_t slot = pos % WINDOW_SIZE;
+    size_t* left = &tree[2 * slot];      // subtree of positions whose suffix is smaller
+    size_t* right = &tree[2 * slot + 1]; // subtree of positions whose suffix is greater
+    uint32_t left_len = 0, right_len = 0;
+    uint32_t best = MIN_MATCH - 1;
+    size_t found = 0;
+
+    for (uint32_t depth = max_depth;; depth--) {
+        if (candidate == NIL || pos - candidate >= WINDOW_SIZE || depth == 0) {
+            *left = NIL;
+            *right = NIL;
+            break;
+        }
+        const uint8_t* p = data + candidate;
+        uint32_t len = left_len < right_len ? left_len : right_len;
+        while (len < len_limit && p[len] == cur[len]) {
+            len++;
+        }
+
+        size_t* node = &tree[2 * (candidate % WINDOW_SIZE)];
+        if (len > best) {
+            best = len;
+            if (collect) {
+                matches[found++] = match{static_cast<uint16_t>(len), static_cast<uint16_t>(pos - candidate)};
+            }
+            if (len == len_limit) {
+                // the candidate is equal for the whole lookahead, replace it by the current position
+                *left = node[0];
+                *right = node[1];
+                break;
+            }
+        }
+
+        if (len < len_limit && p[len] < cur[len]) {
+            *left = candidate;
+            left = &node[1];
+            candidate = *left;
+            left_len = len;
+        } else {
+            *right = candidate;
+            right = &node[0];
+            candidate = *right;
+            right_len = len;
+        }
+    }
+
+    if (collect && dict != nullptr && pos < WINDOW_SIZE - 1 && best < len_limit) {
+        // dictionary matches are farther than any match in the source, only longer ones are useful
+        found += dict->find_matches(data, length, pos, best, max_depth, WINDOW_SIZE - 1, matches + found);
+    }
+    return found;
+}
+
+} // namespace zipper::deflate
@@ -35,87 +35,121 @@ huffman_tree<LITLEN_CODES> decoder::build_static_huffman_tree() {
 
 
 decode_result decoder::decode(uint8_t* target, size_t target_length) {
-    size_t target_idx = 0;
-    size_t block_number = 0;
-
-    while (target_idx < target_length && !read_buffer.eob()) {
-        bool is_last_block = read_buffer.read_bit();
-        uint32_t block_type;
-        
-        if(read_buffer.read_bits(block_type, 2) < 2) {
-            return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), block_number, "Unexpected end of block"});
-        }
+    start(target, target_length);
+    while (step(SIZE_MAX)) {
+    }
+    return progress();
+}
 
-        if (block_type == NO_COMPRESSION) {
-            auto result = decode_no_compress(target + target_idx, target_length - target_idx);
-            if(!result) {
-                return result;
-            }
-            target_idx += result->bytes_written;
-        } else if (block_type == STATIC_HUFFMAN) {
-            auto result = decode_with_huffman(target + target_idx, target_length - target_idx, static_huffman_tree, 
-            
-                std::function<decode_result(uint32_t&)>([this](uint32_t& dist_code) {
-                    return this->decode_static_huffman_distance(dist_code);
-                }));
-            if(!result) {
-                return result;
-            }
-            target_idx += result->bytes_written;
-        } else if (block_type == DYNAMIC_HUFFMAN) {
-            dynamic_block_trees trees;
-            auto result = decode_dynamic_huffman_header(trees);
+void decoder::start(uint8_t* target, size_t target_length) {
+    output_begin = target;
+    output_length = target_length;
+    output_idx = 0;
+    block_number = 0;
+    state = block_state::header;
+    failure.reset();
+    finished = false;
+    output_truncated = false;
+}
 
-            if(!result) {
-                return result;
-            }
+bool decoder::step(size_t symbols) {
+    if (state == block_state::done) {
+        return false;
+    }
+    auto result = state == block_state::header ? decode_block_header() : decode_symbols(symbols);
+    if (!result) {
+        failure = result.error();
+        state = block_state::done;
+    }
+    return state != block_state::done;
+}
 
-            result = decode_with_huffman(target + target_idx, target_length - target_idx, trees.litlen_tree, 
-                std::function<decode_result(uint32_t&)>([this, &trees](uint32_t& dist_code) {
-                    return this->decode_dynamic_huffman_distance_prototype(dist_code, trees.distance_tree);
-            }));
+decode_result decoder::progress() const {
+    if (failure) {
+        return unexpected(*failure);
+    }
+    return decode_success{output_idx, read_buffer.offset()};
+}
 
-            if(!result) {
-                return result;
-            }
-            target_idx += result->bytes_written;
-        } else if(block_type == RESERVED) {
-            return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), block_number, "Compression type is RESERVED"});
-        }
+decode_result decoder::decode_block_header() {
+    // blocks which produce no output are still consumed once the target is full,
+    // so that a stream decoded into a target of its exact size ends after its last block
+    if (read_buffer.eob()) {
+        state = block_state::done;
+        return decode_success{0, 0};
+    }
+    last_block = read_buffer.read_bit();
+    uint32_t block_type;
+
+    if(read_buffer.read_bits(block_type, 2) < 2) {
+        return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), block_number, "Unexpected end of block"});
+    }
 
-        if(is_last_block) {
-            break;
+    if (block_type == NO_COMPRESSION) {
+        auto result = decode_no_compress(output_begin + output_idx, output_length - output_idx);
+        if(!result) {
+            return result;
         }
-        block_number++;
+        output_idx += result->bytes_written;
+        end_block();
+        return result;
+    } else if (block_type == STATIC_HUFFMAN) {
+        dynamic_block = false;
+    } else if (block_type == DYNAMIC_HUFFMAN) {
+        auto result = decode_dynamic_huffman_header(trees);
+        if(!result) {
+            return result;
+        }
+        dynamic_block = true;
+    } else {
+        return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), block_number, "Compression type is RESERVED"});
     }
+    state = block_state::huffman;
+    return decode_success{0, 0};
+}
 
-    return decode_success{target_idx, read_buffer.offset()};
+// a full target or the last block stops the decoding
+void decoder::end_block() {
+    if (output_truncated) {
+        state = block_state::done;
+    } else if (last_block) {
+        finished = true;
+        state = block_state::done;
+    } else {
+        block_number++;
+        state = block_state::header;
+    }
 }
 
 decode_result decoder::decode_no_compress(uint8_t* target, size_t length) {
     read_buffer.skipt_to_byte();
 
-    if (read_buffer.left_bits() < 4) {
+    if (read_buffer.left_bits() < 32) {
         return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Unexpected end of input during read length of non-compressed block"});
     }
     auto ptr = read_buffer.data() + read_buffer.byte_offset();
 
-    auto len = *reinterpret_cast<uint16_t*>(ptr);
+    const uint16_t len = ptr[0] | (ptr[1] << 8);
     ptr += sizeof(len);
 
-    auto nlen = *reinterpret_cast<uint16_t*>(ptr);
+    const uint16_t nlen = ptr[0] | (ptr[1] << 8);
     ptr += sizeof(nlen);
 
     if((len ^ nlen) != 0xFFFF) {
         return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Corrupted data during read length of non-compressed block"});
     }
+    read_buffer.skip(2 * sizeof(len) * 8);
 
-    if (length - 2*sizeof(len) < len) {
-        return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Target data is too short"});
-    }
     if (read_buffer.left_bits()/8 < len) {
         return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Source data is too short"});
     }
+    if (length < len) { // only the prefix which fits is decoded
+        for(size_t i = 0; i < length; i++) {
+            target[i] = ptr[i];
+        }
+        output_truncated = true;
+        return decode_success{length, 0};
+    }
 
     for(size_t i = 0; i < len; i++) {
         target[i] = ptr[i];
@@ -124,10 +158,14 @@ decode_result decoder::decode_no_compress(uint8_t* target, size_t length) {
     return decode_success{len, (len + 2*sizeof(len)) * 8};
 }
 
-decode_result decoder::decode_with_huffman(uint8_t* target, size_t length, const huffman_tree<LITLEN_CODES>& tree, std::function<decode_result(uint32_t&)> read_dist_code) {
+decode_result decoder::decode_symbols(size_t symbols) {
     decode_success result{0, 0};
-    for(size_t target_offset = 0; target_offset < length; target_offset++) {
-        size_t init_buff_offset = read_buffer.offset();
+    const huffman_tree<LITLEN_CODES>& tree = dynamic_block ? trees.litlen_tree : static_huffman_tree;
+    uint8_t* target = output_begin;
+    const size_t length = output_length;
+    for(size_t n = 0; n < symbols; n++) {
+        const size_t target_offset = output_idx;
+        const size_t symbol_offset = read_buffer.offset();
 
         // read code
         huffman_dfa<LITLEN_CODES> dfa(tree);
@@ -140,24 +178,32 @@ decode_result decoder::decode_with_huffman(uint8_t* target, size_t length, const
 
 
         if(value < 256) { // literal code
+            if (target_offset >= length) { // the target is full, leave the symbol unread
+                read_buffer.seek(symbol_offset);
+                output_truncated = true;
+                end_block();
+                return result;
+            }
             target[target_offset] = value;
+            output_idx++;
             result.bytes_written++;
         } else if (value == 256) { // end of block
+            end_block();
             return result;
         } else if (value < LITLEN_CODES) { // length code
             const auto extra_bits = code_lengths_table[value - 256 - 1].extra_bits;
             const auto base_value = code_lengths_table[value - 256 - 1].base_value;
 
-            uint32_t length = 0;
-            if(extra_bits != read_buffer.read_bits(length, extra_bits)) {
+            uint32_t match_length = 0;
+            if(extra_bits != read_buffer.read_bits(match_length, extra_bits)) {
                 return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Unexpected end of buffer during extra bits read for length"});
             }
-            length = base_value + length;
+            match_length = base_value + match_length;
 
 
             // read distance code
             uint32_t dist_code = 0;
-            auto res = read_dist_code(dist_code);
+            auto res = dynamic_block ? decode_dynamic_huffman_distance_prototype(dist_code, trees.distance_tree) : decode_static_huffman_distance(dist_code);
             if(!res){
                 return res;
             }
@@ -171,27 +217,54 @@ decode_result decoder::decode_with_huffman(uint8_t* target, size_t length, const
             }
             distance = dist_base_value + distance;
 
-            // copy starting from -distance of length `length`
+            if (match_length > length - target_offset) { // only the prefix which fits is decoded
+                match_length = length - target_offset;
+                output_truncated = true;
+            }
+
+            // back-references may reach before the target into the dictionary
+            const size_t produced = target_offset;
+            const size_t dict_size = dict == nullptr ? 0 : dict->size();
+            if (distance > produced + dict_size) {
+                return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Distance is too far back"});
+            }
+
+            // copy starting from -distance of length `match_length`
+            size_t i = 0;
+            if (distance > produced) { // starts in the preset dictionary
+                const uint8_t* dict_source = dict->data() + dict_size - (distance - produced);
+                for(; i < match_length && i < distance - produced; i++) {
+                    target[target_offset + i] = dict_source[i];
+                }
+            }
             uint8_t* dist_target = target + target_offset - distance;
-            for(size_t i = 0; i < length; i++) {
+            for(; i < match_length; i++) {
                 target[target_offset + i] = dist_target[i];
             }
-            target_offset += length - 1;
-            result.bytes_written += length;
+            output_idx += match_length;
+            result.bytes_written += match_length;
+            if (output_truncated) {
+                end_block();
+                return result;
+            }
 
         } else {
             return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Unknown code"});
         }
     }
-
     return result;
 }
 
 decode_result decoder::decode_static_huffman_distance(uint32_t& dist_code){
     dist_code = 0;
-    if(read_buffer.read_bits(dist_code, 5) < 5) {
+    uint32_t reversed = 0;
+    if(read_buffer.read_bits(reversed, 5) < 5) {
         return unexpected(decode_failure{read_buffer.byte_offset(), read_buffer.offset(), 0, "Unexpected end of input during decoding static distance code"});
     }
+    // huffman codes are packed starting from the most significant bit
+    for(size_t i = 0; i < 5; i++) {
+        dist_code = (dist_code << 1) | ((reversed >> i) & 0x1);
+    }
     return decode_success{0, 5};
 }
 
@@ -214,7 +287,7 @@ decode_result decoder::decode_dynamic_huffman_distance_prototype(uint32_t& dist_
 
 decode_result decoder::decode_dynamic_huffman_header(dynamic_block_trees& trees) {
     if (read_buffer.left_bits() < 14) {
-        unexpected(decode_failure{0,0,0, "Buffer is too small for reading dynamic block header."});
+        return unexpected(decode_failure{0,0,0, "Buffer is too small for reading dynamic block header."});
     }
     uint8_t hlit = 0;
     uint8_t hdist = 0;
@@ -246,15 +319,21 @@ decode_result decoder::decode_dynamic_huffman_header(dynamic_block_trees& trees)
     huffman_tree<CLEN_CODES>::from_lengths(clen_tree, clen_lengths);
 
 
-    auto r = decode_tree_with_codelens(clen_tree, literal_codes, trees.litlen_tree);
-    if(!r) {
-        return r;
-    }
-    r = decode_tree_with_codelens(clen_tree, distance_codes, trees.distance_tree);
+    std::array<uint32_t, LITLEN_CODES + DISTANCE_CODES> lengths;
+    auto r = decode_codelens(clen_tree, literal_codes + distance_codes, lengths);
     if(!r) {
         return r;
     }
 
+    std::array<uint32_t, LITLEN_CODES> litlen_lengths;
+    litlen_lengths.fill(0);
+    std::copy(lengths.begin(), lengths.begin() + literal_codes, litlen_lengths.begin());
+    std::array<uint32_t, DISTANCE_CODES> distance_lengths;
+    distance_lengths.fill(0);
+    std::copy(lengths.begin() + literal_codes, lengths.begin() + literal_codes + distance_codes, distance_lengths.begin());
+
+    huffman_tree<LITLEN_CODES>::from_lengths(trees.litlen_tree, litlen_lengths);
+    huffman_tree<DISTANCE_CODES>::from_lengths(trees.distance_tree, distance_lengths);
 
     return decode_success{0, 0};
 }
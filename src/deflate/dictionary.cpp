@@ -0,0 +1,59 @@
+#include "checksum.hpp"
+#include "deflate/dictionary.hpp"
+
+namespace zipper::deflate
+{
+
+dictionary::dictionary(const uint8_t* source, size_t source_length)
+    : head(1u << HASH_BITS, NIL), id(zipper::adler32(source, source_length)) {
+    if (source_length > WINDOW_SIZE) {
+        source += source_length - WINDOW_SIZE;
+        source_length = WINDOW_SIZE;
+    }
+    bytes.assign(source, source + source_length);
+
+    prev.assign(bytes.size(), NIL);
+    for (size_t pos = 0; pos + MIN_MATCH <= bytes.size(); pos++) {
+        const uint32_t h = hash3(bytes.data() + pos, HASH_BITS);
+        prev[pos] = head[h];
+        head[h] = static_cast<uint16_t>(pos);
+    }
+}
+
+size_t dictionary::find_matches(const uint8_t* message, size_t message_length, size_t pos, uint32_t longer_than,
+                                uint32_t max_chain, uint32_t max_distance, match* matches) const {
+    if (message_length - pos < MIN_MATCH || bytes.size() < MIN_MATCH) {
+        return 0;
+    }
+    const uint8_t* cur = message + pos;
+    const uint32_t len_limit = message_length - pos < MAX_MATCH ? message_length - pos : MAX_MATCH;
+    uint32_t best = longer_than < MIN_MATCH - 1 ? MIN_MATCH - 1 : longer_than;
+    size_t found = 0;
+
+    // chains run from the end of the dictionary backwards, so distances only grow
+    for (uint16_t d = head[hash3(cur, HASH_BITS)]; d != NIL && max_chain > 0; d = prev[d], max_chain--) {
+        const size_t distance = pos + bytes.size() - d;
+        if (distance > max_distance) {
+            break;
+        }
+        uint32_t len = 0;
+        while (len < len_limit) {
+            const size_t src = d + len;
+            const uint8_t byte = src < bytes.size() ? bytes[src] : message[src - bytes.size()];
+            if (byte != cur[len]) {
+                break;
+            }
+            len++;
+        }
+        if (len > best) {
+            best = len;
+            matches[found++] = match{static_cast<uint16_t>(len), static_cast<uint16_t>(distance)};
+            if (len == len_limit) {
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+} // namespace zipper::deflate
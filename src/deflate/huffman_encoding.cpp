@@ -0,0 +1,124 @@
+#include <algorithm>
+#include "deflate/decoder.hpp"
+#include "deflate/huffman_encoding.hpp"
+
+namespace zipper::deflate
+{
+
+// largest alphabet of DEFLATE, the literal/length codes
+constexpr size_t MAX_SYMBOLS = LITLEN_CODES;
+
+void build_code_lengths(std::span<const uint32_t> frequencies, std::span<uint8_t> lengths, uint32_t max_bits) {
+    std::fill(lengths.begin(), lengths.end(), 0);
+
+    // called per block, the working storage stays on the stack
+    std::array<uint64_t, MAX_SYMBOLS> keys;
+    size_t n = 0;
+    for (uint32_t i = 0; i < frequencies.size(); i++) {
+        if (frequencies[i] != 0) {
+            // by frequency, ties by symbol
+            keys[n++] = static_cast<uint64_t>(frequencies[i]) << 32 | i;
+        }
+    }
+    if (n == 0) {
+        return;
+    }
+    if (n == 1) {
+        lengths[static_cast<uint32_t>(keys[0])] = 1;
+        return;
+    }
+    std::sort(keys.begin(), keys.begin() + n);
+    std::array<uint32_t, MAX_SYMBOLS> symbols;
+    for (size_t i = 0; i < n; i++) {
+        symbols[i] = static_cast<uint32_t>(keys[i]);
+    }
+
+    // two-queue Huffman construction: leaves are sorted, merged nodes are produced in order
+    std::array<uint64_t, 2 * MAX_SYMBOLS> weight;
+    std::array<uint32_t, 2 * MAX_SYMBOLS> parent;
+    for (size_t i = 0; i < n; i++) {
+        weight[i] = frequencies[symbols[i]];
+    }
+
+    size_t leaf = 0, inner = n, next = n;
+    auto pop_min = [&]() {
+        if (leaf < n && (inner >= next || weight[leaf] <= weight[inner])) {
+            return leaf++;
+        }
+        return inner++;
+    };
+    for (; next < 2 * n - 1; next++) {
+        const size_t a = pop_min();
+        const size_t b = pop_min();
+        weight[next] = weight[a] + weight[b];
+        parent[a] = static_cast<uint32_t>(next);
+        parent[b] = static_cast<uint32_t>(next);
+    }
+
+    // depths: the root is the last node, every other node is deeper than its parent
+    std::array<uint32_t, 2 * MAX_SYMBOLS> depth;
+    std::array<uint32_t, 64> count_per_length{};
+    for (size_t i = 2 * n - 1; i-- > 0;) {
+        depth[i] = i == 2 * n - 2 ? 0 : depth[parent[i]] + 1;
+        if (i < n) {
+            count_per_length[std::min<uint32_t>(depth[i], max_bits)]++;
+        }
+    }
+
+    // limit code lengths to max_bits and repair the Kraft sum
+    uint64_t total = 0;
+    for (uint32_t len = 1; len <= max_bits; len++) {
+        total += static_cast<uint64_t>(count_per_length[len]) << (max_bits - len);
+    }
+    while (total > (1ull << max_bits)) {
+        count_per_length[max_bits]--;
+        for (uint32_t len = max_bits - 1; len > 0; len--) {
+            if (count_per_length[len] != 0) {
+                count_per_length[len]--;
+                count_per_length[len + 1] += 2;
+                break;
+            }
+        }
+        total--;
+    }
+
+    // the most frequent symbols receive the shortest codes
+    size_t idx = n;
+    for (uint32_t len = 1; len <= max_bits; len++) {
+        for (uint32_t k = 0; k < count_per_length[len]; k++) {
+            lengths[symbols[--idx]] = len;
+        }
+    }
+}
+
+void build_codes(std::span<const uint8_t> lengths, std::span<uint16_t> codes) {
+    std::array<uint32_t, 16> count{};
+    for (uint8_t len : lengths) {
+        count[len]++;
+    }
+    count[0] = 0;
+
+    std::array<uint32_t, 16> next_code{};
+    uint32_t code = 0;
+    for (size_t bits = 1; bits < 16; bits++) {
+        code = (code + count[bits - 1]) << 1;
+        next_code[bits] = code;
+    }
+
+    for (size_t i = 0; i < lengths.size(); i++) {
+        const uint32_t len = lengths[i];
+        if (len == 0) {
+            codes[i] = 0;
+            continue;
+        }
+        uint32_t c = next_code[len]++;
+        uint32_t reversed = 0;
+        for (uint32_t b = 0; b < len; b++) {
+            reversed = (reversed << 1) | (c & 1);
+            c >>= 1;
+        }
+        codes[i] = static_cast<uint16_t>(reversed);
+    }
+}
+
+} // namespace zipper::deflate
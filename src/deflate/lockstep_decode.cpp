@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <array>
+#include <optional>
+#include "deflate/decoder.hpp"
+#include "deflate/lockstep_decode.hpp"
+
+namespace zipper::deflate
+{
+
+std::vector<decode_result> decode_lockstep(std::span<const stream_job> jobs, size_t lanes) {
+    lanes = std::clamp<size_t>(lanes, 1, MAX_LOCKSTEP_LANES);
+    std::vector<decode_result> results(jobs.size(), decode_success{0, 0});
+    std::array<std::optional<decoder>, MAX_LOCKSTEP_LANES> lane;
+    std::array<size_t, MAX_LOCKSTEP_LANES> job_of{};
+    size_t next = 0;
+    size_t active = 0;
+
+    // starts the next job on lane `i`, or leaves the lane empty once all jobs are taken
+    auto take_job = [&](size_t i) {
+        if (next == jobs.size()) {
+            lane[i].reset();
+            return false;
+        }
+        const auto& job = jobs[next];
+        lane[i].emplace(job.source, job.source_length);
+        lane[i]->start(job.target, job.target_length);
+        job_of[i] = next++;
+        return true;
+    };
+
+    for (size_t i = 0; i < lanes; i++) {
+        active += take_job(i);
+    }
+    while (active > 0) {
+        for (size_t i = 0; i < lanes; i++) {
+            if (!lane[i] || lane[i]->step(1)) {
+                continue;
+            }
+            results[job_of[i]] = lane[i]->progress();
+            active -= !take_job(i);
+        }
+    }
+    return results;
+}
+
+} // namespace zipper::deflate
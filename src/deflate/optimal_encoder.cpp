@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "deflate/optimal_encoder.hpp"
+#include "deflate/block_writer.hpp"
+#include "deflate/bt_match_finder.hpp"
+
+namespace zipper::deflate
+{
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+class deadline {
+    clock::time_point end;
+    bool limited;
+public:
+    explicit deadline(std::chrono::milliseconds budget) : end(clock::now() + budget), limited(budget.count() > 0) {}
+    bool expired() const { return limited && clock::now() >= end; }
+};
+
+// estimated cost in bits of every symbol, extra bits included
+struct cost_model {
+    std::array<float, LITLEN_CODES> litlen;
+    std::array<float, DISTANCE_CODES> distance;
+    std::array<float, MAX_MATCH + 1> length;
+
+    void finish() {
+        for (uint32_t i = 0; i < DISTANCE_CODES; i++) {
+            distance[i] += code_dist_table[i].extra_bits;
+        }
+        for (uint32_t len = MIN_MATCH; len <= MAX_MATCH; len++) {
+            length[len] = litlen[length_symbol(len)] + length_extra_bits(len);
+        }
+    }
+
+    float match(uint32_t len, uint32_t dist) const { return length[len] + distance[distance_symbol(dist)]; }
+
+    static cost_model fixed() {
+        cost_model m;
+        for (size_t i = 0; i < LITLEN_CODES; i++) {
+            m.litlen[i] = i <= 143 ? 8 : i <= 255 ? 9 : i <= 279 ? 7 : 8;
+        }
+        m.distance.fill(5);
+        m.finish();
+        return m;
+    }
+
+    template<size_t n_codes>
+    static void entropy(const std::array<uint32_t, n_codes>& counts, std::array<float, n_codes>& bits) {
+        uint64_t total = 0;
+        for (auto c : counts) {
+            total += c;
+        }
+        const float log_total = total == 0 ? 0 : std::log2(static_cast<float>(total));
+        for (size_t i = 0; i < n_codes; i++) {
+            bits[i] = counts[i] == 0 ? log_total : log_total - std::log2(static_cast<float>(counts[i]));
+        }
+    }
+
+    static cost_model from_statistics(const block_statistics& stats) {
+        cost_model m;
+        entropy(stats.litlen, m.litlen);
+        entropy(stats.distance, m.distance);
+        m.finish();
+        return m;
+    }
+};
+
+// all matches of a master block, matches of position `i` are all[offsets[i - base] .. offsets[i - base + 1])
+struct match_cache {
+    size_t base;
+    std::vector<uint32_t> offsets;
+    std::vector<match> all;
+};
+
+// candidates per position once the time budget has run out
+constexpr uint32_t EXPIRED_SEARCH_DEPTH = 4;
+
+match_cache find_all_matches(bt_match_finder& finder, size_t begin, size_t end, const deadline& limit) {
+    match_cache cache{begin, {}, {}};
+    cache.offsets.reserve(end - begin + 1);
+    cache.all.reserve(end - begin);
+
+    std::array<match, MAX_MATCH + 1> found;
+    size_t skip_until = begin;
+    for (size_t pos = begin; pos < end; pos++) {
+        cache.offsets.push_back(cache.all.size());
+        if ((pos - begin) % 4096 == 0 && limit.expired()) {
+            // the search dominates at high depths, the rest of the input gets a shallow one
+            finder.set_depth(EXPIRED_SEARCH_DEPTH);
+        }
+        if (pos < skip_until) {
+            // inside a maximal match, a shorter match here cannot do much better
+            finder.skip(pos);
+            continue;
+        }
+        const size_t n = finder.find_matches(pos, found.data());
+        cache.all.insert(cache.all.end(), found.begin(), found.begin() + n);
+        if (n != 0 && found[n - 1].length == MAX_MATCH) {
+            skip_until = pos + MAX_MATCH;
+        }
+    }
+    cache.offsets.push_back(cache.all.size());
+    return cache;
+}
+
+// shortest path through the graph of literals and matches of data[begin..end) under `model`
+std::vector<lz77_symbol> parse(const uint8_t* data, size_t begin, size_t end, const match_cache& cache, const cost_model& model) {
+    const size_t n = end - begin;
+    std::vector<float> cost(n + 1, std::numeric_limits<float>::infinity());
+    std::vector<lz77_symbol> arrival(n + 1);
+    cost[0] = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        const float here = cost[i];
+        const float literal = here + model.litlen[data[begin + i]];
+        if (literal < cost[i + 1]) {
+            cost[i + 1] = literal;
+            arrival[i + 1] = lz77_symbol::literal(data[begin + i]);
+        }
+
+        const size_t first = cache.offsets[begin + i - cache.base];
+        const size_t last = cache.offsets[begin + i - cache.base + 1];
+        uint32_t len = MIN_MATCH;
+        for (size_t m = first; m < last; m++) {
+            const uint32_t max_len = std::min<size_t>(cache.all[m].length, n - i);
+            const uint32_t dist = cache.all[m].distance;
+            for (; len <= max_len; len++) {
+                const float c = here + model.match(len, dist);
+                if (c < cost[i + len]) {
+                    cost[i + len] = c;
+                    arrival[i + len] = lz77_symbol::match(len, dist);
+                }
+            }
+        }
+    }
+
+    std::vector<lz77_symbol> symbols;
+    for (size_t pos = n; pos > 0;) {
+        symbols.push_back(arrival[pos]);
+        pos -= arrival[pos].is_literal() ? 1 : arrival[pos].length;
+    }
+    std::reverse(symbols.begin(), symbols.end());
+    return symbols;
+}
+
+size_t symbols_cost(std::span<const lz77_symbol> symbols) {
+    const auto stats = block_statistics::from_symbols(symbols);
+    return std::min(block_writer::static_cost(stats), block_writer::dynamic_cost(stats));
+}
+
+// iterates parse -> statistics -> cost model, keeps the cheapest parse
+std::vector<lz77_symbol> optimize(const uint8_t* data, size_t begin, size_t end, const match_cache& cache,
+                                  std::vector<lz77_symbol> best, uint32_t iterations, const deadline& limit) {
+    cost_model model = cost_model::fixed();
+    if (best.empty() && end > begin) {
+        best = parse(data, begin, end, cache, model);
+    }
+    size_t best_cost = symbols_cost(best);
+    auto current = best;
+
+    for (uint32_t i = 0; i < iterations && !limit.expired(); i++) {
+        model = cost_model::from_statistics(block_statistics::from_symbols(current));
+        current = parse(data, begin, end, cache, model);
+        const size_t c = symbols_cost(current);
+        if (c < best_cost) {
+            best_cost = c;
+            best = current;
+        }
+    }
+    return best;
+}
+
+// Splits symbols into blocks where separate code tables pay for their headers.
+// Returns indices of the first symbol of every block but the first one.
+std::vector<size_t> split_blocks(std::span<const lz77_symbol> symbols, const std::vector<size_t>& positions, uint32_t max_blocks) {
+    auto range_cost = [&](size_t a, size_t b) {
+        const auto stats = block_statistics::from_symbols(symbols.subspan(a, b - a));
+        return block_writer::best_cost(stats, positions[b] - positions[a], 0);
+    };
+    auto split_cost = [&](size_t a, size_t p, size_t b) { return range_cost(a, p) + range_cost(p, b); };
+
+    // finds a split point of [a, b) with a locally minimal cost
+    auto find_minimum = [&](size_t a, size_t b) {
+        size_t start = a + 1, end = b;
+        if (end - start < 1024) {
+            size_t best = start;
+            size_t best_cost = std::numeric_limits<size_t>::max();
+            for (size_t p = start; p < end; p++) {
+                const size_t c = split_cost(a, p, b);
+                if (c < best_cost) {
+                    best_cost = c;
+                    best = p;
+                }
+            }
+            return best;
+        }
+
+        constexpr size_t SAMPLES = 9;
+        size_t best = start;
+        size_t last_best_cost = std::numeric_limits<size_t>::max();
+        while (end - start > SAMPLES) {
+            std::array<size_t, SAMPLES> points;
+            std::array<size_t, SAMPLES> costs;
+            size_t best_idx = 0;
+            for (size_t i = 0; i < SAMPLES; i++) {
+                points[i] = start + (i + 1) * ((end - start) / (SAMPLES + 1));
+                costs[i] = split_cost(a, points[i], b);
+                if (costs[i] < costs[best_idx]) {
+                    best_idx = i;
+                }
+            }
+            if (costs[best_idx] > last_best_cost) {
+                break;
+            }
+            start = best_idx == 0 ? start : points[best_idx - 1];
+            end = best_idx == SAMPLES - 1 ? end : points[best_idx + 1];
+            best = points[best_idx];
+            last_best_cost = costs[best_idx];
+        }
+        return best;
+    };
+
+    std::vector<size_t> splits;
+    std::vector<size_t> done; // block starts which are not worth splitting
+    while (splits.size() + 1 < max_blocks) {
+        // the longest block not examined yet
+        size_t a = 0, b = 0, longest = 0;
+        for (size_t i = 0; i <= splits.size(); i++) {
+            const size_t s = i == 0 ? 0 : splits[i - 1];
+            const size_t e = i == splits.size() ? symbols.size() : splits[i];
+            if (e - s > 10 && positions[e] - positions[s] > longest && std::find(done.begin(), done.end(), s) == done.end()) {
+                longest = positions[e] - positions[s];
+                a = s;
+                b = e;
+            }
+        }
+        if (longest == 0) {
+            break;
+        }
+
+        const size_t p = find_minimum(a, b);
+        if (p > a && p < b && split_cost(a, p, b) < range_cost(a, b)) {
+            splits.insert(std::upper_bound(splits.begin(), splits.end(), p), p);
+        } else {
+            done.push_back(a);
+        }
+    }
+    return splits;
+}
+
+} // namespace
+
+size_t compress_bound(size_t source_length) {
+    return source_length + 5 * (source_length / 16383 + 1) + 16;
+}
+
+encode_result optimal_encoder::encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) {
+    const deadline limit(options.time_budget);
+    bit_buffer buffer(target, target_length, 0);
+    block_writer writer(buffer);
+
+    if (source_length == 0) {
+        auto r = options.last ? writer.write_static({}, true) : writer.write_stored(nullptr, 0, false);
+        if (!r) {
+            return r;
+        }
+        writer.align();
+        return encode_success{0, buffer.byte_offset()};
+    }
+
+    bt_match_finder finder(source, source_length, options.search_depth, dict.get());
+    const size_t master = options.master_block_size == 0 ? source_length : options.master_block_size;
+
+    for (size_t base = 0; base < source_length; base += master) {
+        const size_t end = std::min(source_length, base + master);
+        const bool final = options.last && end == source_length;
+
+        const auto cache = find_all_matches(finder, base, end, limit);
+        const auto symbols = optimize(source, base, end, cache, {}, options.iterations, limit);
+
+        std::vector<size_t> positions(symbols.size() + 1);
+        positions[0] = base;
+        for (size_t i = 0; i < symbols.size(); i++) {
+            positions[i + 1] = positions[i] + (symbols[i].is_literal() ? 1 : symbols[i].length);
+        }
+        auto splits = split_blocks(symbols, positions, options.max_blocks);
+        splits.push_back(symbols.size());
+
+        size_t first = 0;
+        for (size_t last : splits) {
+            const size_t block_begin = positions[first];
+            const size_t block_end = positions[last];
+            std::vector<lz77_symbol> block(symbols.begin() + first, symbols.begin() + last);
+            if (splits.size() > 1) {
+                // statistics of the block alone describe it better than those of the whole input
+                block = optimize(source, block_begin, block_end, cache, std::move(block), options.iterations, limit);
+            }
+
+            auto r = writer.write_block(block, source + block_begin, block_end - block_begin, final && last == symbols.size());
+            if (!r) {
+                return r;
+            }
+            first = last;
+        }
+    }
+
+    if (!options.last) {
+        auto r = writer.write_stored(nullptr, 0, false);
+        if (!r) {
+            return r;
+        }
+    }
+    writer.align();
+    return encode_success{source_length, buffer.byte_offset()};
+}
+
+} // namespace zipper::deflate
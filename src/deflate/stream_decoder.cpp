@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cstring>
+#include "deflate/huffman_dfa.hpp"
+#include "deflate/lz77.hpp"
+#include "deflate/stream_decoder.hpp"
+
+namespace zipper::deflate
+{
+
+static huffman_tree<DISTANCE_CODES> build_static_distance_tree() {
+    std::array<uint32_t, DISTANCE_CODES> lengths;
+    lengths.fill(5);
+    return huffman_tree<DISTANCE_CODES>(lengths);
+}
+
+static const huffman_tree<DISTANCE_CODES> static_distance_tree = build_static_distance_tree();
+
+stream_decoder::stream_decoder(const dictionary* preset) : window(RING_SIZE), dict(preset) {}
+
+void stream_decoder::reset() {
+    input.clear();
+    input_bit = 0;
+    consumed = 0;
+    produced = 0;
+    current = state::block_header;
+    last_block = false;
+    block_number = 0;
+    pending_length = 0;
+}
+
+void stream_decoder::feed(const uint8_t* data, size_t length) {
+    // drop fully consumed bytes before growing the buffer
+    const size_t drop = input_bit / 8;
+    if (drop != 0) {
+        input.erase(input.begin(), input.begin() + drop);
+        consumed += drop;
+        input_bit -= drop * 8;
+    }
+    input.insert(input.end(), data, data + length);
+}
+
+std::span<const uint8_t> stream_decoder::unused_input() const {
+    const size_t used = std::min(input.size(), (input_bit + 7) / 8);
+    return std::span<const uint8_t>(input.data() + used, input.size() - used);
+}
+
+template<size_t n_codes>
+stream_decoder::step stream_decoder::read_symbol(bit_buffer& in, const huffman_tree<n_codes>& tree, uint32_t& value) {
+    huffman_dfa<n_codes> dfa(tree);
+    while (dfa.ok() && !dfa.accepted()) {
+        if (in.eob()) {
+            return step::incomplete;
+        }
+        dfa.consume(in.read_bit());
+    }
+    if (!dfa.ok()) {
+        return step::invalid;
+    }
+    value = dfa.value();
+    return step::ok;
+}
+
+stream_decoder::step stream_decoder::read_dynamic_header(bit_buffer& in, const char*& message) {
+    if (in.left_bits() < 14) {
+        return step::incomplete;
+    }
+    uint32_t hlit = 0, hdist = 0, hclen = 0;
+    in.read_bits(hlit, 5);
+    in.read_bits(hdist, 5);
+    in.read_bits(hclen, 4);
+    const uint32_t literal_codes = hlit + 257;
+    const uint32_t distance_codes = hdist + 1;
+
+    constexpr std::array<uint8_t, CL_CODES> clen_order = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    std::array<uint32_t, CL_CODES> clen_lengths;
+    clen_lengths.fill(0);
+    if (in.left_bits() < 3 * (hclen + 4)) {
+        return step::incomplete;
+    }
+    for (size_t i = 0; i < hclen + 4; i++) {
+        in.read_bits(clen_lengths[clen_order[i]], 3);
+    }
+    huffman_tree<CL_CODES> clen_tree(clen_lengths);
+
+    std::array<uint32_t, LITLEN_CODES + DISTANCE_CODES> lengths;
+    lengths.fill(0);
+    for (uint32_t i = 0; i < literal_codes + distance_codes;) {
+        uint32_t value = 0;
+        const step s = read_symbol(in, clen_tree, value);
+        if (s != step::ok) {
+            message = "Unknown code of code length";
+            return s;
+        }
+        if (value <= 15) {
+            lengths[i++] = value;
+            continue;
+        }
+        const auto& entry = clcl_table[value - 16];
+        uint32_t repeats = 0;
+        if (in.read_bits(repeats, entry.extra_bits) < entry.extra_bits) {
+            return step::incomplete;
+        }
+        repeats += entry.base_value;
+        if (i + repeats > literal_codes + distance_codes || (value == 16 && i == 0)) {
+            message = "Invalid repeat of code length";
+            return step::invalid;
+        }
+        const uint32_t repeated = value == 16 ? lengths[i - 1] : 0;
+        for (uint32_t j = 0; j < repeats; j++) {
+            lengths[i++] = repeated;
+        }
+    }
+
+    std::array<uint32_t, LITLEN_CODES> litlen_lengths;
+    litlen_lengths.fill(0);
+    std::copy(lengths.begin(), lengths.begin() + literal_codes, litlen_lengths.begin());
+    std::array<uint32_t, DISTANCE_CODES> distance_lengths;
+    distance_lengths.fill(0);
+    std::copy(lengths.begin() + literal_codes, lengths.begin() + literal_codes + distance_codes, distance_lengths.begin());
+
+    huffman_tree<LITLEN_CODES>::from_lengths(litlen_tree, litlen_lengths);
+    huffman_tree<DISTANCE_CODES>::from_lengths(distance_tree, distance_lengths);
+    return step::ok;
+}
+
+void stream_decoder::copy_match(uint8_t* target, size_t target_length, size_t& written) {
+    if (produced < pending_distance) {
+        // the match starts in the dictionary
+        const size_t dict_size = dict->size();
+        for (; pending_length > 0 && written < target_length; pending_length--) {
+            const uint8_t byte = produced >= pending_distance
+                ? window.data()[(produced - pending_distance) & (RING_SIZE - 1)]
+                : dict->data()[dict_size - (pending_distance - produced)];
+            emit(target, written, byte);
+        }
+        return;
+    }
+
+    const size_t n = std::min<size_t>(pending_length, target_length - written);
+    // in the mirror the source always lies linearly before the destination
+    size_t pos = produced & (RING_SIZE - 1);
+    if (pos < pending_distance) {
+        pos += RING_SIZE;
+    }
+    uint8_t* dst = window.data() + pos;
+    const uint8_t* src = dst - pending_distance;
+    if (pending_distance >= 8) {
+        // every chunk reads bytes which are final already, the tail may overrun by up to 7
+        for (size_t i = 0; i < n; i += 8) {
+            std::memcpy(dst + i, src + i, 8);
+        }
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = src[i];
+        }
+    }
+    window.commit(pos, n);
+    std::memcpy(target + written, dst, n);
+    written += n;
+    produced += n;
+    pending_length -= n;
+}
+
+stream_result stream_decoder::decode(uint8_t* target, size_t target_length, size_t& written) {
+    written = 0;
+    bit_buffer in(input.data(), input.size(), input_bit);
+    const size_t dict_size = dict == nullptr ? 0 : dict->size();
+
+    // every step either completes or rewinds to `snapshot` and asks for more input
+    auto suspend = [&](size_t snapshot, stream_status status) -> stream_result {
+        in.seek(snapshot);
+        input_bit = snapshot;
+        return status;
+    };
+
+    for (;;) {
+        const size_t snapshot = in.offset();
+        switch (current) {
+        case state::done:
+            input_bit = in.offset();
+            return stream_status::done;
+
+        case state::block_header: {
+            if (in.left_bits() < 3) {
+                return suspend(snapshot, stream_status::need_input);
+            }
+            uint32_t type = 0;
+            last_block = in.read_bit();
+            in.read_bits(type, 2);
+            if (type == NO_COMPRESSION) {
+                current = state::stored_header;
+            } else if (type == STATIC_HUFFMAN) {
+                static_block = true;
+                current = state::huffman_symbols;
+            } else if (type == DYNAMIC_HUFFMAN) {
+                const char* message = "Invalid dynamic block header";
+                const step s = read_dynamic_header(in, message);
+                if (s == step::incomplete) {
+                    return suspend(snapshot, stream_status::need_input);
+                }
+                if (s == step::invalid) {
+                    return unexpected(failure(in, message));
+                }
+                static_block = false;
+                current = state::huffman_symbols;
+            } else {
+                return unexpected(failure(in, "Compression type is RESERVED"));
+            }
+            break;
+        }
+
+        case state::stored_header: {
+            in.skipt_to_byte();
+            if (in.left_bits() < 32) {
+                return suspend(snapshot, stream_status::need_input);
+            }
+            uint32_t len = 0, nlen = 0;
+            in.read_bits(len, 16);
+            in.read_bits(nlen, 16);
+            if ((len ^ nlen) != 0xFFFF) {
+                return unexpected(failure(in, "Corrupted data during read length of non-compressed block"));
+            }
+            stored_left = len;
+            current = state::stored_data;
+            break;
+        }
+
+        case state::stored_data: {
+            const size_t available = in.left_bits() / 8;
+            const size_t n = std::min<size_t>({stored_left, available, target_length - written});
+            const uint8_t* data = in.data() + in.byte_offset();
+            const size_t pos = produced & (RING_SIZE - 1);
+            std::copy_n(data, n, window.data() + pos);
+            window.commit(pos, n);
+            std::copy_n(data, n, target + written);
+            written += n;
+            produced += n;
+            in.skip(n * 8);
+            stored_left -= n;
+            if (stored_left == 0) {
+                current = last_block ? state::done : state::block_header;
+                block_number++;
+                break;
+            }
+            input_bit = in.offset();
+            return written == target_length ? stream_status::need_output : stream_status::need_input;
+        }
+
+        case state::huffman_symbols: {
+            if (pending_length > 0) {
+                copy_match(target, target_length, written);
+                if (pending_length > 0) {
+                    input_bit = in.offset();
+                    return stream_status::need_output;
+                }
+            }
+
+            const auto& litlen = static_block ? decoder::static_litlen_tree() : litlen_tree;
+            uint32_t value = 0;
+            step s = read_symbol(in, litlen, value);
+            if (s == step::incomplete) {
+                return suspend(snapshot, stream_status::need_input);
+            }
+            if (s == step::invalid || value > 285) {
+                return unexpected(failure(in, "Unknown code"));
+            }
+
+            if (value < END_OF_BLOCK) {
+                if (written == target_length) {
+                    return suspend(snapshot, stream_status::need_output);
+                }
+                emit(target, written, static_cast<uint8_t>(value));
+                break;
+            }
+            if (value == END_OF_BLOCK) {
+                current = last_block ? state::done : state::block_header;
+                block_number++;
+                break;
+            }
+
+            const auto& length_entry = code_lengths_table[value - 257];
+            uint32_t length = 0;
+            if (in.read_bits(length, length_entry.extra_bits) < length_entry.extra_bits) {
+                return suspend(snapshot, stream_status::need_input);
+            }
+            length += length_entry.base_value;
+
+            uint32_t dist_code = 0;
+            s = read_symbol(in, static_block ? static_distance_tree : distance_tree, dist_code);
+            if (s == step::incomplete) {
+                return suspend(snapshot, stream_status::need_input);
+            }
+            if (s == step::invalid || dist_code >= 30) {
+                return unexpected(failure(in, "Unknown code for distance"));
+            }
+            const auto& dist_entry = code_dist_table[dist_code];
+            uint32_t distance = 0;
+            if (in.read_bits(distance, dist_entry.extra_bits) < dist_entry.extra_bits) {
+                return suspend(snapshot, stream_status::need_input);
+            }
+            distance += dist_entry.base_value;
+            if (distance > produced + dict_size) {
+                return unexpected(failure(in, "Distance is too far back"));
+            }
+
+            pending_length = length;
+            pending_distance = distance;
+            break;
+        }
+        }
+    }
+}
+
+} // namespace zipper::deflate
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "deflate/block_writer.hpp"
+#include "deflate/stream_encoder.hpp"
+
+namespace zipper::deflate
+{
+
+// a match at a position can only be searched with this much input after it, or at a flush
+constexpr size_t MIN_LOOKAHEAD = MAX_MATCH + MIN_MATCH + 1;
+// positions inside longer matches are not added to the hash chains
+constexpr uint32_t MAX_INSERT_LENGTH = 32;
+
+// random values per byte for the gear hash, its top bits depend on the last 64 bytes
+static constexpr std::array<uint64_t, 256> gear_table = [] {
+    std::array<uint64_t, 256> t{};
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (auto& v : t) {
+        // splitmix64
+        x += 0x9E3779B97F4A7C15ull;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        v = z ^ (z >> 31);
+    }
+    return t;
+}();
+
+namespace
+{
+
+// the sizes the encoder derives from its options, shared with `compress_bound`
+struct stream_geometry {
+    uint32_t window_bits;
+    uint32_t memory_level;
+    uint32_t window_size;
+    size_t block_symbols;
+    uint32_t rsync_bits;
+    size_t rsync_min;
+};
+
+stream_geometry geometry_of(const stream_options& options) {
+    stream_geometry g;
+    g.window_bits = std::clamp<uint32_t>(options.window_bits, 9, 15);
+    g.memory_level = std::clamp<uint32_t>(options.memory_level, 1, 9);
+    g.window_size = 1u << g.window_bits;
+    g.block_symbols = size_t(1) << (g.memory_level + 6);
+    // A run of one byte value can hash to a cut point at every position. A cut point further than
+    // max_distance would have to end a block where the window slides, which depends on the offset
+    // in the stream rather than on the content; with cuts on average a quarter window apart few
+    // come from that limit.
+    g.rsync_bits = std::min(std::max<uint32_t>(options.rsync_bits, 8), g.window_bits - 2);
+    g.rsync_min = std::min<size_t>(size_t(1) << (g.rsync_bits - 2), (g.window_size - MIN_LOOKAHEAD) / 2);
+    return g;
+}
+
+} // namespace
+
+size_t compress_bound(size_t source_length, const stream_options& options) {
+    const stream_geometry g = geometry_of(options);
+    // Every block costs at most its stored form, which is the data plus at most 6 bytes per
+    // stored block of up to MAX_STORED_BLOCK bytes. A block ends when it is full, where the window
+    // slides and at the end of the stream; with `rsyncable` also at each cut point, which adds an
+    // empty stored block of its own.
+    size_t blocks = source_length / g.block_symbols + source_length / g.window_size + source_length / MAX_STORED_BLOCK + 3;
+    if (options.rsyncable) {
+        blocks += 2 * (source_length / g.rsync_min + 1);
+    }
+    return source_length + 6 * blocks;
+}
+
+stream_encoder::stream_encoder(stream_options options) {
+    const stream_geometry g = geometry_of(options);
+    window_size = g.window_size;
+    max_distance = window_size - MIN_LOOKAHEAD;
+    hash_bits = std::min<uint32_t>(g.memory_level + 7, 16);
+    max_chain = std::max<uint32_t>(options.max_chain, 1);
+    block_symbols = g.block_symbols;
+    strategy = options.strategy;
+    hashing = strategy == compression_strategy::lz77 || strategy == compression_strategy::static_only;
+    rsyncable = options.rsyncable;
+    rsync_mask = ~uint64_t{0} << (64 - g.rsync_bits);
+    rsync_max = max_distance;
+    rsync_min = g.rsync_min;
+
+    window.resize(2 * window_size);
+    head.resize(size_t(1) << hash_bits);
+    prev.resize(window_size);
+    symbols.reserve(block_symbols);
+    // a block of static codes takes at most 4 bytes per symbol, and a flush adds an empty stored block
+    pending_output.resize(4 * block_symbols + 32);
+}
+
+size_t stream_encoder::memory_usage() const {
+    return window.capacity() + head.capacity() * sizeof(uint16_t) + prev.capacity() * sizeof(uint16_t)
+        + symbols.capacity() * sizeof(lz77_symbol) + pending_output.capacity();
+}
+
+void stream_encoder::reset() {
+    if (hashing) {
+        std::fill(head.begin(), head.end(), 0);
+    }
+    strstart = 0;
+    lookahead = 0;
+    block_start = 0;
+    history_start = 0;
+    symbols.clear();
+    rolling = 0;
+    scanned = 0;
+    since_boundary = 0;
+    boundary = NO_BOUNDARY;
+    pending_bits = 0;
+    pending_offset = 0;
+    consumed = 0;
+    produced = 0;
+    dirty = false;
+    done = false;
+}
+
+uint32_t stream_encoder::insert(size_t pos) {
+    const uint32_t h = hash3(window.data() + pos, hash_bits);
+    const uint32_t candidate = head[h];
+    prev[pos & (window_size - 1)] = candidate;
+    head[h] = static_cast<uint16_t>(pos);
+    return candidate;
+}
+
+match stream_encoder::longest_match(size_t pos, uint32_t candidate, uint32_t limit) const {
+    const uint8_t* cur = window.data() + pos;
+    const size_t lowest = pos > max_distance ? pos - max_distance : 0;
+    match best{0, 0};
+    for (uint32_t chain = max_chain; candidate > lowest && chain > 0; chain--) {
+        const uint8_t* p = window.data() + candidate;
+        if (p[best.length] == cur[best.length]) {
+            uint32_t len = 0;
+            while (len < limit && p[len] == cur[len]) {
+                len++;
+            }
+            if (len > best.length) {
+                best = match{static_cast<uint16_t>(len), static_cast<uint16_t>(pos - candidate)};
+                if (len == limit) {
+                    break;
+                }
+            }
+        }
+        candidate = prev[candidate & (window_size - 1)];
+    }
+    return best;
+}
+
+match stream_encoder::run_match(size_t pos, uint32_t limit) const {
+    if (pos <= history_start) {
+        return match{0, 0};
+    }
+    const uint8_t* cur = window.data() + pos;
+    const uint8_t byte = cur[-1];
+    uint32_t len = 0;
+    while (len < limit && cur[len] == byte) {
+        len++;
+    }
+    return match{static_cast<uint16_t>(len), 1};
+}
+
+void stream_encoder::compress(bool flushing) {
+    // up to a boundary the input is complete, as at a flush
+    const bool to_end = flushing || boundary != NO_BOUNDARY;
+    const size_t end = boundary != NO_BOUNDARY ? boundary : strstart + lookahead;
+    if (strategy == compression_strategy::huffman_only) {
+        // the block writer takes the literals straight from the window
+        const size_t n = std::min({end - strstart, block_start + block_symbols - strstart, window_size + max_distance - strstart});
+        strstart += n;
+        lookahead -= n;
+        return;
+    }
+    while (symbols.size() < block_symbols && strstart < window_size + max_distance
+           && (end - strstart >= MIN_LOOKAHEAD || (to_end && end > strstart))) {
+        const size_t available = end - strstart;
+        match m{0, 0};
+        if (strategy == compression_strategy::rle) {
+            m = run_match(strstart, std::min<size_t>(MAX_MATCH, available));
+        } else if (available >= MIN_MATCH) {
+            const uint32_t candidate = insert(strstart);
+            m = longest_match(strstart, candidate, std::min<size_t>(MAX_MATCH, available));
+        }
+        if (m.length < MIN_MATCH) {
+            symbols.push_back(lz77_symbol::literal(window[strstart]));
+            strstart++;
+            lookahead--;
+            continue;
+        }
+
+        symbols.push_back(lz77_symbol::match(m.length, m.distance));
+        if (hashing && m.length <= MAX_INSERT_LENGTH) {
+            for (size_t pos = strstart + 1; pos < strstart + m.length && pos + MIN_MATCH <= end; pos++) {
+                insert(pos);
+            }
+        }
+        strstart += m.length;
+        lookahead -= m.length;
+    }
+}
+
+void stream_encoder::find_boundary() {
+    const size_t end = strstart + lookahead;
+    for (; boundary == NO_BOUNDARY && scanned < end; scanned++) {
+        rolling = (rolling << 1) + gear_table[window[scanned]];
+        since_boundary++;
+        if (((rolling & rsync_mask) == 0 && since_boundary >= rsync_min) || since_boundary == rsync_max) {
+            boundary = scanned + 1;
+            since_boundary = 0;
+        }
+    }
+}
+
+void stream_encoder::slide() {
+    std::memcpy(window.data(), window.data() + window_size, window_size);
+    strstart -= window_size;
+    block_start -= window_size;
+    history_start = history_start > window_size ? history_start - window_size : 0;
+    if (rsyncable) {
+        scanned -= window_size;
+        if (boundary != NO_BOUNDARY) {
+            boundary -= window_size;
+        }
+    }
+    if (hashing) {
+        auto rebase = [this](uint16_t& pos) { pos = pos >= window_size ? pos - window_size : 0; };
+        std::for_each(head.begin(), head.end(), rebase);
+        std::for_each(prev.begin(), prev.end(), rebase);
+    }
+}
+
+size_t stream_encoder::fill_window(const uint8_t* source, size_t length) {
+    const size_t end = strstart + lookahead;
+    const size_t n = std::min(window.size() - end, length);
+    std::memcpy(window.data() + end, source, n);
+    lookahead += n;
+    return n;
+}
+
+void stream_encoder::emit_block(bool final) {
+    bit_buffer buffer(pending_output.data(), pending_output.size(), pending_bits);
+    block_writer writer(buffer);
+    // the buffer is sized for the largest block, this cannot fail
+    const uint8_t* data = window.data() + block_start;
+    const size_t length = strstart - block_start;
+    if (strategy == compression_strategy::huffman_only) {
+        writer.write_literal_block(data, length, final);
+    } else if (strategy == compression_strategy::static_only) {
+        writer.write_fixed_block(symbols, data, length, final);
+    } else {
+        writer.write_block(symbols, data, length, final);
+    }
+    pending_bits = buffer.offset();
+    symbols.clear();
+    block_start = strstart;
+}
+
+void stream_encoder::emit_flush(flush_mode flush) {
+    if (flush == flush_mode::finish || strstart > block_start) {
+        emit_block(flush == flush_mode::finish);
+    }
+    bit_buffer buffer(pending_output.data(), pending_output.size(), pending_bits);
+    block_writer writer(buffer);
+    if (flush == flush_mode::finish) {
+        writer.align();
+    } else {
+        writer.write_stored(nullptr, 0, false);
+    }
+    pending_bits = buffer.offset();
+
+    if (flush == flush_mode::full_flush) {
+        history_start = strstart;
+        if (hashing) {
+            std::fill(head.begin(), head.end(), 0);
+        }
+    }
+}
+
+size_t stream_encoder::drain(uint8_t* target, size_t length) {
+    const size_t n = std::min(pending(), length);
+    std::memcpy(target, pending_output.data() + pending_offset, n);
+    pending_offset += n;
+    if (pending() == 0) {
+        // keep the partial last byte at the front
+        pending_output[0] = pending_output[pending_offset];
+        pending_bits %= 8;
+        pending_offset = 0;
+    }
+    return n;
+}
+
+encode_result stream_encoder::encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) {
+    reset();
+    auto result = encode(source, source_length, target, target_length, flush_mode::finish);
+    if (result && pending() > 0) {
+        return unexpected(encode_failure{result->bytes_written, "Target buffer is too small"});
+    }
+    return result;
+}
+
+encode_result stream_encoder::encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length, flush_mode flush) {
+    if (done && pending() == 0) {
+        return unexpected(encode_failure{0, "Stream is already finished"});
+    }
+    size_t read = 0, written = 0;
+    for (;;) {
+        written += drain(target + written, target_length - written);
+        if (pending() > 0 || done) {
+            break;
+        }
+        if (block_full()) {
+            emit_block(false);
+            continue;
+        }
+        if (strstart >= window_size + max_distance) {
+            if (block_start < window_size && strstart > block_start) {
+                // the block refers to the bytes about to be dropped
+                emit_block(false);
+                continue;
+            }
+            slide();
+        }
+
+        if (read < source_length) {
+            const size_t n = fill_window(source + read, source_length - read);
+            read += n;
+            dirty |= n > 0;
+        }
+        if (rsyncable) {
+            if (strstart == boundary) {
+                emit_flush(flush_mode::full_flush);
+                boundary = NO_BOUNDARY;
+                continue;
+            }
+            find_boundary();
+        }
+        const bool flushing = read == source_length && flush != flush_mode::no_flush;
+        if (lookahead >= MIN_LOOKAHEAD || (flushing && lookahead > 0) || boundary != NO_BOUNDARY) {
+            compress(flushing);
+            continue;
+        }
+        if (read < source_length) {
+            continue;
+        }
+        if (flush == flush_mode::no_flush || (!dirty && flush != flush_mode::finish)) {
+            break;
+        }
+        emit_flush(flush);
+        dirty = false;
+        done = flush == flush_mode::finish;
+    }
+    consumed += read;
+    produced += written;
+    return encode_success{read, written};
+}
+
+} // namespace zipper::deflate
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include "gzip/bgzf_reader.hpp"
+#include "gzip/decoder.hpp"
+#include "gzip/encoder.hpp"
+
+namespace zipper::gzip
+{
+
+using std::unexpected;
+
+namespace {
+
+uint16_t get_le16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t get_le32(const uint8_t* p) {
+    return get_le16(p) | (static_cast<uint32_t>(get_le16(p + 2)) << 16);
+}
+
+uint64_t get_le64(const uint8_t* p) {
+    return get_le32(p) | (static_cast<uint64_t>(get_le32(p + 4)) << 32);
+}
+
+// size of the block starting at `p` from its "BC" subfield, 0 if it has none
+size_t block_size(const uint8_t* p, size_t available) {
+    if (available < BGZF_HEADER_SIZE || p[0] != ID1 || p[1] != ID2 || p[2] != CM_DEFLATE || !(p[3] & FLAG_EXTRA)) {
+        return 0;
+    }
+    const size_t extra_length = get_le16(p + 10);
+    if (available < 12 + extra_length) {
+        return 0;
+    }
+    for (size_t pos = 12; pos + 4 <= 12 + extra_length;) {
+        const size_t length = get_le16(p + pos + 2);
+        if (p[pos] == 'B' && p[pos + 1] == 'C' && length == 2 && pos + 6 <= 12 + extra_length) {
+            return get_le16(p + pos + 4) + 1;
+        }
+        pos += 4 + length;
+    }
+    return 0;
+}
+
+// end of the block data, before the EOF block if there is one
+size_t data_end(const mapped_file& file) {
+    const size_t size = file.size();
+    if (size >= BGZF_EOF.size() && std::memcmp(file.data() + size - BGZF_EOF.size(), BGZF_EOF.data(), BGZF_EOF.size()) == 0) {
+        return size - BGZF_EOF.size();
+    }
+    return size;
+}
+
+} // namespace
+
+bgzf_reader::bgzf_reader(mapped_file f, std::vector<bgzf_block> blocks) : file(std::move(f)), list(std::move(blocks)) {
+    total = list.empty() ? 0 : list.back().uncompressed_offset + list.back().uncompressed_size;
+}
+
+std::expected<bgzf_reader, bgzf_failure> bgzf_reader::open(const std::filesystem::path& path) {
+    auto file = mapped_file::open(path);
+    if (!file) {
+        return unexpected(bgzf_failure{0, "Cannot open file"});
+    }
+    std::vector<bgzf_block> blocks;
+    uint64_t uncompressed = 0;
+    for (size_t pos = 0; pos < file->size();) {
+        const size_t size = block_size(file->data() + pos, file->size() - pos);
+        if (size == 0) {
+            return unexpected(bgzf_failure{pos, "Not a BGZF block"});
+        }
+        if (size < BGZF_HEADER_SIZE + BGZF_TRAILER_SIZE || size > file->size() - pos) {
+            return unexpected(bgzf_failure{pos, "Truncated BGZF block"});
+        }
+        const uint32_t isize = get_le32(file->data() + pos + size - 4);
+        if (isize > BGZF_MAX_BLOCK_SIZE) {
+            return unexpected(bgzf_failure{pos, "BGZF block is too large"});
+        }
+        // empty blocks, the EOF block among them, hold no data to find
+        if (isize != 0) {
+            blocks.push_back(bgzf_block{pos, uncompressed, static_cast<uint32_t>(size), isize});
+            uncompressed += isize;
+        }
+        pos += size;
+    }
+    return bgzf_reader(std::move(*file), std::move(blocks));
+}
+
+std::expected<bgzf_reader, bgzf_failure> bgzf_reader::open(const std::filesystem::path& path, const std::filesystem::path& index) {
+    auto entries = read_index(index);
+    if (!entries) {
+        return unexpected(entries.error());
+    }
+    auto file = mapped_file::open(path);
+    if (!file) {
+        return unexpected(bgzf_failure{0, "Cannot open file"});
+    }
+    const size_t end = data_end(*file);
+    if (end == 0) {
+        return bgzf_reader(std::move(*file), {});
+    }
+
+    entries->insert(entries->begin(), {0, 0});
+    std::vector<bgzf_block> blocks;
+    blocks.reserve(entries->size());
+    for (size_t i = 0; i < entries->size(); i++) {
+        const auto [compressed, uncompressed] = (*entries)[i];
+        const uint64_t next_compressed = i + 1 < entries->size() ? (*entries)[i + 1].first : end;
+        if (next_compressed <= compressed || next_compressed - compressed > BGZF_MAX_BLOCK_SIZE || next_compressed > end) {
+            return unexpected(bgzf_failure{compressed, "Index does not match the file"});
+        }
+        const uint64_t next_uncompressed = i + 1 < entries->size()
+            ? (*entries)[i + 1].second
+            : uncompressed + get_le32(file->data() + end - 4);
+        if (next_uncompressed <= uncompressed || next_uncompressed - uncompressed > BGZF_MAX_BLOCK_SIZE) {
+            return unexpected(bgzf_failure{compressed, "Index does not match the file"});
+        }
+        blocks.push_back(bgzf_block{compressed, uncompressed, static_cast<uint32_t>(next_compressed - compressed),
+                                    static_cast<uint32_t>(next_uncompressed - uncompressed)});
+    }
+    return bgzf_reader(std::move(*file), std::move(blocks));
+}
+
+size_t bgzf_reader::find_block(uint64_t offset) const {
+    if (offset >= total) {
+        return list.size();
+    }
+    auto it = std::upper_bound(list.begin(), list.end(), offset,
+                               [](uint64_t value, const bgzf_block& b) { return value < b.uncompressed_offset; });
+    return it - list.begin() - 1;
+}
+
+uint64_t bgzf_reader::virtual_offset(uint64_t uncompressed_offset) const {
+    const size_t i = find_block(uncompressed_offset);
+    if (i == list.size()) {
+        return list.empty() ? 0 : make_virtual_offset(list.back().compressed_offset + list.back().compressed_size, 0);
+    }
+    return make_virtual_offset(list[i].compressed_offset, static_cast<uint32_t>(uncompressed_offset - list[i].uncompressed_offset));
+}
+
+std::expected<uint64_t, bgzf_failure> bgzf_reader::uncompressed_offset(uint64_t virtual_offset) const {
+    const uint64_t offset = block_offset(virtual_offset);
+    if (list.empty() || offset == list.back().compressed_offset + list.back().compressed_size) {
+        if (within_block(virtual_offset) == 0) {
+            return total;
+        }
+    }
+    auto it = std::lower_bound(list.begin(), list.end(), offset,
+                               [](const bgzf_block& b, uint64_t value) { return b.compressed_offset < value; });
+    if (it == list.end() || it->compressed_offset != offset || within_block(virtual_offset) >= it->uncompressed_size) {
+        return unexpected(bgzf_failure{offset, "Virtual offset does not point into a block"});
+    }
+    return it->uncompressed_offset + within_block(virtual_offset);
+}
+
+std::expected<void, bgzf_failure> bgzf_reader::read_block(size_t i, uint8_t* target) const {
+    const bgzf_block& b = list[i];
+    decoder d(file.data() + b.compressed_offset, b.compressed_size);
+    auto r = d.decode(target, b.uncompressed_size);
+    if (!r) {
+        return unexpected(bgzf_failure{b.compressed_offset + r.error().byte_offset, r.error().message});
+    }
+    if (r->bytes_written != b.uncompressed_size) {
+        return unexpected(bgzf_failure{b.compressed_offset, "Block size does not match"});
+    }
+    return {};
+}
+
+std::expected<size_t, bgzf_failure> bgzf_reader::read(uint64_t virtual_offset, uint8_t* target, size_t length) const {
+    auto start = uncompressed_offset(virtual_offset);
+    if (!start) {
+        return unexpected(start.error());
+    }
+    std::vector<uint8_t> buffer;
+    size_t copied = 0;
+    for (size_t i = find_block(*start); copied < length && i < list.size(); i++) {
+        const bgzf_block& b = list[i];
+        const size_t skip = *start + copied - b.uncompressed_offset;
+        const size_t n = std::min<size_t>(length - copied, b.uncompressed_size - skip);
+        if (skip == 0 && n == b.uncompressed_size) {
+            if (auto r = read_block(i, target + copied); !r) {
+                return unexpected(r.error());
+            }
+        } else {
+            // partial block at either end of the range
+            buffer.resize(b.uncompressed_size);
+            if (auto r = read_block(i, buffer.data()); !r) {
+                return unexpected(r.error());
+            }
+            std::copy(buffer.begin() + skip, buffer.begin() + skip + n, target + copied);
+        }
+        copied += n;
+    }
+    return copied;
+}
+
+std::expected<void, bgzf_failure> bgzf_reader::read_all(thread_pool& pool, uint8_t* target, size_t target_length) const {
+    if (target_length < total) {
+        return unexpected(bgzf_failure{0, "Target data is too short"});
+    }
+    // a few runs per worker balance uneven blocks without a job per 64K block
+    const size_t runs = std::min(list.size(), 4 * pool.size());
+    std::vector<std::future<std::expected<void, bgzf_failure>>> jobs;
+    jobs.reserve(runs);
+    for (size_t r = 0; r < runs; r++) {
+        const size_t first = list.size() * r / runs;
+        const size_t last = list.size() * (r + 1) / runs;
+        jobs.push_back(pool.submit([this, first, last, target]() -> std::expected<void, bgzf_failure> {
+            for (size_t i = first; i < last; i++) {
+                if (auto result = read_block(i, target + list[i].uncompressed_offset); !result) {
+                    return result;
+                }
+            }
+            return {};
+        }));
+    }
+    std::expected<void, bgzf_failure> result;
+    for (auto& job : jobs) {
+        auto r = job.get();
+        if (!r && result) {
+            result = r;
+        }
+    }
+    return result;
+}
+
+std::expected<std::vector<std::pair<uint64_t, uint64_t>>, bgzf_failure> read_index(const std::filesystem::path& index) {
+    std::ifstream in(index, std::ios::binary);
+    if (!in) {
+        return unexpected(bgzf_failure{0, "Cannot open index"});
+    }
+    const std::vector<uint8_t> data(std::istreambuf_iterator<char>(in), {});
+    if (data.size() < 8 || (data.size() - 8) / 16 != get_le64(data.data()) || (data.size() - 8) % 16 != 0) {
+        return unexpected(bgzf_failure{0, "Corrupted index"});
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> entries((data.size() - 8) / 16);
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i] = {get_le64(data.data() + 8 + 16 * i), get_le64(data.data() + 16 + 16 * i)};
+    }
+    return entries;
+}
+
+} // namespace zipper::gzip
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include "checksum.hpp"
+#include "gzip/bgzf_writer.hpp"
+
+namespace zipper::gzip
+{
+
+using std::unexpected;
+
+namespace {
+
+uint8_t* put_le16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    return p + 2;
+}
+
+uint8_t* put_le32(uint8_t* p, uint32_t v) {
+    return put_le16(put_le16(p, static_cast<uint16_t>(v)), static_cast<uint16_t>(v >> 16));
+}
+
+uint8_t* put_le64(uint8_t* p, uint64_t v) {
+    return put_le32(put_le32(p, static_cast<uint32_t>(v)), static_cast<uint32_t>(v >> 32));
+}
+
+} // namespace
+
+std::expected<std::vector<uint8_t>, bgzf_failure> bgzf_compress_block(const uint8_t* data, size_t length, const deflate::optimal_options& opts) {
+    std::vector<uint8_t> block(BGZF_HEADER_SIZE + deflate::compress_bound(length) + BGZF_TRAILER_SIZE);
+    // the EOF block is a header like any other, only its size field and payload differ
+    std::copy(BGZF_EOF.begin(), BGZF_EOF.begin() + BGZF_HEADER_SIZE, block.begin());
+
+    deflate::optimal_encoder encoder(opts);
+    auto r = encoder.encode(data, length, block.data() + BGZF_HEADER_SIZE, block.size() - BGZF_HEADER_SIZE - BGZF_TRAILER_SIZE);
+    if (!r) {
+        return unexpected(bgzf_failure{0, r.error().message});
+    }
+    const size_t size = BGZF_HEADER_SIZE + r->bytes_written + BGZF_TRAILER_SIZE;
+    if (size > BGZF_MAX_BLOCK_SIZE) {
+        return unexpected(bgzf_failure{0, "Compressed block is too large"});
+    }
+    uint8_t* trailer = put_le32(block.data() + BGZF_HEADER_SIZE + r->bytes_written, crc32(data, length));
+    put_le32(trailer, static_cast<uint32_t>(length));
+    put_le16(block.data() + 16, static_cast<uint16_t>(size - 1));
+    block.resize(size);
+    return block;
+}
+
+bgzf_writer::bgzf_writer(thread_pool& workers, bgzf_options opts, std::filesystem::path p, std::ofstream o)
+    : pool(workers), options(opts), path(std::move(p)), out(std::move(o)) {
+    options.block_size = std::clamp<size_t>(options.block_size, 1, BGZF_BLOCK_DATA);
+    current.reserve(options.block_size);
+}
+
+std::expected<bgzf_writer, bgzf_failure> bgzf_writer::create(thread_pool& workers, const std::filesystem::path& path, bgzf_options opts) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return unexpected(bgzf_failure{0, "Cannot create file"});
+    }
+    return bgzf_writer(workers, opts, path, std::move(out));
+}
+
+void bgzf_writer::submit() {
+    const auto size = static_cast<uint32_t>(current.size());
+    auto job = [data = std::move(current), opts = options.deflate]() { return bgzf_compress_block(data.data(), data.size(), opts); };
+    in_flight.emplace_back(pool.submit(std::move(job)), size);
+    current = {};
+    current.reserve(options.block_size);
+}
+
+std::expected<void, bgzf_failure> bgzf_writer::retire() {
+    auto [job, size] = std::move(in_flight.front());
+    in_flight.pop_front();
+    auto block = job.get();
+    if (!block) {
+        return unexpected(bgzf_failure{compressed_offset, block.error().message});
+    }
+    out.write(reinterpret_cast<const char*>(block->data()), block->size());
+    if (!out) {
+        return unexpected(bgzf_failure{compressed_offset, "Cannot write file"});
+    }
+    written.push_back(bgzf_block{compressed_offset, uncompressed_offset, static_cast<uint32_t>(block->size()), size});
+    compressed_offset += block->size();
+    uncompressed_offset += size;
+    return {};
+}
+
+std::expected<void, bgzf_failure> bgzf_writer::write(const uint8_t* data, size_t length) {
+    while (length > 0) {
+        const size_t n = std::min(length, options.block_size - current.size());
+        current.insert(current.end(), data, data + n);
+        data += n;
+        length -= n;
+        if (current.size() == options.block_size) {
+            submit();
+        }
+        // bound the memory held by finished blocks waiting for their predecessors
+        while (in_flight.size() > 2 * pool.size()) {
+            if (auto r = retire(); !r) {
+                return r;
+            }
+        }
+    }
+    return {};
+}
+
+std::expected<void, bgzf_failure> bgzf_writer::flush() {
+    if (!current.empty()) {
+        submit();
+    }
+    return {};
+}
+
+std::expected<void, bgzf_failure> bgzf_writer::finish() {
+    flush();
+    while (!in_flight.empty()) {
+        if (auto r = retire(); !r) {
+            return r;
+        }
+    }
+    out.write(reinterpret_cast<const char*>(BGZF_EOF.data()), BGZF_EOF.size());
+    out.close();
+    if (!out) {
+        return unexpected(bgzf_failure{compressed_offset, "Cannot write file"});
+    }
+
+    if (options.write_index) {
+        // entry count and (compressed, uncompressed) offsets of every block after the first
+        const size_t entries = written.empty() ? 0 : written.size() - 1;
+        std::vector<uint8_t> index(8 + 16 * entries);
+        uint8_t* p = put_le64(index.data(), entries);
+        for (size_t i = 1; i < written.size(); i++) {
+            p = put_le64(p, written[i].compressed_offset);
+            p = put_le64(p, written[i].uncompressed_offset);
+        }
+        std::ofstream gzi(path.string() + ".gzi", std::ios::binary | std::ios::trunc);
+        gzi.write(reinterpret_cast<const char*>(index.data()), index.size());
+        if (!gzi) {
+            return unexpected(bgzf_failure{0, "Cannot write index"});
+        }
+    }
+    return {};
+}
+
+} // namespace zipper::gzip
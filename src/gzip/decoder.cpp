@@ -0,0 +1,104 @@
+#include <cstring>
+#include "checksum.hpp"
+#include "deflate/decoder.hpp"
+#include "gzip/decoder.hpp"
+#include "gzip/encoder.hpp"
+
+namespace zipper::gzip
+{
+
+using std::unexpected;
+
+static uint32_t read_le16(const uint8_t* p) {
+    return p[0] | (static_cast<uint32_t>(p[1]) << 8);
+}
+
+static uint32_t read_le32(const uint8_t* p) {
+    return read_le16(p) | (read_le16(p + 2) << 16);
+}
+
+expected<size_t, decode_failure> decoder::header_size(const uint8_t* data, size_t length) {
+    auto failure = [](size_t offset, const char* message) {
+        return unexpected(decode_failure{offset, offset * 8, 0, message});
+    };
+    if (length < HEADER_SIZE) {
+        return failure(0, "Source data is too short for a gzip member");
+    }
+    if (data[0] != ID1 || data[1] != ID2) {
+        return failure(0, "Not a gzip member");
+    }
+    if (data[2] != CM_DEFLATE) {
+        return failure(2, "Unknown compression method of gzip member");
+    }
+    const uint8_t flags = data[3];
+    if (flags & 0xE0) {
+        return failure(3, "Reserved gzip flags are set");
+    }
+
+    size_t offset = HEADER_SIZE;
+    if (flags & FLAG_EXTRA) {
+        if (length < offset + 2 || length < offset + 2 + read_le16(data + offset)) {
+            return failure(offset, "Unexpected end of gzip extra field");
+        }
+        offset += 2 + read_le16(data + offset);
+    }
+    for (uint8_t flag : {FLAG_NAME, FLAG_COMMENT}) {
+        if (flags & flag) {
+            const void* end = std::memchr(data + offset, 0, length - offset);
+            if (end == nullptr) {
+                return failure(offset, "Unterminated gzip file name or comment");
+            }
+            offset = static_cast<const uint8_t*>(end) - data + 1;
+        }
+    }
+    if (flags & FLAG_HCRC) {
+        if (length < offset + 2) {
+            return failure(offset, "Unexpected end of gzip header");
+        }
+        if (read_le16(data + offset) != (crc32(data, offset) & 0xFFFF)) {
+            return failure(offset, "Header CRC mismatch");
+        }
+        offset += 2;
+    }
+    return offset;
+}
+
+decode_result decoder::decode(uint8_t* target, size_t target_length) {
+    size_t offset = 0, written = 0;
+    do {
+        auto header = header_size(source + offset, source_length - offset);
+        if (!header) {
+            header.error().byte_offset += offset;
+            header.error().bit_num += offset * 8;
+            return unexpected(header.error());
+        }
+        offset += *header;
+
+        deflate::decoder raw(source + offset, source_length - offset);
+        auto result = raw.decode(target + written, target_length - written);
+        if (!result) {
+            result.error().byte_offset += offset;
+            return result;
+        }
+        if (!raw.stream_end()) {
+            const size_t end = offset + result->bits_read / 8;
+            return unexpected(decode_failure{end, end * 8, 0, raw.truncated() ? "Target data is too short" : "Unexpected end of deflate stream"});
+        }
+
+        const size_t trailer = offset + (result->bits_read + 7) / 8;
+        if (source_length < trailer + TRAILER_SIZE) {
+            return unexpected(decode_failure{trailer, trailer * 8, 0, "Unexpected end of input before CRC-32"});
+        }
+        if (read_le32(source + trailer) != crc32(target + written, result->bytes_written)) {
+            return unexpected(decode_failure{trailer, trailer * 8, 0, "CRC-32 mismatch"});
+        }
+        if (read_le32(source + trailer + 4) != static_cast<uint32_t>(result->bytes_written)) {
+            return unexpected(decode_failure{trailer + 4, (trailer + 4) * 8, 0, "Uncompressed size mismatch"});
+        }
+        written += result->bytes_written;
+        offset = trailer + TRAILER_SIZE;
+    } while (offset < source_length);
+    return decode_success{written, offset * 8};
+}
+
+} // namespace zipper::gzip
@@ -0,0 +1,45 @@
+#include <algorithm>
+#include "checksum.hpp"
+#include "gzip/encoder.hpp"
+
+namespace zipper::gzip
+{
+
+using std::unexpected;
+
+static void write_le32(uint8_t* p, uint32_t value) {
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
+
+size_t compress_bound(size_t source_length) {
+    return deflate::compress_bound(source_length) + HEADER_SIZE + TRAILER_SIZE;
+}
+
+size_t compress_bound(size_t source_length, const deflate::stream_options& options) {
+    return deflate::compress_bound(source_length, options) + HEADER_SIZE + TRAILER_SIZE;
+}
+
+encode_result encoder::encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) {
+    if (target_length < HEADER_SIZE + TRAILER_SIZE) {
+        return unexpected(encode_failure{0, "Target buffer is too small"});
+    }
+
+    // no flags, no modification time, unknown operating system
+    const uint8_t header[HEADER_SIZE] = {ID1, ID2, CM_DEFLATE, 0, 0, 0, 0, 0, extra_flags, 255};
+    std::copy(header, header + HEADER_SIZE, target);
+
+    auto result = raw->encode(source, source_length, target + HEADER_SIZE, target_length - HEADER_SIZE - TRAILER_SIZE);
+    if (!result) {
+        result.error().byte_offset += HEADER_SIZE;
+        return result;
+    }
+    const size_t trailer = HEADER_SIZE + result->bytes_written;
+    write_le32(target + trailer, crc32(source, source_length));
+    write_le32(target + trailer + 4, static_cast<uint32_t>(source_length));
+    return encode_success{source_length, trailer + TRAILER_SIZE};
+}
+
+} // namespace zipper::gzip
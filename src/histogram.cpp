@@ -0,0 +1,31 @@
+#include <cstring>
+#include "histogram.hpp"
+
+namespace zipper {
+
+void byte_histogram(const uint8_t* data, size_t length, std::array<uint32_t, 256>& counts) {
+    // Consecutive equal bytes would increment one counter back to back, each increment waiting
+    // for the store of the previous one. Four tables taken in turn keep four chains in flight.
+    uint32_t sub[4][256] = {};
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        sub[0][word & 0xFF]++;
+        sub[1][(word >> 8) & 0xFF]++;
+        sub[2][(word >> 16) & 0xFF]++;
+        sub[3][(word >> 24) & 0xFF]++;
+        sub[0][(word >> 32) & 0xFF]++;
+        sub[1][(word >> 40) & 0xFF]++;
+        sub[2][(word >> 48) & 0xFF]++;
+        sub[3][word >> 56]++;
+    }
+    for (; i < length; i++) {
+        sub[0][data[i]]++;
+    }
+    for (size_t v = 0; v < 256; v++) {
+        counts[v] += sub[0][v] + sub[1][v] + sub[2][v] + sub[3][v];
+    }
+}
+
+}
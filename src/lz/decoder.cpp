@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cstring>
+#include "lz/decoder.hpp"
+#include "lz/format.hpp"
+
+namespace zipper::lz
+{
+
+using std::unexpected;
+
+uint64_t decoder::content_size(const uint8_t* data, size_t length) {
+    if (length < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        return 0;
+    }
+    uint64_t size = 0;
+    for (size_t i = 0; i < 8; i++) {
+        size |= static_cast<uint64_t>(data[sizeof(MAGIC) + i]) << (8 * i);
+    }
+    return size;
+}
+
+decode_result decoder::decode(uint8_t* target, size_t target_length) {
+    if (source_length < HEADER_SIZE || std::memcmp(source, MAGIC, sizeof(MAGIC)) != 0) {
+        return unexpected(decode_failure{0, 0, 0, "Not an lz stream"});
+    }
+    const uint64_t size = content_size(source, source_length);
+    if (size > target_length) {
+        return unexpected(decode_failure{sizeof(MAGIC), sizeof(MAGIC) * 8, 0, "Target data is too short"});
+    }
+
+    const uint8_t* ip = source + HEADER_SIZE;
+    const uint8_t* const iend = source + source_length;
+    uint8_t* op = target;
+    uint8_t* const oend = target + size;
+    auto failure = [&](const char* message) {
+        const size_t offset = ip - source;
+        return unexpected(decode_failure{offset, offset * 8, 0, message});
+    };
+    auto read_length = [&](size_t& length) {
+        uint8_t b = 0;
+        do {
+            if (ip == iend) {
+                return false;
+            }
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+
+    for (;;) {
+        if (ip == iend) {
+            return failure("Unexpected end of lz stream");
+        }
+        const uint8_t token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == RUN_MASK && !read_length(literals)) {
+            return failure("Unexpected end of literal length");
+        }
+        if (literals > static_cast<size_t>(iend - ip)) {
+            return failure("Unexpected end of literals");
+        }
+        if (literals > static_cast<size_t>(oend - op)) {
+            return failure("Literals exceed the uncompressed size");
+        }
+        // short runs are copied with one fixed-size move when both buffers have room for it
+        if (literals <= 16 && iend - ip >= 16 && oend - op >= 16) {
+            std::memcpy(op, ip, 16);
+        } else {
+            std::copy(ip, ip + literals, op);
+        }
+        op += literals;
+        ip += literals;
+        if (op == oend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return failure("Unexpected end of match offset");
+        }
+        const size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - target)) {
+            return failure("Match offset is out of range");
+        }
+        size_t length = token & RUN_MASK;
+        if (length == RUN_MASK && !read_length(length)) {
+            return failure("Unexpected end of match length");
+        }
+        length += MIN_MATCH;
+        if (length > static_cast<size_t>(oend - op)) {
+            return failure("Match exceeds the uncompressed size");
+        }
+
+        const uint8_t* ref = op - offset;
+        if (offset >= 8 && static_cast<size_t>(oend - op) >= length + 8) {
+            // 8 byte moves may run past the match into output which is written later
+            for (size_t i = 0; i < length; i += 8) {
+                std::memcpy(op + i, ref + i, 8);
+            }
+        } else {
+            for (size_t i = 0; i < length; i++) {
+                op[i] = ref[i];
+            }
+        }
+        op += length;
+    }
+    return decode_success{static_cast<size_t>(size), static_cast<size_t>(ip - source) * 8};
+}
+
+} // namespace zipper::lz
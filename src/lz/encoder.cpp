@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <bit>
+#include "lz/encoder.hpp"
+#include "lz/format.hpp"
+
+namespace zipper::lz
+{
+
+using std::unexpected;
+
+namespace {
+
+constexpr uint32_t MAX_HASH_BITS = 14;
+// after 2^SKIP_TRIGGER failed probes the step grows by one
+constexpr uint32_t SKIP_TRIGGER = 6;
+
+uint32_t hash4(const uint8_t* p, uint32_t bits) {
+    return (load32(p) * 2654435761u) >> (32 - bits);
+}
+
+uint8_t* write_length(uint8_t* op, size_t length) {
+    for (; length >= 255; length -= 255) {
+        *op++ = 255;
+    }
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+}
+
+// number of equal bytes at `a` and `b`, `a` not reaching past `limit`
+size_t common_length(const uint8_t* a, const uint8_t* b, const uint8_t* limit) {
+    const uint8_t* start = a;
+    while (a + 8 <= limit) {
+        const uint64_t diff = load64(a) ^ load64(b);
+        if (diff != 0) {
+            const int bits = std::endian::native == std::endian::little ? std::countr_zero(diff) : std::countl_zero(diff);
+            return a - start + bits / 8;
+        }
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b) {
+        a++;
+        b++;
+    }
+    return a - start;
+}
+
+} // namespace
+
+size_t compress_bound(size_t source_length) {
+    return HEADER_SIZE + source_length + source_length / 255 + 16;
+}
+
+encode_result encoder::encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) {
+    if (target_length < HEADER_SIZE) {
+        return unexpected(encode_failure{0, "Target buffer is too small"});
+    }
+    std::copy(MAGIC, MAGIC + sizeof(MAGIC), target);
+    for (size_t i = 0; i < 8; i++) {
+        target[sizeof(MAGIC) + i] = static_cast<uint8_t>(static_cast<uint64_t>(source_length) >> (8 * i));
+    }
+
+    uint8_t* op = target + HEADER_SIZE;
+    uint8_t* const oend = target + target_length;
+    auto emit = [&](const uint8_t* literals, size_t literal_count, size_t offset, size_t match_length) {
+        const size_t worst = 1 + literal_count + literal_count / 255 + 1 + 2 + match_length / 255 + 1;
+        if (static_cast<size_t>(oend - op) < worst) {
+            return false;
+        }
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>(std::min<size_t>(literal_count, RUN_MASK) << 4);
+        if (literal_count >= RUN_MASK) {
+            op = write_length(op, literal_count - RUN_MASK);
+        }
+        std::copy(literals, literals + literal_count, op);
+        op += literal_count;
+        if (match_length == 0) {
+            return true;
+        }
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        const size_t extra = match_length - MIN_MATCH;
+        *token |= static_cast<uint8_t>(std::min<size_t>(extra, RUN_MASK));
+        if (extra >= RUN_MASK) {
+            op = write_length(op, extra - RUN_MASK);
+        }
+        return true;
+    };
+    auto no_space = [&] { return unexpected(encode_failure{static_cast<size_t>(op - target), "Target buffer is too small"}); };
+
+    const uint8_t* anchor = source;
+    if (source_length > MATCH_END_LIMIT) {
+        // small inputs get a small table, clearing it is part of the cost per call
+        const uint32_t hash_bits = std::clamp<uint32_t>(std::bit_width(source_length), 8, MAX_HASH_BITS);
+        table.assign(size_t(1) << hash_bits, 0);
+
+        const uint8_t* const match_limit = source + source_length - LAST_LITERALS;
+        const uint8_t* const search_limit = source + source_length - MATCH_END_LIMIT;
+        const uint8_t* ip = source + 1;
+        for (;;) {
+            // probe one candidate per position, stepping faster through data without matches
+            const uint8_t* ref = nullptr;
+            for (uint32_t probes = 1u << SKIP_TRIGGER; ip <= search_limit; ip += probes++ >> SKIP_TRIGGER) {
+                const uint32_t h = hash4(ip, hash_bits);
+                const uint8_t* candidate = source + table[h];
+                table[h] = static_cast<uint32_t>(ip - source);
+                if (ip - candidate <= MAX_OFFSET && load32(candidate) == load32(ip)) {
+                    ref = candidate;
+                    break;
+                }
+            }
+            if (ref == nullptr) {
+                break;
+            }
+
+            while (ip > anchor && ref > source && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const size_t length = MIN_MATCH + common_length(ip + MIN_MATCH, ref + MIN_MATCH, match_limit);
+            if (!emit(anchor, ip - anchor, ip - ref, length)) {
+                return no_space();
+            }
+            ip += length;
+            anchor = ip;
+            if (ip > search_limit) {
+                break;
+            }
+            table[hash4(ip - 2, hash_bits)] = static_cast<uint32_t>(ip - 2 - source);
+        }
+    }
+
+    if (!emit(anchor, source + source_length - anchor, 0, 0)) {
+        return no_space();
+    }
+    return encode_success{source_length, static_cast<size_t>(op - target)};
+}
+
+} // namespace zipper::lz
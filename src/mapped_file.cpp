@@ -0,0 +1,78 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include "mapped_file.hpp"
+
+namespace zipper {
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : ptr(std::exchange(other.ptr, nullptr)), length(std::exchange(other.length, 0)) {}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+        if (ptr != nullptr) {
+            munmap(ptr, length);
+        }
+        ptr = std::exchange(other.ptr, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+mapped_file::~mapped_file() {
+    if (ptr != nullptr) {
+        munmap(ptr, length);
+    }
+}
+
+std::expected<mapped_file, int> mapped_file::open(const std::filesystem::path& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::unexpected(errno);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        const int error = errno;
+        close(fd);
+        return std::unexpected(error);
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return mapped_file();
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    close(fd);
+    if (p == MAP_FAILED) {
+        return std::unexpected(error);
+    }
+    return mapped_file(static_cast<uint8_t*>(p), st.st_size);
+}
+
+std::expected<mapped_file, int> mapped_file::create(const std::filesystem::path& path, size_t size) {
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return std::unexpected(errno);
+    }
+    if (size == 0) {
+        close(fd);
+        return mapped_file();
+    }
+    if (ftruncate(fd, size) != 0) {
+        const int error = errno;
+        close(fd);
+        return std::unexpected(error);
+    }
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+    close(fd);
+    if (p == MAP_FAILED) {
+        return std::unexpected(error);
+    }
+    return mapped_file(static_cast<uint8_t*>(p), size);
+}
+
+}
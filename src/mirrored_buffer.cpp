@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+#include "mirrored_buffer.hpp"
+
+namespace zipper {
+
+namespace {
+
+// two views of one memfd at `2 * size` bytes of reserved address space, nullptr on failure
+uint8_t* map_twice(size_t size) {
+    const long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0 || size == 0 || size % page != 0) {
+        return nullptr;
+    }
+    const int fd = memfd_create("zipper-ring", MFD_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* reserved = mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+    auto* p = static_cast<uint8_t*>(reserved);
+    const bool ok = mmap(p, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED
+        && mmap(p + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    // the mappings keep the memory alive
+    close(fd);
+    if (!ok) {
+        munmap(p, 2 * size);
+        return nullptr;
+    }
+    return p;
+}
+
+} // namespace
+
+mirrored_buffer::mirrored_buffer(size_t size, bool use_mapping) : length(size) {
+    if (use_mapping) {
+        base = map_twice(size);
+        mapped = base != nullptr;
+    }
+    if (!mapped) {
+        fallback = std::make_unique<uint8_t[]>(2 * size);
+        base = fallback.get();
+    }
+}
+
+mirrored_buffer::mirrored_buffer(mirrored_buffer&& other) noexcept
+    : base(std::exchange(other.base, nullptr)), length(std::exchange(other.length, 0)),
+      mapped(std::exchange(other.mapped, false)), fallback(std::move(other.fallback)) {}
+
+mirrored_buffer& mirrored_buffer::operator=(mirrored_buffer&& other) noexcept {
+    if (this != &other) {
+        if (mapped) {
+            munmap(base, 2 * length);
+        }
+        base = std::exchange(other.base, nullptr);
+        length = std::exchange(other.length, 0);
+        mapped = std::exchange(other.mapped, false);
+        fallback = std::move(other.fallback);
+    }
+    return *this;
+}
+
+mirrored_buffer::~mirrored_buffer() {
+    if (mapped) {
+        munmap(base, 2 * length);
+    }
+}
+
+void mirrored_buffer::mirror(size_t pos, size_t n) {
+    // the part in the first half goes up, the part in the second half down
+    const size_t end = pos + n;
+    if (pos < length) {
+        const size_t first = std::min(end, length);
+        std::memcpy(base + pos + length, base + pos, first - pos);
+    }
+    if (end > length) {
+        const size_t second = std::max(pos, length);
+        std::memcpy(base + second - length, base + second, end - second);
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utility>
+#include "service/decode_client.hpp"
+
+namespace zipper::service
+{
+
+decode_client::decode_client(decode_client&& other) noexcept
+    : fd(std::exchange(other.fd, -1)), next_id(other.next_id) {}
+
+decode_client& decode_client::operator=(decode_client&& other) noexcept {
+    if (this != &other) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        fd = std::exchange(other.fd, -1);
+        next_id = other.next_id;
+    }
+    return *this;
+}
+
+decode_client::~decode_client() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+std::expected<decode_client, int> decode_client::connect(const std::filesystem::path& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.native().size() >= sizeof(address.sun_path)) {
+        return std::unexpected(ENAMETOOLONG);
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return std::unexpected(errno);
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        const int error = errno;
+        close(fd);
+        return std::unexpected(error);
+    }
+    return decode_client(fd);
+}
+
+std::expected<response, service_failure> decode_client::call(request r, int segment_fd) {
+    const auto disconnected = std::unexpected(service_failure{service_error::disconnected, 0, describe(service_error::disconnected)});
+    if (fd < 0) {
+        return disconnected;
+    }
+    r.id = next_id++;
+    iovec iov{&r, sizeof(r)};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    if (segment_fd >= 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr* h = CMSG_FIRSTHDR(&msg);
+        h->cmsg_level = SOL_SOCKET;
+        h->cmsg_type = SCM_RIGHTS;
+        h->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(h), &segment_fd, sizeof(int));
+    }
+    ssize_t n;
+    do {
+        n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n != static_cast<ssize_t>(sizeof(r))) {
+        return disconnected;
+    }
+
+    response resp;
+    do {
+        n = recv(fd, &resp, sizeof(resp), 0);
+    } while ((n < 0 && errno == EINTR) || (n == static_cast<ssize_t>(sizeof(resp)) && resp.id != r.id));
+    if (n != static_cast<ssize_t>(sizeof(resp))) {
+        return disconnected;
+    }
+    if (resp.error != service_error::none) {
+        return std::unexpected(service_failure{resp.error, resp.value, std::string(resp.message, strnlen(resp.message, sizeof(resp.message)))});
+    }
+    return resp;
+}
+
+std::expected<uint32_t, service_failure> decode_client::attach(const shared_segment& segment) {
+    request r;
+    r.type = request_type::attach;
+    auto resp = call(r, segment.fd());
+    if (!resp) {
+        return std::unexpected(resp.error());
+    }
+    return static_cast<uint32_t>(resp->value);
+}
+
+std::expected<size_t, service_failure> decode_client::decode(const decode_job& job) {
+    request r;
+    r.type = request_type::decode;
+    r.segment = job.segment;
+    r.format = job.format;
+    r.use_dictionary = job.dictionary.has_value();
+    r.dictionary_id = job.dictionary.value_or(0);
+    r.input_offset = job.input_offset;
+    r.input_length = job.input_length;
+    r.output_offset = job.output_offset;
+    r.output_capacity = job.output_capacity;
+    auto resp = call(r);
+    if (!resp) {
+        return std::unexpected(resp.error());
+    }
+    return resp->value;
+}
+
+std::expected<service_stats, service_failure> decode_client::stats() {
+    request r;
+    r.type = request_type::stats;
+    auto resp = call(r);
+    if (!resp) {
+        return std::unexpected(resp.error());
+    }
+    return resp->stats;
+}
+
+} // namespace zipper::service
@@ -0,0 +1,350 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+#include "deflate/decoder.hpp"
+#include "gzip/decoder.hpp"
+#include "service/decode_server.hpp"
+#include "zlib/decoder.hpp"
+
+namespace zipper::service
+{
+
+using clock = std::chrono::steady_clock;
+
+struct decode_server::connection {
+    int fd;
+    // written by the accepting thread only, jobs hold on to the segment they use
+    std::vector<std::shared_ptr<shared_segment>> segments;
+    // decode requests queued or running
+    std::atomic<size_t> in_flight{0};
+    std::mutex write_mutex;
+
+    explicit connection(int socket) : fd(socket) {}
+    ~connection() { close(fd); }
+
+    // Never blocks, the pool workers and the accepting thread are shared by all clients. A client
+    // whose socket is full does not read its responses and is disconnected; the accepting thread
+    // notices that like any other client going away, other failed sends need no handling.
+    void send(const response& r) {
+        std::lock_guard lock(write_mutex);
+        ssize_t n;
+        do {
+            n = ::send(fd, &r, sizeof(r), MSG_NOSIGNAL | MSG_DONTWAIT);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            shutdown(fd, SHUT_RDWR);
+        }
+    }
+};
+
+static response failure(uint32_t id, service_error error, uint64_t offset, const char* message) {
+    response r;
+    r.id = id;
+    r.error = error;
+    r.value = offset;
+    std::strncpy(r.message, message, sizeof(r.message) - 1);
+    return r;
+}
+
+static response failure(uint32_t id, service_error error) {
+    return failure(id, error, 0, describe(error));
+}
+
+static bool in_segment(uint64_t offset, uint64_t length, size_t size) {
+    return offset <= size && length <= size - offset;
+}
+
+decode_server::decode_server(thread_pool& workers, server_options opts) : pool(workers), options(opts) {}
+
+decode_server::~decode_server() {
+    stop();
+}
+
+void decode_server::add_dictionary(std::shared_ptr<const deflate::dictionary> dict) {
+    const uint32_t id = dict->adler32();
+    dictionaries[id] = std::move(dict);
+}
+
+std::expected<void, int> decode_server::start(const std::filesystem::path& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.native().size() >= sizeof(address.sun_path)) {
+        return std::unexpected(ENAMETOOLONG);
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        return std::unexpected(errno);
+    }
+    unlink(socket_path.c_str());
+    wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd < 0 || bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listen_fd, SOMAXCONN) != 0) {
+        const int error = errno;
+        close(listen_fd);
+        listen_fd = -1;
+        if (wake_fd >= 0) {
+            close(wake_fd);
+            wake_fd = -1;
+        }
+        return std::unexpected(error);
+    }
+    path = socket_path;
+    io = std::thread([this]() { serve(); });
+    return {};
+}
+
+void decode_server::stop() {
+    if (!io.joinable()) {
+        return;
+    }
+    const uint64_t one = 1;
+    [[maybe_unused]] auto n = write(wake_fd, &one, sizeof(one));
+    io.join();
+    {
+        std::unique_lock lock(stats_mutex);
+        drained.wait(lock, [this]() { return totals.queue_depth == 0; });
+    }
+    close(listen_fd);
+    close(wake_fd);
+    listen_fd = -1;
+    wake_fd = -1;
+    unlink(path.c_str());
+}
+
+service_stats decode_server::stats() {
+    std::lock_guard lock(stats_mutex);
+    return totals;
+}
+
+void decode_server::serve() {
+    std::vector<pollfd> fds;
+    for (;;) {
+        fds.assign({pollfd{listen_fd, POLLIN, 0}, pollfd{wake_fd, POLLIN, 0}});
+        for (const auto& [fd, c] : connections) {
+            fds.push_back(pollfd{fd, POLLIN, 0});
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                connections.emplace(fd, std::make_shared<connection>(fd));
+                std::lock_guard lock(stats_mutex);
+                totals.connections++;
+            }
+        }
+        for (size_t i = 2; i < fds.size(); i++) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            auto it = connections.find(fds[i].fd);
+            if (!receive(it->second)) {
+                connections.erase(it);
+                std::lock_guard lock(stats_mutex);
+                totals.connections--;
+            }
+        }
+    }
+    // jobs in flight keep their connection until they have answered
+    connections.clear();
+    std::lock_guard lock(stats_mutex);
+    totals.connections = 0;
+}
+
+bool decode_server::receive(const std::shared_ptr<connection>& c) {
+    request r;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    iovec iov{&r, sizeof(r)};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    const ssize_t n = recvmsg(c->fd, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0 && errno == EINTR) {
+        return true;
+    }
+    if (n <= 0) {
+        return false;
+    }
+    int fd = -1;
+    for (cmsghdr* h = CMSG_FIRSTHDR(&msg); h != nullptr; h = CMSG_NXTHDR(&msg, h)) {
+        if (h->cmsg_level == SOL_SOCKET && h->cmsg_type == SCM_RIGHTS && h->cmsg_len == CMSG_LEN(sizeof(int))) {
+            std::memcpy(&fd, CMSG_DATA(h), sizeof(int));
+        }
+    }
+    if (fd >= 0 && (r.type != request_type::attach || static_cast<size_t>(n) != sizeof(r))) {
+        close(fd);
+        fd = -1;
+    }
+
+    if (static_cast<size_t>(n) != sizeof(r) || r.magic != PROTOCOL_MAGIC) {
+        c->send(failure(r.id, service_error::bad_request));
+        return true;
+    }
+    switch (r.type) {
+    case request_type::attach:
+        attach(*c, r, fd);
+        break;
+    case request_type::decode:
+        submit(c, r);
+        break;
+    case request_type::stats: {
+        response resp;
+        resp.id = r.id;
+        resp.stats = stats();
+        c->send(resp);
+        break;
+    }
+    default:
+        c->send(failure(r.id, service_error::bad_request));
+        break;
+    }
+    return true;
+}
+
+void decode_server::attach(connection& c, const request& r, int fd) {
+    if (fd < 0) {
+        c.send(failure(r.id, service_error::bad_segment));
+        return;
+    }
+    if (c.segments.size() >= options.max_segments) {
+        close(fd);
+        c.send(failure(r.id, service_error::too_many_segments));
+        return;
+    }
+    auto segment = shared_segment::adopt(fd);
+    if (!segment) {
+        c.send(failure(r.id, service_error::bad_segment, 0, std::strerror(segment.error())));
+        return;
+    }
+    response resp;
+    resp.id = r.id;
+    resp.value = c.segments.size();
+    c.segments.push_back(std::make_shared<shared_segment>(std::move(*segment)));
+    c.send(resp);
+}
+
+void decode_server::submit(const std::shared_ptr<connection>& c, const request& r) {
+    service_error refused = service_error::none;
+    if (r.segment >= c->segments.size()) {
+        refused = service_error::unknown_segment;
+    } else if (c->in_flight >= options.max_in_flight) {
+        refused = service_error::too_many_requests;
+    }
+    if (refused != service_error::none) {
+        {
+            std::lock_guard lock(stats_mutex);
+            totals.requests++;
+            totals.failures++;
+        }
+        c->send(failure(r.id, refused));
+        return;
+    }
+    c->in_flight++;
+    {
+        std::lock_guard lock(stats_mutex);
+        totals.queue_depth++;
+        totals.max_queue_depth = std::max(totals.max_queue_depth, totals.queue_depth);
+    }
+    const auto received = clock::now();
+    pool.submit([this, c, r, segment = c->segments[r.segment], received]() {
+        const response resp = decode(r, *segment);
+        const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - received);
+        {
+            // counted before the client hears back, so its next stats request sees this one
+            std::lock_guard lock(stats_mutex);
+            totals.queue_depth--;
+            totals.requests++;
+            if (resp.error == service_error::none) {
+                totals.bytes_in += r.input_length;
+                totals.bytes_out += resp.value;
+            } else {
+                totals.failures++;
+            }
+            totals.add_latency(latency.count());
+            // under the lock, `stop` may return and the server go away as soon as it is released
+            drained.notify_all();
+        }
+        c->in_flight--;
+        c->send(resp);
+    });
+}
+
+response decode_server::decode(const request& r, const shared_segment& segment) const {
+    if (!in_segment(r.input_offset, r.input_length, segment.size()) || !in_segment(r.output_offset, r.output_capacity, segment.size())) {
+        return failure(r.id, service_error::out_of_range);
+    }
+    if (r.input_offset < r.output_offset + r.output_capacity && r.output_offset < r.input_offset + r.input_length) {
+        return failure(r.id, service_error::bad_request, 0, "Input and output ranges overlap");
+    }
+    uint8_t* input = segment.data() + r.input_offset;
+    uint8_t* output = segment.data() + r.output_offset;
+    const size_t length = r.input_length;
+
+    decode_result result;
+    switch (r.format) {
+    case stream_format::deflate: {
+        const deflate::dictionary* dict = nullptr;
+        if (r.use_dictionary != 0) {
+            auto it = dictionaries.find(r.dictionary_id);
+            if (it == dictionaries.end()) {
+                return failure(r.id, service_error::unknown_dictionary);
+            }
+            dict = it->second.get();
+        }
+        auto d = dict != nullptr ? deflate::decoder(input, length, *dict) : deflate::decoder(input, length);
+        result = d.decode(output, r.output_capacity);
+        if (result && !d.stream_end()) {
+            const size_t end = result->bits_read / 8;
+            return failure(r.id, service_error::decode_failed, end, d.truncated() ? "Target data is too short" : "Unexpected end of deflate stream");
+        }
+        break;
+    }
+    case stream_format::zlib: {
+        // a stream with a preset dictionary names it by its DICTID
+        std::shared_ptr<const deflate::dictionary> dict;
+        if (length >= 6 && (input[1] & 0x20) != 0) {
+            const uint32_t id = (uint32_t(input[2]) << 24) | (uint32_t(input[3]) << 16) | (uint32_t(input[4]) << 8) | input[5];
+            auto it = dictionaries.find(id);
+            if (it == dictionaries.end()) {
+                return failure(r.id, service_error::unknown_dictionary, 2, describe(service_error::unknown_dictionary));
+            }
+            dict = it->second;
+        }
+        result = zlib::decoder(input, length, std::move(dict)).decode(output, r.output_capacity);
+        break;
+    }
+    case stream_format::gzip:
+        result = gzip::decoder(input, length).decode(output, r.output_capacity);
+        break;
+    default:
+        return failure(r.id, service_error::bad_request);
+    }
+    if (!result) {
+        return failure(r.id, service_error::decode_failed, result.error().byte_offset, result.error().message);
+    }
+    response resp;
+    resp.id = r.id;
+    resp.value = result->bytes_written;
+    return resp;
+}
+
+} // namespace zipper::service
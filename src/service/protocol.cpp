@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <bit>
+#include "service/protocol.hpp"
+
+namespace zipper::service
+{
+
+const char* describe(service_error error) {
+    switch (error) {
+    case service_error::none: return "No error";
+    case service_error::bad_request: return "Malformed request";
+    case service_error::bad_segment: return "Segment cannot be mapped";
+    case service_error::too_many_segments: return "Too many segments attached";
+    case service_error::too_many_requests: return "Too many requests in flight";
+    case service_error::unknown_segment: return "Unknown segment";
+    case service_error::out_of_range: return "Range lies outside of the segment";
+    case service_error::unknown_dictionary: return "Unknown preset dictionary";
+    case service_error::decode_failed: return "Decoding failed";
+    case service_error::disconnected: return "Service is not reachable";
+    }
+    return "Unknown error";
+}
+
+void service_stats::add_latency(uint64_t ns) {
+    latency_total_ns += ns;
+    latency_max_ns = std::max(latency_max_ns, ns);
+    const uint64_t us = ns / 1000;
+    const size_t bucket = us == 0 ? 0 : std::bit_width(us);
+    latency_buckets[std::min(bucket, LATENCY_BUCKETS - 1)]++;
+}
+
+uint64_t service_stats::latency_percentile_us(double fraction) const {
+    uint64_t total = 0;
+    for (auto n : latency_buckets) {
+        total += n;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += latency_buckets[i];
+        if (seen > 0 && seen >= fraction * total) {
+            return uint64_t(1) << i;
+        }
+    }
+    return 0;
+}
+
+} // namespace zipper::service
@@ -0,0 +1,84 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include "service/shared_segment.hpp"
+
+namespace zipper::service
+{
+
+shared_segment::shared_segment(shared_segment&& other) noexcept
+    : ptr(std::exchange(other.ptr, nullptr)), length(std::exchange(other.length, 0)),
+      descriptor(std::exchange(other.descriptor, -1)) {}
+
+shared_segment& shared_segment::operator=(shared_segment&& other) noexcept {
+    if (this != &other) {
+        if (ptr != nullptr) {
+            munmap(ptr, length);
+        }
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+        ptr = std::exchange(other.ptr, nullptr);
+        length = std::exchange(other.length, 0);
+        descriptor = std::exchange(other.descriptor, -1);
+    }
+    return *this;
+}
+
+shared_segment::~shared_segment() {
+    if (ptr != nullptr) {
+        munmap(ptr, length);
+    }
+    if (descriptor >= 0) {
+        close(descriptor);
+    }
+}
+
+std::expected<shared_segment, int> shared_segment::create(size_t size) {
+    if (size == 0) {
+        return std::unexpected(EINVAL);
+    }
+    const int fd = memfd_create("zipper-segment", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return std::unexpected(errno);
+    }
+    if (ftruncate(fd, size) != 0 || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        const int error = errno;
+        close(fd);
+        return std::unexpected(error);
+    }
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        const int error = errno;
+        close(fd);
+        return std::unexpected(error);
+    }
+    return shared_segment(static_cast<uint8_t*>(p), size, fd);
+}
+
+std::expected<shared_segment, int> shared_segment::adopt(int fd) {
+    struct stat st;
+    const int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || fstat(fd, &st) != 0) {
+        const int error = errno;
+        close(fd);
+        return std::unexpected(error);
+    }
+    if ((seals & F_SEAL_SHRINK) == 0 || st.st_size == 0) {
+        close(fd);
+        return std::unexpected(EPERM);
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+    // the mapping keeps the memory alive
+    close(fd);
+    if (p == MAP_FAILED) {
+        return std::unexpected(error);
+    }
+    return shared_segment(static_cast<uint8_t*>(p), st.st_size, -1);
+}
+
+} // namespace zipper::service
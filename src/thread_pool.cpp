@@ -0,0 +1,49 @@
+#include "thread_pool.hpp"
+
+namespace zipper {
+
+thread_pool::thread_pool(size_t threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([this]() { work(); });
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+size_t thread_pool::queued() {
+    std::lock_guard lock(mutex);
+    return jobs.size();
+}
+
+void thread_pool::work() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(mutex);
+            available.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+}
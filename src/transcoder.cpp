@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
+#include "checksum.hpp"
+#include "deflate/dictionary.hpp"
+#include "gzip/bgzf_writer.hpp"
+#include "gzip/encoder.hpp"
+#include "transcoder.hpp"
+
+namespace zipper {
+
+using std::unexpected;
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+struct encoded_chunk {
+    std::vector<uint8_t> data;
+    std::chrono::nanoseconds busy;
+    const char* error = nullptr;
+};
+
+// raw DEFLATE of `chunk` continuing a stream whose output so far ends with `history`, left open
+encoded_chunk encode_chunk(const std::vector<uint8_t>& chunk, const std::vector<uint8_t>& history, deflate::optimal_options opts) {
+    const auto start = clock::now();
+    encoded_chunk result;
+    opts.last = false;
+    auto dict = history.empty() ? nullptr : std::make_shared<const deflate::dictionary>(history.data(), history.size());
+    deflate::optimal_encoder encoder(opts, std::move(dict));
+    // room for the empty stored block ending the chunk
+    result.data.resize(deflate::compress_bound(chunk.size()) + 8);
+    auto r = encoder.encode(chunk.data(), chunk.size(), result.data.data(), result.data.size());
+    if (r) {
+        result.data.resize(r->bytes_written);
+    } else {
+        result.error = r.error().message;
+    }
+    result.busy = clock::now() - start;
+    return result;
+}
+
+encoded_chunk encode_bgzf_block(const std::vector<uint8_t>& chunk, const deflate::optimal_options& opts) {
+    const auto start = clock::now();
+    encoded_chunk result;
+    auto block = gzip::bgzf_compress_block(chunk.data(), chunk.size(), opts);
+    if (block) {
+        result.data = std::move(*block);
+    } else {
+        result.error = block.error().message;
+    }
+    result.busy = clock::now() - start;
+    return result;
+}
+
+} // namespace
+
+std::expected<transcode_stats, transcode_failure> transcode(thread_pool& pool, std::istream& in, std::ostream& out,
+                                                            const transcode_options& opts) {
+    const auto begin = clock::now();
+    const bool blocked = opts.bgzf && opts.to == stream_format::gzip;
+    const size_t chunk_size = blocked ? std::clamp<size_t>(opts.chunk_size, 1, gzip::BGZF_BLOCK_DATA) : std::max<size_t>(opts.chunk_size, 1);
+    const size_t depth = std::max<size_t>(opts.queue_depth == 0 ? 2 * pool.size() : opts.queue_depth, 1);
+
+    streambuf_options source_opts;
+    source_opts.format = opts.from;
+    decompress_streambuf source(in, source_opts);
+
+    transcode_stats stats;
+    std::deque<std::future<encoded_chunk>> queue;
+    uint64_t offset = 0;
+
+    auto write = [&](const uint8_t* data, size_t length) -> std::expected<void, transcode_failure> {
+        out.write(reinterpret_cast<const char*>(data), length);
+        if (!out) {
+            return unexpected(transcode_failure{offset, "Cannot write output"});
+        }
+        stats.encode.bytes += length;
+        return {};
+    };
+    auto retire = [&]() -> std::expected<void, transcode_failure> {
+        const auto start = clock::now();
+        auto chunk = queue.front().get();
+        stats.encode.stalled += clock::now() - start;
+        queue.pop_front();
+        stats.encode.busy += chunk.busy;
+        if (chunk.error != nullptr) {
+            return unexpected(transcode_failure{offset, chunk.error});
+        }
+        return write(chunk.data.data(), chunk.data.size());
+    };
+
+    if (opts.to == stream_format::gzip && !blocked) {
+        // best compression, unknown OS
+        const uint8_t header[gzip::HEADER_SIZE] = {gzip::ID1, gzip::ID2, gzip::CM_DEFLATE, 0, 0, 0, 0, 0, 2, 255};
+        if (auto r = write(header, sizeof(header)); !r) {
+            return unexpected(r.error());
+        }
+    } else if (opts.to == stream_format::zlib) {
+        // 32 KiB window, maximum compression level
+        const uint8_t header[2] = {0x78, 0xDA};
+        if (auto r = write(header, sizeof(header)); !r) {
+            return unexpected(r.error());
+        }
+    }
+
+    uint32_t checksum = opts.to == stream_format::zlib ? 1 : 0;
+    std::vector<uint8_t> history;
+    for (;;) {
+        std::vector<uint8_t> chunk(chunk_size);
+        const auto start = clock::now();
+        const auto n = static_cast<size_t>(source.sgetn(reinterpret_cast<char*>(chunk.data()), chunk.size()));
+        stats.decode.stalled += clock::now() - start;
+        if (n == 0) {
+            break;
+        }
+        chunk.resize(n);
+        offset += n;
+        if (!blocked) {
+            checksum = opts.to == stream_format::zlib ? adler32(chunk.data(), n, checksum) : crc32(chunk.data(), n, checksum);
+        }
+
+        if (queue.size() >= depth) {
+            if (auto r = retire(); !r) {
+                return unexpected(r.error());
+            }
+        }
+        if (blocked) {
+            queue.push_back(pool.submit([chunk = std::move(chunk), encoder_opts = opts.deflate]() { return encode_bgzf_block(chunk, encoder_opts); }));
+            continue;
+        }
+        auto next_history = std::vector<uint8_t>(chunk.end() - std::min<size_t>(n, deflate::WINDOW_SIZE), chunk.end());
+        queue.push_back(pool.submit([chunk = std::move(chunk), history = std::move(history), encoder_opts = opts.deflate]() {
+            return encode_chunk(chunk, history, encoder_opts);
+        }));
+        history = std::move(next_history);
+    }
+    if (source.error() != nullptr) {
+        return unexpected(transcode_failure{offset, source.error()});
+    }
+    while (!queue.empty()) {
+        if (auto r = retire(); !r) {
+            return unexpected(r.error());
+        }
+    }
+
+    uint8_t trailer[10];
+    size_t trailer_size = 0;
+    if (blocked) {
+        if (auto r = write(gzip::BGZF_EOF.data(), gzip::BGZF_EOF.size()); !r) {
+            return unexpected(r.error());
+        }
+    } else {
+        // chunks leave the stream open, an empty final static block closes it
+        trailer[0] = 0x03;
+        trailer[1] = 0x00;
+        trailer_size = 2;
+        if (opts.to == stream_format::gzip) {
+            for (size_t i = 0; i < 4; i++) {
+                trailer[2 + i] = static_cast<uint8_t>(checksum >> (8 * i));
+                trailer[6 + i] = static_cast<uint8_t>(offset >> (8 * i));
+            }
+            trailer_size = 10;
+        } else if (opts.to == stream_format::zlib) {
+            for (size_t i = 0; i < 4; i++) {
+                trailer[2 + i] = static_cast<uint8_t>(checksum >> (24 - 8 * i));
+            }
+            trailer_size = 6;
+        }
+    }
+    if (auto r = write(trailer, trailer_size); !r) {
+        return unexpected(r.error());
+    }
+    if (!out.flush()) {
+        return unexpected(transcode_failure{offset, "Cannot write output"});
+    }
+
+    stats.decode.bytes = offset;
+    stats.decode.busy = source.decode_time();
+    stats.elapsed = clock::now() - begin;
+    return stats;
+}
+
+}
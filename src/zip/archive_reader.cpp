@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <future>
+#include <map>
+#include <string>
+#include "checksum.hpp"
+#include "deflate/decoder.hpp"
+#include "zip/archive_reader.hpp"
+
+namespace zipper::zip
+{
+
+using std::unexpected;
+
+namespace {
+
+// the end of central directory record may be followed by a comment of up to 65535 bytes
+const uint8_t* find_end_of_central_directory(const uint8_t* data, size_t size) {
+    if (size < END_OF_CENTRAL_DIRECTORY_SIZE) {
+        return nullptr;
+    }
+    const size_t lowest = size > END_OF_CENTRAL_DIRECTORY_SIZE + 0xFFFF ? size - END_OF_CENTRAL_DIRECTORY_SIZE - 0xFFFF : 0;
+    for (size_t pos = size - END_OF_CENTRAL_DIRECTORY_SIZE + 1; pos-- > lowest;) {
+        if (read_le32(data + pos) == END_OF_CENTRAL_DIRECTORY_SIGNATURE
+            && pos + END_OF_CENTRAL_DIRECTORY_SIZE + read_le16(data + pos + 20) <= size) {
+            return data + pos;
+        }
+    }
+    return nullptr;
+}
+
+// replaces saturated fields of a central directory header by their ZIP64 extra field values
+bool apply_zip64_extra(entry& e, const uint8_t* extra, size_t extra_length) {
+    const bool need_usize = e.uncompressed_size == 0xFFFFFFFF;
+    const bool need_csize = e.compressed_size == 0xFFFFFFFF;
+    const bool need_offset = e.local_header_offset == 0xFFFFFFFF;
+    if (!need_usize && !need_csize && !need_offset) {
+        return true;
+    }
+    for (size_t pos = 0; pos + 4 <= extra_length;) {
+        const uint16_t id = read_le16(extra + pos);
+        const uint16_t size = read_le16(extra + pos + 2);
+        const uint8_t* field = extra + pos + 4;
+        pos += 4 + size;
+        if (pos > extra_length) {
+            return false;
+        }
+        if (id != ZIP64_EXTRA_ID) {
+            continue;
+        }
+        size_t offset = 0;
+        auto next = [&](uint64_t& value) {
+            if (offset + 8 > size) {
+                return false;
+            }
+            value = read_le64(field + offset);
+            offset += 8;
+            return true;
+        };
+        return (!need_usize || next(e.uncompressed_size)) && (!need_csize || next(e.compressed_size))
+            && (!need_offset || next(e.local_header_offset));
+    }
+    return false;
+}
+
+bool is_safe_name(const std::filesystem::path& name) {
+    if (name.empty() || name.is_absolute() || name.has_root_name()) {
+        return false;
+    }
+    for (const auto& part : name) {
+        if (part == "..") {
+            return false;
+        }
+    }
+    return true;
+}
+
+// one literal, then matches of 258 bytes coded in one bit each for length and distance
+constexpr uint64_t MAX_DEFLATE_RATIO = 1032;
+
+// The central directory sizes are not verified until the data is decoded; a size the compressed
+// data cannot produce is rejected before anything is allocated for it.
+bool is_plausible_size(const entry& e) {
+    if (e.method == METHOD_STORED) {
+        return e.uncompressed_size == e.compressed_size;
+    }
+    if (e.method == METHOD_DEFLATED) {
+        return e.uncompressed_size / MAX_DEFLATE_RATIO + (e.uncompressed_size % MAX_DEFLATE_RATIO != 0) <= e.compressed_size;
+    }
+    return true;
+}
+
+} // namespace
+
+std::expected<archive_reader, zip_failure> archive_reader::open(const std::filesystem::path& path) {
+    auto mapped = mapped_file::open(path);
+    if (!mapped) {
+        return unexpected(zip_failure{"", "Cannot open archive"});
+    }
+    const uint8_t* data = mapped->data();
+    const size_t size = mapped->size();
+
+    const uint8_t* eocd = find_end_of_central_directory(data, size);
+    if (eocd == nullptr) {
+        return unexpected(zip_failure{"", "End of central directory not found"});
+    }
+    uint64_t count = read_le16(eocd + 10);
+    uint64_t directory_size = read_le32(eocd + 12);
+    uint64_t directory_offset = read_le32(eocd + 16);
+
+    const size_t eocd_pos = eocd - data;
+    if (eocd_pos >= ZIP64_LOCATOR_SIZE && read_le32(eocd - ZIP64_LOCATOR_SIZE) == ZIP64_LOCATOR_SIGNATURE) {
+        const uint64_t zip64_pos = read_le64(eocd - ZIP64_LOCATOR_SIZE + 8);
+        if (zip64_pos + ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE > size
+            || read_le32(data + zip64_pos) != ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+            return unexpected(zip_failure{"", "Corrupted ZIP64 end of central directory"});
+        }
+        count = read_le64(data + zip64_pos + 32);
+        directory_size = read_le64(data + zip64_pos + 40);
+        directory_offset = read_le64(data + zip64_pos + 48);
+    }
+    if (directory_offset > size || directory_size > size - directory_offset) {
+        return unexpected(zip_failure{"", "Central directory is outside of the archive"});
+    }
+
+    std::vector<entry> entries;
+    entries.reserve(std::min<uint64_t>(count, directory_size / CENTRAL_HEADER_SIZE));
+    const uint8_t* p = data + directory_offset;
+    const uint8_t* end = p + directory_size;
+    for (uint64_t i = 0; i < count; i++) {
+        if (end - p < static_cast<ptrdiff_t>(CENTRAL_HEADER_SIZE) || read_le32(p) != CENTRAL_HEADER_SIGNATURE) {
+            return unexpected(zip_failure{"", "Corrupted central directory"});
+        }
+        const uint16_t name_length = read_le16(p + 28);
+        const uint16_t extra_length = read_le16(p + 30);
+        const uint16_t comment_length = read_le16(p + 32);
+        const size_t record = CENTRAL_HEADER_SIZE + name_length + extra_length + comment_length;
+        if (end - p < static_cast<ptrdiff_t>(record)) {
+            return unexpected(zip_failure{"", "Corrupted central directory"});
+        }
+
+        entry e;
+        e.flags = read_le16(p + 8);
+        e.method = read_le16(p + 10);
+        e.time = read_le16(p + 12);
+        e.date = read_le16(p + 14);
+        e.crc32 = read_le32(p + 16);
+        e.compressed_size = read_le32(p + 20);
+        e.uncompressed_size = read_le32(p + 24);
+        e.local_header_offset = read_le32(p + 42);
+        e.name.assign(reinterpret_cast<const char*>(p + CENTRAL_HEADER_SIZE), name_length);
+        if (!apply_zip64_extra(e, p + CENTRAL_HEADER_SIZE + name_length, extra_length)) {
+            return unexpected(zip_failure{e.name, "Corrupted ZIP64 extra field"});
+        }
+        entries.push_back(std::move(e));
+        p += record;
+    }
+
+    return archive_reader(std::move(*mapped), std::move(entries));
+}
+
+std::expected<std::span<const uint8_t>, zip_failure> archive_reader::raw_data(const entry& e) const {
+    const size_t size = file.size();
+    if (e.local_header_offset > size || size - e.local_header_offset < LOCAL_HEADER_SIZE) {
+        return unexpected(zip_failure{e.name, "Local header is outside of the archive"});
+    }
+    const uint8_t* header = file.data() + e.local_header_offset;
+    if (read_le32(header) != LOCAL_HEADER_SIGNATURE) {
+        return unexpected(zip_failure{e.name, "Corrupted local header"});
+    }
+    const uint64_t data_offset = e.local_header_offset + LOCAL_HEADER_SIZE + read_le16(header + 26) + read_le16(header + 28);
+    if (data_offset > size || size - data_offset < e.compressed_size) {
+        return unexpected(zip_failure{e.name, "Entry data is outside of the archive"});
+    }
+    return std::span<const uint8_t>(file.data() + data_offset, e.compressed_size);
+}
+
+extract_result archive_reader::extract(const entry& e, uint8_t* target, size_t target_length) const {
+    if (e.flags & FLAG_ENCRYPTED) {
+        return unexpected(zip_failure{e.name, "Encrypted entries are not supported"});
+    }
+    if (!is_plausible_size(e)) {
+        return unexpected(zip_failure{e.name, "Uncompressed size is implausible for the compressed data"});
+    }
+    if (target_length < e.uncompressed_size) {
+        return unexpected(zip_failure{e.name, "Target data is too short"});
+    }
+    auto raw = raw_data(e);
+    if (!raw) {
+        return unexpected(raw.error());
+    }
+
+    if (e.method == METHOD_STORED) {
+        if (raw->size() != e.uncompressed_size) {
+            return unexpected(zip_failure{e.name, "Sizes of stored entry differ"});
+        }
+        std::copy(raw->begin(), raw->end(), target);
+    } else if (e.method == METHOD_DEFLATED) {
+        // the decoder only reads its source
+        deflate::decoder d(const_cast<uint8_t*>(raw->data()), raw->size());
+        auto result = d.decode(target, e.uncompressed_size);
+        if (!result) {
+            return unexpected(zip_failure{e.name, result.error().message});
+        }
+        if (result->bytes_written != e.uncompressed_size || !d.stream_end()) {
+            return unexpected(zip_failure{e.name, "Uncompressed size differs from the central directory"});
+        }
+    } else {
+        return unexpected(zip_failure{e.name, "Unsupported compression method"});
+    }
+
+    if (crc32(target, e.uncompressed_size) != e.crc32) {
+        return unexpected(zip_failure{e.name, "CRC-32 mismatch"});
+    }
+    return e.uncompressed_size;
+}
+
+extract_result archive_reader::extract_to(const entry& e, const std::filesystem::path& directory) const {
+    const std::filesystem::path name(e.name);
+    if (!is_safe_name(name)) {
+        return unexpected(zip_failure{e.name, "Entry name escapes the target directory"});
+    }
+    const auto path = directory / name;
+    std::error_code error;
+    if (e.is_directory()) {
+        std::filesystem::create_directories(path, error);
+        return error ? extract_result(unexpected(zip_failure{e.name, "Cannot create directory"})) : extract_result(0);
+    }
+    if (!is_plausible_size(e)) {
+        return unexpected(zip_failure{e.name, "Uncompressed size is implausible for the compressed data"});
+    }
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error) {
+        return unexpected(zip_failure{e.name, "Cannot create directory"});
+    }
+
+    auto output = mapped_file::create(path, e.uncompressed_size);
+    if (!output) {
+        return unexpected(zip_failure{e.name, "Cannot create output file"});
+    }
+    return extract(e, output->data(), output->size());
+}
+
+template<typename F>
+static std::vector<extract_result> run_all(thread_pool& pool, const std::vector<entry>& entries, F extract_one) {
+    // longest jobs first, so that the pool is not left waiting for one big entry at the end
+    std::vector<size_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return entries[a].uncompressed_size > entries[b].uncompressed_size;
+    });
+
+    std::vector<std::future<extract_result>> futures(entries.size());
+    for (size_t i : order) {
+        futures[i] = pool.submit([&extract_one, &e = entries[i]]() { return extract_one(e); });
+    }
+
+    std::vector<extract_result> results;
+    results.reserve(entries.size());
+    for (auto& f : futures) {
+        results.push_back(f.get());
+    }
+    return results;
+}
+
+std::vector<extract_result> archive_reader::extract_all(thread_pool& pool, const std::filesystem::path& directory) const {
+    // ZIP allows several entries of one name; only the last of them is written, so that no two
+    // jobs write the same file
+    std::map<std::string, const entry*> last;
+    for (const auto& e : list) {
+        last[std::filesystem::path(e.name).lexically_normal().generic_string()] = &e;
+    }
+    return run_all(pool, list, [&](const entry& e) -> extract_result {
+        if (last.find(std::filesystem::path(e.name).lexically_normal().generic_string())->second != &e) {
+            return 0;
+        }
+        return extract_to(e, directory);
+    });
+}
+
+std::vector<extract_result> archive_reader::extract_all(thread_pool& pool, const entry_sink& sink) const {
+    return run_all(pool, list, [&](const entry& e) -> extract_result {
+        if (!is_plausible_size(e)) {
+            return unexpected(zip_failure{e.name, "Uncompressed size is implausible for the compressed data"});
+        }
+        std::vector<uint8_t> buffer(e.uncompressed_size);
+        auto result = extract(e, buffer.data(), buffer.size());
+        if (result && !sink(e, buffer)) {
+            return unexpected(zip_failure{e.name, "Sink rejected the entry"});
+        }
+        return result;
+    });
+}
+
+} // namespace zipper::zip
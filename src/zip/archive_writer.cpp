@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <fstream>
+#include "checksum.hpp"
+#include "zip/archive_writer.hpp"
+
+namespace zipper::zip
+{
+
+using std::unexpected;
+
+namespace {
+
+constexpr uint16_t VERSION_DEFLATE = 20;
+constexpr uint16_t VERSION_ZIP64 = 45;
+constexpr uint16_t VERSION_MADE_BY = (3 << 8) | VERSION_ZIP64; // unix
+constexpr uint32_t EXTERNAL_FILE = 0100644u << 16;
+constexpr uint32_t EXTERNAL_DIRECTORY = (040755u << 16) | 0x10;
+// 1980-01-01 00:00, so that equal input gives equal archives
+constexpr uint16_t DOS_TIME = 0;
+constexpr uint16_t DOS_DATE = (1 << 5) | 1;
+
+constexpr uint32_t SATURATED = 0xFFFFFFFF;
+
+} // namespace
+
+void archive_writer::add(std::string name, std::vector<uint8_t> data) {
+    auto job = [method = options.method, opts = options.deflate, name, data = std::move(data)]() mutable
+        -> std::expected<compressed, zip_failure> {
+        compressed c{METHOD_STORED, crc32(data.data(), data.size()), data.size(), {}};
+        if (method == METHOD_DEFLATED && !data.empty()) {
+            std::vector<uint8_t> deflated(deflate::compress_bound(data.size()));
+            deflate::optimal_encoder encoder(opts);
+            auto r = encoder.encode(data.data(), data.size(), deflated.data(), deflated.size());
+            if (!r) {
+                return unexpected(zip_failure{name, r.error().message});
+            }
+            if (r->bytes_written < data.size()) {
+                deflated.resize(r->bytes_written);
+                c.method = METHOD_DEFLATED;
+                c.data = std::move(deflated);
+                return c;
+            }
+        }
+        c.data = std::move(data);
+        return c;
+    };
+    entries.push_back(pending{name, pool.submit(std::move(job))});
+}
+
+std::expected<void, zip_failure> archive_writer::write(const std::filesystem::path& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return unexpected(zip_failure{"", "Cannot create archive"});
+    }
+    uint64_t offset = 0;
+    auto emit = [&](const uint8_t* data, size_t length) {
+        out.write(reinterpret_cast<const char*>(data), length);
+        offset += length;
+    };
+
+    // local headers and data, in the order of `add`; later jobs keep running meanwhile
+    std::vector<entry> directory;
+    directory.reserve(entries.size());
+    std::vector<uint8_t> header;
+    for (auto& p : entries) {
+        auto result = p.job.get();
+        if (!result) {
+            return unexpected(result.error());
+        }
+        const entry e{p.name, result->method, FLAG_UTF8, DOS_TIME, DOS_DATE, result->crc32,
+                      result->data.size(), result->uncompressed_size, offset};
+        const bool zip64 = options.force_zip64 || e.compressed_size >= SATURATED || e.uncompressed_size >= SATURATED;
+
+        header.assign(LOCAL_HEADER_SIZE + e.name.size() + (zip64 ? 20 : 0), 0);
+        uint8_t* h = write_le32(header.data(), LOCAL_HEADER_SIGNATURE);
+        h = write_le16(h, zip64 ? VERSION_ZIP64 : VERSION_DEFLATE);
+        h = write_le16(h, e.flags);
+        h = write_le16(h, e.method);
+        h = write_le16(h, e.time);
+        h = write_le16(h, e.date);
+        h = write_le32(h, e.crc32);
+        h = write_le32(h, zip64 ? SATURATED : e.compressed_size);
+        h = write_le32(h, zip64 ? SATURATED : e.uncompressed_size);
+        h = write_le16(h, e.name.size());
+        h = write_le16(h, zip64 ? 20 : 0);
+        h = std::copy(e.name.begin(), e.name.end(), h);
+        if (zip64) {
+            // both sizes are mandatory in the local ZIP64 extra field
+            h = write_le16(h, ZIP64_EXTRA_ID);
+            h = write_le16(h, 16);
+            h = write_le64(h, e.uncompressed_size);
+            write_le64(h, e.compressed_size);
+        }
+        emit(header.data(), header.size());
+        emit(result->data.data(), result->data.size());
+        directory.push_back(e);
+    }
+    entries.clear();
+
+    const uint64_t directory_offset = offset;
+    for (const auto& e : directory) {
+        const bool usize64 = options.force_zip64 || e.uncompressed_size >= SATURATED;
+        const bool csize64 = options.force_zip64 || e.compressed_size >= SATURATED;
+        const bool offset64 = options.force_zip64 || e.local_header_offset >= SATURATED;
+        const uint16_t extra = (usize64 || csize64 || offset64) ? 4 + 8 * (usize64 + csize64 + offset64) : 0;
+
+        header.assign(CENTRAL_HEADER_SIZE + e.name.size() + extra, 0);
+        uint8_t* h = write_le32(header.data(), CENTRAL_HEADER_SIGNATURE);
+        h = write_le16(h, VERSION_MADE_BY);
+        h = write_le16(h, extra != 0 ? VERSION_ZIP64 : VERSION_DEFLATE);
+        h = write_le16(h, e.flags);
+        h = write_le16(h, e.method);
+        h = write_le16(h, e.time);
+        h = write_le16(h, e.date);
+        h = write_le32(h, e.crc32);
+        h = write_le32(h, csize64 ? SATURATED : e.compressed_size);
+        h = write_le32(h, usize64 ? SATURATED : e.uncompressed_size);
+        h = write_le16(h, e.name.size());
+        h = write_le16(h, extra);
+        h = write_le16(h, 0); // comment length
+        h = write_le16(h, 0); // disk number
+        h = write_le16(h, 0); // internal attributes
+        h = write_le32(h, e.is_directory() ? EXTERNAL_DIRECTORY : EXTERNAL_FILE);
+        h = write_le32(h, offset64 ? SATURATED : e.local_header_offset);
+        h = std::copy(e.name.begin(), e.name.end(), h);
+        if (extra != 0) {
+            h = write_le16(h, ZIP64_EXTRA_ID);
+            h = write_le16(h, extra - 4);
+            if (usize64) {
+                h = write_le64(h, e.uncompressed_size);
+            }
+            if (csize64) {
+                h = write_le64(h, e.compressed_size);
+            }
+            if (offset64) {
+                write_le64(h, e.local_header_offset);
+            }
+        }
+        emit(header.data(), header.size());
+    }
+    const uint64_t directory_size = offset - directory_offset;
+    const uint64_t count = directory.size();
+
+    const bool zip64 = options.force_zip64 || count >= 0xFFFF || directory_offset >= SATURATED || directory_size >= SATURATED;
+    if (zip64) {
+        const uint64_t zip64_offset = offset;
+        header.assign(ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE + ZIP64_LOCATOR_SIZE, 0);
+        uint8_t* h = write_le32(header.data(), ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE);
+        h = write_le64(h, ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE - 12);
+        h = write_le16(h, VERSION_MADE_BY);
+        h = write_le16(h, VERSION_ZIP64);
+        h = write_le32(h, 0); // this disk
+        h = write_le32(h, 0); // disk of the central directory
+        h = write_le64(h, count);
+        h = write_le64(h, count);
+        h = write_le64(h, directory_size);
+        h = write_le64(h, directory_offset);
+
+        h = write_le32(h, ZIP64_LOCATOR_SIGNATURE);
+        h = write_le32(h, 0);
+        h = write_le64(h, zip64_offset);
+        write_le32(h, 1); // total disks
+        emit(header.data(), header.size());
+    }
+
+    header.assign(END_OF_CENTRAL_DIRECTORY_SIZE, 0);
+    uint8_t* h = write_le32(header.data(), END_OF_CENTRAL_DIRECTORY_SIGNATURE);
+    h = write_le16(h, 0);
+    h = write_le16(h, 0);
+    h = write_le16(h, zip64 ? 0xFFFF : count);
+    h = write_le16(h, zip64 ? 0xFFFF : count);
+    h = write_le32(h, zip64 ? SATURATED : directory_size);
+    h = write_le32(h, zip64 ? SATURATED : directory_offset);
+    write_le16(h, 0); // comment length
+    emit(header.data(), header.size());
+
+    out.flush();
+    if (!out) {
+        return unexpected(zip_failure{"", "Cannot write archive"});
+    }
+    return {};
+}
+
+} // namespace zipper::zip
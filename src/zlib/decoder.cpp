@@ -0,0 +1,66 @@
+#include "checksum.hpp"
+#include "deflate/decoder.hpp"
+#include "zlib/decoder.hpp"
+#include "zlib/encoder.hpp"
+
+namespace zipper::zlib
+{
+
+using std::unexpected;
+
+static uint32_t read_be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+decode_result decoder::decode(uint8_t* target, size_t target_length) {
+    if (source_length < HEADER_SIZE + TRAILER_SIZE) {
+        return unexpected(decode_failure{0, 0, 0, "Source data is too short for a zlib stream"});
+    }
+    const uint8_t cmf = source[0];
+    const uint8_t flg = source[1];
+    if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7) {
+        return unexpected(decode_failure{0, 0, 0, "Unknown compression method of zlib stream"});
+    }
+    if (((cmf << 8) | flg) % 31 != 0) {
+        return unexpected(decode_failure{1, 8, 0, "Corrupted zlib header"});
+    }
+
+    size_t offset = HEADER_SIZE;
+    const bool has_dictionary = flg & 0x20;
+    if (has_dictionary) {
+        if (source_length < HEADER_SIZE + DICTID_SIZE + TRAILER_SIZE) {
+            return unexpected(decode_failure{offset, offset * 8, 0, "Source data is too short for a zlib stream"});
+        }
+        if (dict == nullptr) {
+            return unexpected(decode_failure{offset, offset * 8, 0, "Preset dictionary is required"});
+        }
+        if (read_be32(source + offset) != dict->adler32()) {
+            return unexpected(decode_failure{offset, offset * 8, 0, "Preset dictionary does not match DICTID"});
+        }
+        offset += DICTID_SIZE;
+    }
+
+    const size_t raw_length = source_length - offset;
+    auto raw = has_dictionary ? deflate::decoder(source + offset, raw_length, *dict) : deflate::decoder(source + offset, raw_length);
+    auto result = raw.decode(target, target_length);
+    if (!result) {
+        result.error().byte_offset += offset;
+        return result;
+    }
+
+    if (!raw.stream_end()) {
+        const size_t end = offset + result->bits_read / 8;
+        return unexpected(decode_failure{end, end * 8, 0, raw.truncated() ? "Target data is too short" : "Unexpected end of deflate stream"});
+    }
+
+    const size_t trailer = offset + (result->bits_read + 7) / 8;
+    if (source_length < trailer + TRAILER_SIZE) {
+        return unexpected(decode_failure{trailer, trailer * 8, 0, "Unexpected end of input before Adler-32"});
+    }
+    if (read_be32(source + trailer) != adler32(target, result->bytes_written)) {
+        return unexpected(decode_failure{trailer, trailer * 8, 0, "Adler-32 mismatch"});
+    }
+    return decode_success{result->bytes_written, (trailer + TRAILER_SIZE) * 8};
+}
+
+} // namespace zipper::zlib
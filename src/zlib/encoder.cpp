@@ -0,0 +1,50 @@
+#include "checksum.hpp"
+#include "zlib/encoder.hpp"
+
+namespace zipper::zlib
+{
+
+using std::unexpected;
+
+static void write_be32(uint8_t* p, uint32_t value) {
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+size_t compress_bound(size_t source_length) {
+    return deflate::compress_bound(source_length) + HEADER_SIZE + DICTID_SIZE + TRAILER_SIZE;
+}
+
+size_t compress_bound(size_t source_length, const deflate::stream_options& options) {
+    return deflate::compress_bound(source_length, options) + HEADER_SIZE + DICTID_SIZE + TRAILER_SIZE;
+}
+
+encode_result encoder::encode(const uint8_t* source, size_t source_length, uint8_t* target, size_t target_length) {
+    const size_t header = HEADER_SIZE + (dict != nullptr ? DICTID_SIZE : 0);
+    if (target_length < header + TRAILER_SIZE) {
+        return unexpected(encode_failure{0, "Target buffer is too small"});
+    }
+
+    // deflate with a 32K window
+    const uint8_t cmf = 0x78;
+    uint8_t flg = (level << 6) | (dict != nullptr ? 0x20 : 0);
+    flg |= 31 - ((cmf << 8) | flg) % 31;
+    target[0] = cmf;
+    target[1] = flg;
+    if (dict != nullptr) {
+        write_be32(target + HEADER_SIZE, dict->adler32());
+    }
+
+    auto result = raw->encode(source, source_length, target + header, target_length - header - TRAILER_SIZE);
+    if (!result) {
+        result.error().byte_offset += header;
+        return result;
+    }
+    const size_t trailer = header + result->bytes_written;
+    write_be32(target + trailer, adler32(source, source_length));
+    return encode_success{source_length, trailer + TRAILER_SIZE};
+}
+
+} // namespace zipper::zlib
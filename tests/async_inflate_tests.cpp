@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fcntl.h>
+#include <random>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+#include "async/event_loop.hpp"
+#include "async/inflate.hpp"
+#include "test_helpers.hpp"
+
+namespace zipper::async {
+
+static std::vector<uint8_t> sample(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> result(size);
+    for (size_t i = 0; i < size; i++) {
+        // half noise, half repetitive so both stored and huffman blocks appear
+        result[i] = (i / 4096) % 2 ? static_cast<uint8_t>(rng()) : static_cast<uint8_t>('a' + i % 7);
+    }
+    return result;
+}
+
+static std::vector<uint8_t> compress(const std::vector<uint8_t>& input) {
+    return test::deflate_compress(input, deflate::optimal_options{.iterations = 0});
+}
+
+struct vector_sink {
+    std::vector<uint8_t> data;
+    task<ssize_t> write(std::span<const uint8_t> buffer) {
+        data.insert(data.end(), buffer.begin(), buffer.end());
+        co_return static_cast<ssize_t>(buffer.size());
+    }
+};
+
+// writes `data` in small pieces and closes the pipe
+static task<ssize_t> produce(event_loop& loop, int fd, const std::vector<uint8_t>& data) {
+    fd_sink sink(loop, fd);
+    size_t offset = 0;
+    while (offset < data.size()) {
+        const size_t n = std::min<size_t>(1500, data.size() - offset);
+        if (co_await sink.write(std::span<const uint8_t>(data.data() + offset, n)) < 0) {
+            break;
+        }
+        offset += n;
+    }
+    close(fd);
+    co_return static_cast<ssize_t>(offset);
+}
+
+static task<decode_result> consume(event_loop& loop, int fd, deflate::stream_decoder& decoder, vector_sink& sink) {
+    fd_source source(loop, fd);
+    auto result = co_await inflate(decoder, source, sink, 4096);
+    close(fd);
+    co_return result;
+}
+
+TEST(AsyncInflate, ManyPipesOnOneThread) {
+    constexpr size_t STREAMS = 24;
+    event_loop loop;
+
+    std::vector<std::vector<uint8_t>> expected(STREAMS);
+    std::vector<std::vector<uint8_t>> compressed(STREAMS);
+    std::vector<deflate::stream_decoder> decoders(STREAMS);
+    std::vector<vector_sink> sinks(STREAMS);
+    size_t succeeded = 0;
+
+    for (size_t i = 0; i < STREAMS; i++) {
+        expected[i] = sample(40000 + i * 1000, i);
+        compressed[i] = compress(expected[i]);
+
+        int fds[2];
+        ASSERT_EQ(pipe2(fds, O_NONBLOCK), 0);
+        loop.spawn(consume(loop, fds[0], decoders[i], sinks[i]), [&](decode_result r) {
+            EXPECT_TRUE(r) << r.error().message;
+            succeeded += r.has_value();
+        });
+        loop.spawn(produce(loop, fds[1], compressed[i]), [](ssize_t) {});
+    }
+
+    EXPECT_TRUE(loop.run());
+    EXPECT_EQ(succeeded, STREAMS);
+    for (size_t i = 0; i < STREAMS; i++) {
+        EXPECT_EQ(sinks[i].data, expected[i]) << i;
+    }
+}
+
+TEST(AsyncInflate, RegularFileIsAlwaysReady) {
+    const auto expected = sample(50000, 99);
+    const auto compressed = compress(expected);
+
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(fwrite(compressed.data(), 1, compressed.size(), file), compressed.size());
+    fflush(file);
+    const int fd = dup(fileno(file));
+    lseek(fd, 0, SEEK_SET);
+    fclose(file);
+
+    event_loop loop;
+    deflate::stream_decoder decoder;
+    vector_sink sink;
+    decode_result result = std::unexpected(decode_failure{0, 0, 0, "not run"});
+    loop.spawn(consume(loop, fd, decoder, sink), [&](decode_result r) { result = r; });
+
+    EXPECT_TRUE(loop.run());
+    ASSERT_TRUE(result) << result.error().message;
+    EXPECT_EQ(result->bytes_written, expected.size());
+    EXPECT_EQ(sink.data, expected);
+}
+
+TEST(AsyncInflate, TruncatedInputFails) {
+    const auto expected = sample(20000, 5);
+    auto compressed = compress(expected);
+    compressed.resize(compressed.size() / 2);
+
+    event_loop loop;
+    int fds[2];
+    ASSERT_EQ(pipe2(fds, O_NONBLOCK), 0);
+    deflate::stream_decoder decoder;
+    vector_sink sink;
+    bool failed = false;
+    loop.spawn(consume(loop, fds[0], decoder, sink), [&](decode_result r) { failed = !r; });
+    loop.spawn(produce(loop, fds[1], compressed), [](ssize_t) {});
+
+    EXPECT_TRUE(loop.run());
+    EXPECT_TRUE(failed);
+}
+
+TEST(AsyncInflate, LoopWithoutEpollFails) {
+    rlimit limit;
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &limit), 0);
+    rlimit none = limit;
+    none.rlim_cur = 0;
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &none), 0);
+    event_loop loop;
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limit), 0);
+    EXPECT_EQ(loop.error(), EMFILE);
+    EXPECT_FALSE(loop.run());
+}
+
+}
@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gzip/bgzf_reader.hpp"
+#include "gzip/bgzf_writer.hpp"
+#include "gzip/decoder.hpp"
+#include "gzip/encoder.hpp"
+
+namespace zipper::gzip {
+
+namespace fs = std::filesystem;
+
+static std::vector<uint8_t> sample(size_t size) {
+    std::mt19937 rng(21);
+    std::vector<uint8_t> result(size);
+    for (size_t i = 0; i < size; i++) {
+        result[i] = (i / 4096) % 4 == 0 ? static_cast<uint8_t>(rng()) : static_cast<uint8_t>('a' + (i * 7 + i / 100) % 13);
+    }
+    return result;
+}
+
+static std::vector<uint8_t> read_file(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+}
+
+class Bgzf : public ::testing::Test {
+protected:
+    fs::path dir;
+    std::vector<uint8_t> input = sample(500000);
+    thread_pool pool{4};
+
+    void SetUp() override {
+        dir = fs::temp_directory_path() / ("zipper-bgzf-" + std::to_string(::getpid()) + "-"
+            + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    fs::path build(bgzf_options opts = bgzf_options{}) {
+        opts.deflate.iterations = 0;
+        const auto path = dir / "data.gz";
+        auto writer = bgzf_writer::create(pool, path, opts);
+        EXPECT_TRUE(writer);
+        // uneven pieces, so that blocks are filled across calls
+        for (size_t pos = 0; pos < input.size();) {
+            const size_t n = std::min<size_t>(10007, input.size() - pos);
+            EXPECT_TRUE(writer->write(input.data() + pos, n));
+            pos += n;
+        }
+        auto r = writer->finish();
+        EXPECT_TRUE(r) << r.error().message;
+        EXPECT_EQ(writer->blocks().size(), (input.size() + BGZF_BLOCK_DATA - 1) / BGZF_BLOCK_DATA);
+        return path;
+    }
+};
+
+TEST_F(Bgzf, PlainGzipDecoderReadsIt)
+{
+    auto file = read_file(build());
+    ASSERT_GE(file.size(), BGZF_EOF.size());
+    EXPECT_TRUE(std::equal(BGZF_EOF.begin(), BGZF_EOF.end(), file.end() - BGZF_EOF.size()));
+
+    std::vector<uint8_t> actual(input.size());
+    decoder d(file.data(), file.size());
+    auto r = d.decode(actual.data(), actual.size());
+    ASSERT_TRUE(r) << r.error().message;
+    EXPECT_EQ(actual, input);
+}
+
+TEST_F(Bgzf, ParallelReadAll)
+{
+    auto reader = bgzf_reader::open(build());
+    ASSERT_TRUE(reader) << reader.error().message;
+    EXPECT_EQ(reader->size(), input.size());
+    EXPECT_EQ(reader->blocks().size(), 8u);
+    for (const auto& b : reader->blocks()) {
+        EXPECT_LE(b.compressed_size, BGZF_MAX_BLOCK_SIZE);
+        EXPECT_LE(b.uncompressed_size, BGZF_BLOCK_DATA);
+    }
+
+    std::vector<uint8_t> actual(input.size());
+    auto r = reader->read_all(pool, actual.data(), actual.size());
+    ASSERT_TRUE(r) << r.error().message;
+    EXPECT_EQ(actual, input);
+    EXPECT_FALSE(reader->read_all(pool, actual.data(), actual.size() - 1));
+}
+
+TEST_F(Bgzf, IndexGivesTheSameBlocks)
+{
+    const auto path = build(bgzf_options{.write_index = true});
+    auto scanned = bgzf_reader::open(path);
+    auto indexed = bgzf_reader::open(path, path.string() + ".gzi");
+    ASSERT_TRUE(scanned);
+    ASSERT_TRUE(indexed) << indexed.error().message;
+    ASSERT_EQ(indexed->blocks().size(), scanned->blocks().size());
+    for (size_t i = 0; i < scanned->blocks().size(); i++) {
+        const auto& a = scanned->blocks()[i];
+        const auto& b = indexed->blocks()[i];
+        EXPECT_EQ(a.compressed_offset, b.compressed_offset);
+        EXPECT_EQ(a.uncompressed_offset, b.uncompressed_offset);
+        EXPECT_EQ(a.compressed_size, b.compressed_size);
+        EXPECT_EQ(a.uncompressed_size, b.uncompressed_size);
+    }
+    auto entries = read_index(path.string() + ".gzi");
+    ASSERT_TRUE(entries);
+    EXPECT_EQ(entries->size(), scanned->blocks().size() - 1);
+}
+
+TEST_F(Bgzf, VirtualOffsetSeek)
+{
+    auto reader = bgzf_reader::open(build());
+    ASSERT_TRUE(reader);
+    std::mt19937 rng(22);
+    for (int i = 0; i < 50; i++) {
+        const size_t start = rng() % input.size();
+        const size_t length = rng() % 150000;
+        const uint64_t voffset = reader->virtual_offset(start);
+        auto back = reader->uncompressed_offset(voffset);
+        ASSERT_TRUE(back);
+        EXPECT_EQ(*back, start);
+
+        std::vector<uint8_t> actual(length);
+        auto n = reader->read(voffset, actual.data(), actual.size());
+        ASSERT_TRUE(n) << n.error().message;
+        const size_t expected_length = std::min(length, input.size() - start);
+        ASSERT_EQ(*n, expected_length);
+        EXPECT_TRUE(std::equal(actual.begin(), actual.begin() + *n, input.begin() + start));
+    }
+
+    const auto& second = reader->blocks()[1];
+    EXPECT_EQ(reader->virtual_offset(second.uncompressed_offset + 5), make_virtual_offset(second.compressed_offset, 5));
+    EXPECT_FALSE(reader->uncompressed_offset(make_virtual_offset(second.compressed_offset + 1, 0)));
+    EXPECT_FALSE(reader->uncompressed_offset(make_virtual_offset(second.compressed_offset, second.uncompressed_size)));
+    auto end = reader->uncompressed_offset(reader->virtual_offset(input.size()));
+    ASSERT_TRUE(end);
+    EXPECT_EQ(*end, input.size());
+}
+
+TEST_F(Bgzf, FlushEndsBlock)
+{
+    const auto path = dir / "records.gz";
+    bgzf_options opts;
+    opts.deflate.iterations = 0;
+    auto writer = bgzf_writer::create(pool, path, opts);
+    ASSERT_TRUE(writer);
+    for (size_t size : {100, 2000, 30}) {
+        ASSERT_TRUE(writer->write(input.data(), size));
+        ASSERT_TRUE(writer->flush());
+        ASSERT_TRUE(writer->flush());
+    }
+    ASSERT_TRUE(writer->finish());
+    ASSERT_EQ(writer->blocks().size(), 3u);
+    EXPECT_EQ(writer->blocks()[1].uncompressed_offset, 100u);
+    EXPECT_EQ(writer->blocks()[2].uncompressed_size, 30u);
+}
+
+TEST_F(Bgzf, EmptyFile)
+{
+    const auto path = dir / "empty.gz";
+    auto writer = bgzf_writer::create(pool, path, bgzf_options{.write_index = true});
+    ASSERT_TRUE(writer);
+    ASSERT_TRUE(writer->finish());
+    auto file = read_file(path);
+    EXPECT_TRUE(std::equal(file.begin(), file.end(), BGZF_EOF.begin(), BGZF_EOF.end()));
+
+    auto reader = bgzf_reader::open(path);
+    ASSERT_TRUE(reader);
+    EXPECT_EQ(reader->size(), 0u);
+    EXPECT_TRUE(reader->blocks().empty());
+    auto indexed = bgzf_reader::open(path, path.string() + ".gzi");
+    ASSERT_TRUE(indexed);
+    EXPECT_TRUE(indexed->blocks().empty());
+}
+
+TEST_F(Bgzf, RejectsPlainGzipAndCorruption)
+{
+    std::vector<uint8_t> plain(compress_bound(1000));
+    encoder e(deflate::optimal_options{.iterations = 0});
+    auto r = e.encode(input.data(), 1000, plain.data(), plain.size());
+    ASSERT_TRUE(r);
+    plain.resize(r->bytes_written);
+    const auto plain_path = dir / "plain.gz";
+    std::ofstream(plain_path, std::ios::binary).write(reinterpret_cast<const char*>(plain.data()), plain.size());
+    EXPECT_FALSE(bgzf_reader::open(plain_path));
+
+    const auto path = build();
+    auto file = read_file(path);
+    auto reader = bgzf_reader::open(path);
+    ASSERT_TRUE(reader);
+    // a flipped byte inside the payload of the third block
+    const auto& third = reader->blocks()[2];
+    file[third.compressed_offset + third.compressed_size / 2] ^= 0x40;
+    const auto damaged_path = dir / "damaged.gz";
+    std::ofstream(damaged_path, std::ios::binary).write(reinterpret_cast<const char*>(file.data()), file.size());
+    auto damaged = bgzf_reader::open(damaged_path);
+    ASSERT_TRUE(damaged);
+    std::vector<uint8_t> actual(input.size());
+    EXPECT_FALSE(damaged->read_all(pool, actual.data(), actual.size()));
+    EXPECT_TRUE(damaged->read_block(0, actual.data()));
+}
+
+}
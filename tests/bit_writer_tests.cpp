@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "bit_buffer.hpp"
+#include "bit_writer.hpp"
+#include "histogram.hpp"
+
+namespace zipper {
+
+struct bit_field {
+    uint64_t value;
+    uint32_t length;
+};
+
+static std::vector<bit_field> random_fields(size_t n, uint32_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<bit_field> fields(n);
+    for (auto& f : fields) {
+        f.length = rng() % 25;
+        f.value = rng() & ((uint64_t{1} << f.length) - 1);
+    }
+    return fields;
+}
+
+TEST(BitWriter, MatchesBitBuffer)
+{
+    const auto fields = random_fields(5000, 1);
+    for (size_t start = 0; start < 8; start++) {
+        // the writer keeps the bits before `start` and writes exactly the same stream
+        std::vector<uint8_t> expected(10000, 0x5A);
+        bit_buffer reference(expected.data(), expected.size(), start);
+        std::vector<uint8_t> actual(10000, 0x5A);
+        bit_writer w(actual.data(), actual.size(), start);
+        for (size_t i = 0; i < fields.size(); i += 2) {
+            reference.write_bits(fields[i].value, fields[i].length);
+            reference.write_bits(fields[i + 1].value, fields[i + 1].length);
+            w.add(fields[i].value, fields[i].length);
+            w.add(fields[i + 1].value, fields[i + 1].length);
+            w.flush();
+        }
+        w.finish();
+        ASSERT_EQ(w.offset(), reference.offset());
+        const size_t bytes = (reference.offset() + 7) / 8;
+        for (size_t i = 0; i < bytes; i++) {
+            const uint8_t mask = i == bytes - 1 && reference.offset() % 8 != 0 ? (1u << reference.offset() % 8) - 1 : 0xFF;
+            ASSERT_EQ(actual[i] & mask, expected[i] & mask) << "start " << start << ", byte " << i;
+        }
+    }
+}
+
+TEST(BitWriter, StaysInsideTarget)
+{
+    // the 8-byte stores stop short of the end, the tail is written byte by byte
+    std::vector<uint8_t> storage(32, 0xEE);
+    bit_writer w(storage.data(), 16, 0);
+    for (int i = 0; i < 32; i++) {
+        w.write(0x3, 4);
+    }
+    w.finish();
+    EXPECT_EQ(w.offset(), 128u);
+    for (size_t i = 0; i < 16; i++) {
+        EXPECT_EQ(storage[i], 0x33);
+    }
+    for (size_t i = 16; i < storage.size(); i++) {
+        EXPECT_EQ(storage[i], 0xEE);
+    }
+}
+
+TEST(BitWriter, FullAccumulator)
+{
+    // 7 pending bits plus 57 fill all 64
+    std::array<uint8_t, 16> out{};
+    bit_writer w(out.data(), out.size(), 0);
+    w.write(0x7F, 7);
+    w.write((uint64_t{1} << 57) - 1, 57);
+    w.write(0, 8);
+    w.finish();
+    EXPECT_EQ(w.offset(), 72u);
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_EQ(out[i], 0xFF);
+    }
+    EXPECT_EQ(out[8], 0);
+}
+
+TEST(Histogram, MatchesCounting)
+{
+    std::mt19937 rng(2);
+    for (size_t length : {0, 1, 7, 8, 9, 1000, 4099}) {
+        std::vector<uint8_t> data(length);
+        for (auto& b : data) {
+            b = rng() % 3 == 0 ? static_cast<uint8_t>(rng()) : 'x';
+        }
+        std::array<uint32_t, 256> expected{};
+        for (auto b : data) {
+            expected[b]++;
+        }
+        std::array<uint32_t, 256> actual{};
+        byte_histogram(data.data(), data.size(), actual);
+        EXPECT_EQ(actual, expected) << length;
+
+        // counts accumulate over calls
+        byte_histogram(data.data(), data.size(), actual);
+        for (auto& c : expected) {
+            c *= 2;
+        }
+        EXPECT_EQ(actual, expected) << length;
+    }
+}
+
+}
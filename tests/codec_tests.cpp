@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "codec_registry.hpp"
+#include "gzip/decoder.hpp"
+#include "gzip/encoder.hpp"
+#include "lz/decoder.hpp"
+#include "lz/encoder.hpp"
+#include "lz/format.hpp"
+
+namespace zipper {
+
+static std::vector<uint8_t> records(size_t size) {
+    const std::string fields[] = {"{\"key\":", "\"session:", "\",\"ttl\":3600", ",\"hits\":", "}\n"};
+    std::mt19937 rng(11);
+    std::vector<uint8_t> result;
+    while (result.size() < size) {
+        const auto& f = fields[rng() % 5];
+        result.insert(result.end(), f.begin(), f.end());
+        for (uint32_t i = rng() % 6; i > 0; i--) {
+            result.push_back(static_cast<uint8_t>('0' + rng() % 10));
+        }
+    }
+    result.resize(size);
+    return result;
+}
+
+static std::vector<uint8_t> random_bytes(size_t size) {
+    std::mt19937 rng(12);
+    std::vector<uint8_t> result(size);
+    for (auto& b : result) {
+        b = static_cast<uint8_t>(rng());
+    }
+    return result;
+}
+
+static std::vector<uint8_t> encode(encoder_if& e, size_t bound, const std::vector<uint8_t>& input) {
+    std::vector<uint8_t> output(bound);
+    auto r = e.encode(input.data(), input.size(), output.data(), output.size());
+    EXPECT_TRUE(r) << r.error().message;
+    output.resize(r ? r->bytes_written : 0);
+    return output;
+}
+
+class LzRoundTrip : public testing::Test,
+    public testing::WithParamInterface<size_t>
+{
+};
+
+TEST_P(LzRoundTrip, Records)
+{
+    const auto input = records(GetParam());
+    lz::encoder e;
+    auto compressed = encode(e, lz::compress_bound(input.size()), input);
+    if (input.size() > 1000) {
+        EXPECT_LT(compressed.size(), input.size() / 2);
+    }
+    EXPECT_EQ(lz::decoder::content_size(compressed.data(), compressed.size()), input.size());
+
+    std::vector<uint8_t> actual(input.size());
+    lz::decoder d(compressed.data(), compressed.size());
+    auto r = d.decode(actual.data(), actual.size());
+    ASSERT_TRUE(r) << r.error().message;
+    EXPECT_EQ(r->bytes_written, input.size());
+    EXPECT_EQ(r->bits_read, compressed.size() * 8);
+    EXPECT_EQ(actual, input);
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, LzRoundTrip, ::testing::Values(0, 1, 12, 13, 100, 4096, 70000, 1 << 20));
+
+TEST(Lz, IncompressibleAndRuns)
+{
+    for (const auto& input : {random_bytes(100000), std::vector<uint8_t>(100000, 'a')}) {
+        lz::encoder e;
+        auto compressed = encode(e, lz::compress_bound(input.size()), input);
+        EXPECT_LE(compressed.size(), lz::compress_bound(input.size()));
+        std::vector<uint8_t> actual(input.size());
+        lz::decoder d(compressed.data(), compressed.size());
+        ASSERT_TRUE(d.decode(actual.data(), actual.size()));
+        EXPECT_EQ(actual, input);
+    }
+}
+
+TEST(Lz, RejectsCorruptStreams)
+{
+    const auto input = records(5000);
+    lz::encoder e;
+    const auto compressed = encode(e, lz::compress_bound(input.size()), input);
+    std::vector<uint8_t> actual(input.size() + 64);
+
+    // every truncation is detected
+    for (size_t n = 0; n < compressed.size(); n += 7) {
+        lz::decoder d(compressed.data(), n);
+        EXPECT_FALSE(d.decode(actual.data(), actual.size())) << n;
+    }
+    // target smaller than the stated size
+    lz::decoder small(compressed.data(), compressed.size());
+    EXPECT_FALSE(small.decode(actual.data(), input.size() - 1));
+    // random damage never reads or writes out of bounds
+    std::mt19937 rng(13);
+    for (int i = 0; i < 200; i++) {
+        auto damaged = compressed;
+        damaged[lz::HEADER_SIZE + rng() % (damaged.size() - lz::HEADER_SIZE)] ^= static_cast<uint8_t>(1 + rng() % 255);
+        lz::decoder d(damaged.data(), damaged.size());
+        (void)d.decode(actual.data(), actual.size());
+    }
+}
+
+TEST(Lz, TargetTooSmall)
+{
+    const auto input = random_bytes(1000);
+    std::vector<uint8_t> output(500);
+    lz::encoder e;
+    EXPECT_FALSE(e.encode(input.data(), input.size(), output.data(), output.size()));
+}
+
+TEST(Gzip, DecodesMembersFromPython)
+{
+    // python: GzipFile(filename='hello.txt', mtime=0) followed by gzip.compress(mtime=0)
+    std::vector<uint8_t> compressed = {
+        0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x2e, 0x74, 0x78,
+        0x74, 0x00, 0xcb, 0x48, 0xcd, 0xc9, 0xc9, 0xd7, 0x51, 0x48, 0xaf, 0xca, 0x2c, 0x50, 0xc8, 0x4d, 0xcd, 0x4d,
+        0x4a, 0x2d, 0x52, 0xc8, 0xcf, 0x4b, 0xe5, 0x02, 0x00, 0x42, 0x24, 0x4e, 0xa2, 0x17, 0x00, 0x00, 0x00, 0x1f,
+        0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x4b, 0xcc, 0x4b, 0x51, 0xc8, 0x4d, 0xcd, 0x4d, 0x4a,
+        0x2d, 0x52, 0x28, 0x29, 0xcf, 0xe7, 0x02, 0x00, 0xaf, 0xce, 0xb1, 0xc7, 0x0f, 0x00, 0x00, 0x00
+    };
+    const std::string expected = "hello, gzip member one\nand member two\n";
+    std::vector<uint8_t> actual(expected.size());
+    gzip::decoder d(compressed.data(), compressed.size());
+    auto r = d.decode(actual.data(), actual.size());
+    ASSERT_TRUE(r) << r.error().message;
+    EXPECT_EQ(std::string(actual.begin(), actual.end()), expected);
+    EXPECT_EQ(r->bits_read, compressed.size() * 8);
+
+    compressed[compressed.size() - 5] ^= 1;
+    gzip::decoder corrupted(compressed.data(), compressed.size());
+    EXPECT_FALSE(corrupted.decode(actual.data(), actual.size()));
+}
+
+TEST(Gzip, RoundTrip)
+{
+    const auto input = records(20000);
+    gzip::encoder e(deflate::optimal_options{.iterations = 1});
+    auto compressed = encode(e, gzip::compress_bound(input.size()), input);
+    std::vector<uint8_t> actual(input.size());
+    gzip::decoder d(compressed.data(), compressed.size());
+    auto r = d.decode(actual.data(), actual.size());
+    ASSERT_TRUE(r) << r.error().message;
+    EXPECT_EQ(actual, input);
+}
+
+TEST(CodecRegistry, DetectsEveryBuiltinFormat)
+{
+    const auto registry = codec_registry::with_builtin();
+    // incompressible input has to fit `compress_bound` as well
+    for (const auto& input : {records(3000), random_bytes(100000)}) {
+        for (const char* name : {"lz", "gzip", "zlib", "deflate"}) {
+            const codec* c = registry.find(name);
+            ASSERT_NE(c, nullptr) << name;
+            auto e = c->make_encoder();
+            auto compressed = encode(*e, c->compress_bound(input.size()), input);
+
+            const codec* detected = registry.detect(compressed);
+            ASSERT_NE(detected, nullptr) << name;
+            EXPECT_EQ(detected->name, name);
+
+            std::unique_ptr<decoder_if> d = registry.open(compressed.data(), compressed.size());
+            ASSERT_NE(d, nullptr);
+            std::vector<uint8_t> actual(input.size());
+            auto r = d->decode(actual.data(), actual.size());
+            ASSERT_TRUE(r) << name << ": " << r.error().message;
+            EXPECT_EQ(actual, input) << name;
+        }
+    }
+}
+
+TEST(CodecRegistry, RejectsUnknownData)
+{
+    const auto registry = codec_registry::with_builtin();
+    // block type 3 is reserved, so this is not raw deflate either
+    std::vector<uint8_t> data = {0x07, 0x00, 0x00};
+    EXPECT_EQ(registry.detect(data), nullptr);
+    EXPECT_EQ(registry.open(data.data(), data.size()), nullptr);
+    EXPECT_EQ(registry.detect({}), nullptr);
+    EXPECT_EQ(registry.find("brotli"), nullptr);
+}
+
+TEST(CodecRegistry, LaterCodecsTakePrecedence)
+{
+    auto registry = codec_registry::with_builtin();
+    registry.add(codec{"custom", [](std::span<const uint8_t> data) { return !data.empty() && data[0] == 0x78; }, nullptr, nullptr, nullptr});
+    const std::vector<uint8_t> zlib_header = {0x78, 0xDA};
+    EXPECT_EQ(registry.detect(zlib_header)->name, "custom");
+    EXPECT_EQ(registry.all().size(), 5u);
+}
+
+}
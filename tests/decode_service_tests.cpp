@@ -0,0 +1,410 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <random>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "deflate/optimal_encoder.hpp"
+#include "gzip/encoder.hpp"
+#include "service/decode_client.hpp"
+#include "service/decode_server.hpp"
+#include "zlib/encoder.hpp"
+
+namespace zipper::service {
+
+static std::string service_payload(size_t records, uint32_t seed) {
+    std::mt19937 rng(seed);
+    const char* names[] = {"alice", "bob", "carol", "dave"};
+    std::string result;
+    for (size_t i = 0; i < records; i++) {
+        result += "{\"user\":\"" + std::string(names[rng() % 4]) + "\",\"amount\":" + std::to_string(rng() % 10000) + "}\n";
+    }
+    return result;
+}
+
+static std::vector<uint8_t> pack_payload(const std::string& text, stream_format format, std::shared_ptr<const deflate::dictionary> dict = nullptr) {
+    deflate::optimal_options opts;
+    opts.iterations = 1;
+    std::unique_ptr<encoder_if> encoder;
+    if (format == stream_format::gzip) {
+        encoder = std::make_unique<gzip::encoder>(opts);
+    } else if (format == stream_format::zlib) {
+        encoder = std::make_unique<zlib::encoder>(opts, std::move(dict));
+    } else {
+        encoder = std::make_unique<deflate::optimal_encoder>(opts, std::move(dict));
+    }
+    std::vector<uint8_t> out(text.size() + text.size() / 8 + 1024);
+    auto r = encoder->encode(reinterpret_cast<const uint8_t*>(text.data()), text.size(), out.data(), out.size());
+    EXPECT_TRUE(r) << r.error().message;
+    out.resize(r ? r->bytes_written : 0);
+    return out;
+}
+
+// Stands in for the worker processes of a host: every client connects on its own and shares
+// its own segment, compressed input in the first half and output in the second.
+class DecodeService : public testing::Test {
+protected:
+    static constexpr size_t SEGMENT_SIZE = 1 << 20;
+    static constexpr size_t OUTPUT_OFFSET = SEGMENT_SIZE / 2;
+
+    thread_pool pool{2};
+    std::shared_ptr<const deflate::dictionary> dict;
+    std::unique_ptr<decode_server> server;
+    std::filesystem::path socket_path;
+
+    void SetUp() override {
+        const std::string sample = service_payload(500, 1);
+        dict = std::make_shared<const deflate::dictionary>(reinterpret_cast<const uint8_t*>(sample.data()), sample.size());
+        server = std::make_unique<decode_server>(pool, server_options{.max_segments = 4, .max_in_flight = 2});
+        server->add_dictionary(dict);
+        socket_path = std::filesystem::temp_directory_path() / ("zipper-service-" + std::to_string(getpid()) + ".sock");
+        auto started = server->start(socket_path);
+        ASSERT_TRUE(started) << std::strerror(started.error());
+    }
+
+    void TearDown() override {
+        server->stop();
+        EXPECT_FALSE(std::filesystem::exists(socket_path));
+    }
+
+    struct loopback_client {
+        decode_client client;
+        shared_segment segment;
+        uint32_t number = 0;
+    };
+
+    loopback_client connect() {
+        loopback_client c;
+        auto client = decode_client::connect(socket_path);
+        EXPECT_TRUE(client);
+        auto segment = shared_segment::create(SEGMENT_SIZE);
+        EXPECT_TRUE(segment);
+        if (client && segment) {
+            c.client = std::move(*client);
+            c.segment = std::move(*segment);
+            auto number = c.client.attach(c.segment);
+            EXPECT_TRUE(number) << number.error().message;
+            c.number = number.value_or(0);
+        }
+        return c;
+    }
+
+    // a client speaking the protocol by hand, so that it can have several requests outstanding
+    int raw_connect() const {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, socket_path.c_str());
+        const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    static bool send_request(int fd, request r, int segment_fd = -1) {
+        iovec iov{&r, sizeof(r)};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        if (segment_fd >= 0) {
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            cmsghdr* h = CMSG_FIRSTHDR(&msg);
+            h->cmsg_level = SOL_SOCKET;
+            h->cmsg_type = SCM_RIGHTS;
+            h->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(h), &segment_fd, sizeof(int));
+        }
+        return sendmsg(fd, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(r));
+    }
+
+    static std::optional<response> receive_response(int fd) {
+        response r;
+        if (recv(fd, &r, sizeof(r), 0) != static_cast<ssize_t>(sizeof(r))) {
+            return std::nullopt;
+        }
+        return r;
+    }
+
+    // copies `compressed` into the segment and decodes it there
+    static std::expected<std::string, service_failure> round_trip(loopback_client& c, const std::vector<uint8_t>& compressed, stream_format format,
+                                                                  std::optional<uint32_t> dictionary = std::nullopt) {
+        std::memcpy(c.segment.data(), compressed.data(), compressed.size());
+        auto n = c.client.decode(decode_job{.segment = c.number, .format = format, .input_length = compressed.size(), .output_offset = OUTPUT_OFFSET,
+                                               .output_capacity = SEGMENT_SIZE - OUTPUT_OFFSET, .dictionary = dictionary});
+        if (!n) {
+            return std::unexpected(n.error());
+        }
+        return std::string(reinterpret_cast<const char*>(c.segment.data() + OUTPUT_OFFSET), *n);
+    }
+};
+
+TEST_F(DecodeService, DecodesEveryFormat)
+{
+    auto c = connect();
+    const auto text = service_payload(2000, 2);
+    for (auto format : {stream_format::gzip, stream_format::zlib, stream_format::deflate}) {
+        auto r = round_trip(c, pack_payload(text, format), format);
+        ASSERT_TRUE(r) << r.error().message;
+        EXPECT_EQ(*r, text);
+    }
+}
+
+TEST_F(DecodeService, SharesPresetDictionaries)
+{
+    auto c = connect();
+    const auto text = service_payload(20, 3);
+
+    // zlib streams name their dictionary, raw DEFLATE requests have to
+    auto zlib_result = round_trip(c, pack_payload(text, stream_format::zlib, dict), stream_format::zlib);
+    ASSERT_TRUE(zlib_result) << zlib_result.error().message;
+    EXPECT_EQ(*zlib_result, text);
+    const auto raw = pack_payload(text, stream_format::deflate, dict);
+    auto raw_result = round_trip(c, raw, stream_format::deflate, dict->adler32());
+    ASSERT_TRUE(raw_result) << raw_result.error().message;
+    EXPECT_EQ(*raw_result, text);
+
+    auto unknown = round_trip(c, raw, stream_format::deflate, dict->adler32() + 1);
+    ASSERT_FALSE(unknown);
+    EXPECT_EQ(unknown.error().error, service_error::unknown_dictionary);
+    const std::string other = "a dictionary the service does not know";
+    auto foreign = std::make_shared<const deflate::dictionary>(reinterpret_cast<const uint8_t*>(other.data()), other.size());
+    auto missing = round_trip(c, pack_payload(text, stream_format::zlib, foreign), stream_format::zlib);
+    ASSERT_FALSE(missing);
+    EXPECT_EQ(missing.error().error, service_error::unknown_dictionary);
+}
+
+TEST_F(DecodeService, RejectsBadRequests)
+{
+    auto c = connect();
+    const auto text = service_payload(1000, 4);
+    auto compressed = pack_payload(text, stream_format::gzip);
+    std::memcpy(c.segment.data(), compressed.data(), compressed.size());
+
+    auto expect_error = [&](decode_job job, service_error error) {
+        auto r = c.client.decode(job);
+        ASSERT_FALSE(r);
+        EXPECT_EQ(r.error().error, error) << r.error().message;
+    };
+    auto job = [&](uint32_t segment, size_t input_offset, size_t input_length, size_t output_offset, size_t output_capacity) {
+        return decode_job{.segment = segment, .format = stream_format::gzip, .input_offset = input_offset, .input_length = input_length,
+                          .output_offset = output_offset, .output_capacity = output_capacity};
+    };
+    expect_error(job(c.number, 0, compressed.size(), OUTPUT_OFFSET, SEGMENT_SIZE), service_error::out_of_range);
+    expect_error(job(c.number, SIZE_MAX, 2, OUTPUT_OFFSET, 16), service_error::out_of_range);
+    expect_error(job(c.number, 0, compressed.size(), 16, 4096), service_error::bad_request);
+    expect_error(job(c.number + 1, 0, compressed.size(), OUTPUT_OFFSET, 4096), service_error::unknown_segment);
+    expect_error(job(c.number, 0, compressed.size(), OUTPUT_OFFSET, text.size() / 2), service_error::decode_failed);
+
+    c.segment.data()[compressed.size() / 2] ^= 0x55;
+    expect_error(job(c.number, 0, compressed.size(), OUTPUT_OFFSET, SEGMENT_SIZE - OUTPUT_OFFSET), service_error::decode_failed);
+
+    // the connection stays usable
+    auto r = round_trip(c, compressed, stream_format::gzip);
+    ASSERT_TRUE(r) << r.error().message;
+    EXPECT_EQ(*r, text);
+}
+
+TEST_F(DecodeService, LimitsAttachedSegments)
+{
+    auto c = connect();
+    for (int i = 1; i < 4; i++) {
+        auto segment = shared_segment::create(4096);
+        ASSERT_TRUE(segment);
+        EXPECT_TRUE(c.client.attach(*segment));
+    }
+    auto segment = shared_segment::create(4096);
+    ASSERT_TRUE(segment);
+    auto r = c.client.attach(*segment);
+    ASSERT_FALSE(r);
+    EXPECT_EQ(r.error().error, service_error::too_many_segments);
+}
+
+TEST_F(DecodeService, LimitsRequestsInFlight)
+{
+    const auto text = service_payload(1000, 7);
+    const auto compressed = pack_payload(text, stream_format::gzip);
+    auto segment = shared_segment::create(SEGMENT_SIZE);
+    ASSERT_TRUE(segment);
+    std::memcpy(segment->data(), compressed.data(), compressed.size());
+
+    const int fd = raw_connect();
+    ASSERT_GE(fd, 0);
+    request attach;
+    attach.type = request_type::attach;
+    ASSERT_TRUE(send_request(fd, attach, segment->fd()));
+    auto attached = receive_response(fd);
+    ASSERT_TRUE(attached);
+    ASSERT_EQ(attached->error, service_error::none);
+
+    // every worker waits for the gate, so the decodes stay queued
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    for (size_t i = 0; i < pool.size(); i++) {
+        pool.submit([opened]() { opened.wait(); });
+    }
+    for (uint32_t id = 1; id <= 3; id++) {
+        request r;
+        r.id = id;
+        r.segment = static_cast<uint32_t>(attached->value);
+        r.input_length = compressed.size();
+        r.output_offset = OUTPUT_OFFSET + (id - 1) * text.size();
+        r.output_capacity = text.size();
+        ASSERT_TRUE(send_request(fd, r));
+    }
+    auto refused = receive_response(fd);
+    ASSERT_TRUE(refused);
+    EXPECT_EQ(refused->id, 3u);
+    EXPECT_EQ(refused->error, service_error::too_many_requests);
+
+    gate.set_value();
+    for (int i = 0; i < 2; i++) {
+        auto r = receive_response(fd);
+        ASSERT_TRUE(r);
+        EXPECT_LE(r->id, 2u);
+        EXPECT_EQ(r->error, service_error::none) << r->message;
+        EXPECT_EQ(r->value, text.size());
+    }
+    close(fd);
+}
+
+TEST_F(DecodeService, DisconnectsClientsWhichDoNotRead)
+{
+    const int fd = raw_connect();
+    ASSERT_GE(fd, 0);
+    // a service which blocked on the full socket would stop reading, fail instead of hanging
+    timeval timeout{10, 0};
+    ASSERT_EQ(setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)), 0);
+
+    request r;
+    r.type = request_type::stats;
+    int sent = 0;
+    while (sent < 100000 && send_request(fd, r)) {
+        sent++;
+    }
+    EXPECT_LT(sent, 100000);
+    EXPECT_EQ(errno, EPIPE);
+
+    // other clients are still served
+    auto c = connect();
+    const auto text = service_payload(100, 8);
+    auto decoded = round_trip(c, pack_payload(text, stream_format::gzip), stream_format::gzip);
+    ASSERT_TRUE(decoded) << decoded.error().message;
+    EXPECT_EQ(*decoded, text);
+
+    // the responses sent before the service gave up are still there, then the connection ends
+    int answered = 0;
+    while (receive_response(fd)) {
+        answered++;
+    }
+    EXPECT_GT(answered, 0);
+    EXPECT_LT(answered, sent);
+    close(fd);
+}
+
+TEST_F(DecodeService, ConcurrentClientsShareThePool)
+{
+    constexpr int CLIENTS = 4;
+    constexpr int REQUESTS = 25;
+    const auto text = service_payload(3000, 5);
+    const auto compressed = pack_payload(text, stream_format::gzip);
+
+    std::vector<std::thread> clients;
+    std::vector<int> decoded(CLIENTS, 0);
+    for (int i = 0; i < CLIENTS; i++) {
+        clients.emplace_back([&, i]() {
+            auto c = connect();
+            for (int j = 0; j < REQUESTS; j++) {
+                auto r = round_trip(c, compressed, stream_format::gzip);
+                decoded[i] += r && *r == text;
+            }
+        });
+    }
+    for (auto& t : clients) {
+        t.join();
+    }
+    for (int n : decoded) {
+        EXPECT_EQ(n, REQUESTS);
+    }
+
+    auto c = connect();
+    auto stats = c.client.stats();
+    ASSERT_TRUE(stats) << stats.error().message;
+    EXPECT_EQ(stats->connections, 1u);
+    EXPECT_EQ(stats->requests, uint64_t(CLIENTS * REQUESTS));
+    EXPECT_EQ(stats->failures, 0u);
+    EXPECT_EQ(stats->bytes_out, uint64_t(CLIENTS * REQUESTS) * text.size());
+    EXPECT_EQ(stats->queue_depth, 0u);
+    EXPECT_GE(stats->max_queue_depth, 1u);
+    uint64_t counted = 0;
+    for (auto n : stats->latency_buckets) {
+        counted += n;
+    }
+    EXPECT_EQ(counted, stats->requests);
+    EXPECT_GT(stats->latency_max_ns, 0u);
+    EXPECT_LE(stats->latency_percentile_us(0.5), stats->latency_percentile_us(0.99));
+}
+
+TEST_F(DecodeService, ClientInAnotherProcess)
+{
+    const auto text = service_payload(1000, 6);
+    const auto compressed = pack_payload(text, stream_format::zlib);
+    const pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        // no gtest assertions in the child, the exit status tells
+        auto client = decode_client::connect(socket_path);
+        auto segment = shared_segment::create(SEGMENT_SIZE);
+        if (!client || !segment) {
+            _exit(1);
+        }
+        auto number = client->attach(*segment);
+        std::memcpy(segment->data(), compressed.data(), compressed.size());
+        auto n = number ? client->decode(decode_job{.segment = *number, .format = stream_format::zlib, .input_length = compressed.size(),
+                                                             .output_offset = OUTPUT_OFFSET, .output_capacity = SEGMENT_SIZE - OUTPUT_OFFSET})
+                        : std::unexpected(number.error());
+        const bool ok = n && std::string(reinterpret_cast<const char*>(segment->data() + OUTPUT_OFFSET), *n) == text;
+        _exit(ok ? 0 : 2);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST_F(DecodeService, ClientsNoticeTheServiceStopping)
+{
+    auto c = connect();
+    server->stop();
+    auto r = c.client.stats();
+    ASSERT_FALSE(r);
+    EXPECT_EQ(r.error().error, service_error::disconnected);
+    EXPECT_FALSE(decode_client::connect(socket_path));
+}
+
+TEST(SharedSegment, RefusesUnsealedMemory)
+{
+    const int fd = memfd_create("unsealed", MFD_CLOEXEC);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(ftruncate(fd, 4096), 0);
+    auto adopted = shared_segment::adopt(fd);
+    ASSERT_FALSE(adopted);
+    EXPECT_EQ(adopted.error(), EPERM);
+
+    auto segment = shared_segment::create(4096);
+    ASSERT_TRUE(segment);
+    EXPECT_NE(ftruncate(segment->fd(), 1024), 0);
+}
+
+}
@@ -174,7 +174,34 @@ INSTANTIATE_TEST_SUITE_P(HuffmanBlock, DecoderDeflateFixed, ::testing::Values(
             0x66, 0x68, 0x68, 0x6e, 0x67, 0x71, 0x77, 0x65, 0x72, 0x74, 0x79, 0x66, 0x76, 0x62,
             0x63, 0x62, 0x64, 0x66, 0x62
         }
+    },
+    compressed_expected_pair
+    {
+        std::vector<uint8_t>{0x4b, 0x4c, 0x4a, 0x4e, 0x49, 0x4d, 0x4b, 0xcf, 0x48, 0x44, 0xa3, 0x2b, 0x2a, 0xab, 0xd0, 0x85, 0x0},
+        std::vector<uint8_t>{
+            0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+            0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x78, 0x79, 0x7a, 0x61, 0x62, 0x63, 0x64, 0x65,
+            0x66, 0x67, 0x68, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68
+        }
     }
 ));
 
+TEST(DeflateDecoder, StoredBlocksSequence)
+{
+    // two stored blocks followed by an empty final static block
+    std::vector<uint8_t> input = {
+        0x00, 0x03, 0x00, 0xfc, 0xff, 'a', 'b', 'c',
+        0x00, 0x02, 0x00, 0xfd, 0xff, 'd', 'e',
+        0x03, 0x00
+    };
+    std::vector<uint8_t> actual(5);
+
+    decoder d(input.data(), input.size());
+    decode_result result = d.decode(actual.data(), actual.size());
+
+    ASSERT_TRUE(result) << result.error().message;
+    EXPECT_EQ(result->bytes_written, 5);
+    EXPECT_EQ(actual, (std::vector<uint8_t>{'a', 'b', 'c', 'd', 'e'}));
+}
+
 }
\ No newline at end of file
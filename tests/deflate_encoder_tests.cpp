@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "deflate/block_writer.hpp"
+#include "deflate/decoder.hpp"
+#include "deflate/huffman_encoding.hpp"
+#include "deflate/optimal_encoder.hpp"
+
+namespace zipper::deflate {
+
+static std::vector<uint8_t> text_data(size_t size) {
+    const std::string words[] = {"deflate ", "huffman ", "window ", "block ", "literal ", "distance ", "length ", "zipper\n"};
+    std::mt19937 rng(7);
+    std::vector<uint8_t> result;
+    while (result.size() < size) {
+        const auto& w = words[rng() % 8];
+        result.insert(result.end(), w.begin(), w.end());
+    }
+    result.resize(size);
+    return result;
+}
+
+static std::vector<uint8_t> random_data(size_t size) {
+    std::mt19937 rng(11);
+    std::vector<uint8_t> result(size);
+    for (auto& b : result) {
+        b = static_cast<uint8_t>(rng());
+    }
+    return result;
+}
+
+static std::vector<uint8_t> compress(encoder_if& e, const std::vector<uint8_t>& input) {
+    std::vector<uint8_t> output(compress_bound(input.size()));
+    auto result = e.encode(input.data(), input.size(), output.data(), output.size());
+    EXPECT_TRUE(result) << result.error().message;
+    output.resize(result ? result->bytes_written : 0);
+    return output;
+}
+
+static std::vector<uint8_t> decompress(std::vector<uint8_t>& compressed, size_t size) {
+    std::vector<uint8_t> output(size);
+    decoder d(compressed.data(), compressed.size());
+    auto result = d.decode(output.data(), output.size());
+    EXPECT_TRUE(result) << result.error().message;
+    EXPECT_EQ(result->bytes_written, size);
+    return output;
+}
+
+TEST(HuffmanEncoding, CodeLengthsAreLimited) {
+    // fibonacci frequencies produce a maximally skewed tree
+    std::array<uint32_t, 30> frequencies;
+    uint32_t a = 1, b = 1;
+    for (auto& f : frequencies) {
+        f = a;
+        const uint32_t c = a + b;
+        a = b;
+        b = c;
+    }
+    std::array<uint8_t, 30> lengths;
+    build_code_lengths(frequencies, lengths, 15);
+
+    double kraft = 0;
+    for (auto l : lengths) {
+        EXPECT_GE(l, 1);
+        EXPECT_LE(l, 15);
+        kraft += 1.0 / (1u << l);
+    }
+    EXPECT_DOUBLE_EQ(kraft, 1.0);
+}
+
+TEST(BlockWriter, StaticBlockRoundTrip) {
+    std::vector<uint8_t> expected = {'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'x'};
+    std::vector<lz77_symbol> symbols = {
+        lz77_symbol::literal('a'), lz77_symbol::literal('b'), lz77_symbol::literal('c'),
+        lz77_symbol::match(6, 3), lz77_symbol::literal('x')
+    };
+    std::vector<uint8_t> compressed(64);
+    bit_buffer buffer(compressed.data(), compressed.size(), 0);
+    block_writer writer(buffer);
+    ASSERT_TRUE(writer.write_static(symbols, true));
+    writer.align();
+    compressed.resize(buffer.byte_offset());
+
+    EXPECT_EQ(decompress(compressed, expected.size()), expected);
+}
+
+TEST(BlockWriter, ReportsShortTarget) {
+    std::vector<uint8_t> input = random_data(1000);
+    std::vector<uint8_t> compressed(100);
+    bit_buffer buffer(compressed.data(), compressed.size(), 0);
+    block_writer writer(buffer);
+    EXPECT_FALSE(writer.write_stored(input.data(), input.size(), true));
+}
+
+class OptimalEncoderRoundTrip : public testing::Test,
+    public testing::WithParamInterface<std::vector<uint8_t>>
+{
+};
+
+TEST_P(OptimalEncoderRoundTrip, Decodes)
+{
+    const auto& input = GetParam();
+    optimal_encoder e(optimal_options{.iterations = 4});
+    auto compressed = compress(e, input);
+    EXPECT_LE(compressed.size(), compress_bound(input.size()));
+    EXPECT_EQ(decompress(compressed, input.size()), input);
+}
+
+INSTANTIATE_TEST_SUITE_P(Inputs, OptimalEncoderRoundTrip, ::testing::Values(
+    std::vector<uint8_t>{},
+    std::vector<uint8_t>{'a'},
+    std::vector<uint8_t>(100000, 0),
+    text_data(200000),
+    random_data(70000)
+));
+
+TEST(OptimalEncoder, SmallMasterBlocksAndSplits)
+{
+    auto input = text_data(50000);
+    auto noise = random_data(20000);
+    input.insert(input.begin() + 20000, noise.begin(), noise.end());
+
+    optimal_encoder e(optimal_options{.iterations = 2, .max_blocks = 8, .master_block_size = 16384});
+    auto compressed = compress(e, input);
+    EXPECT_EQ(decompress(compressed, input.size()), input);
+}
+
+TEST(OptimalEncoder, BeatsStaticBlock)
+{
+    const auto input = text_data(20000);
+    optimal_encoder e;
+    auto compressed = compress(e, input);
+
+    std::vector<lz77_symbol> literals;
+    for (auto b : input) {
+        literals.push_back(lz77_symbol::literal(b));
+    }
+    EXPECT_LT(compressed.size() * 4, block_writer::static_cost(block_statistics::from_symbols(literals)) / 8);
+}
+
+TEST(OptimalEncoder, TimeBudgetStillProducesValidOutput)
+{
+    const auto input = text_data(300000);
+    optimal_encoder e(optimal_options{.iterations = 1000, .time_budget = std::chrono::milliseconds(1)});
+    auto compressed = compress(e, input);
+    EXPECT_EQ(decompress(compressed, input.size()), input);
+    // past the budget matches are still searched, only less deeply
+    EXPECT_LT(compressed.size(), input.size() / 2);
+}
+
+}
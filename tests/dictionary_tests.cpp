@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "checksum.hpp"
+#include "deflate/decoder.hpp"
+#include "deflate/dictionary.hpp"
+#include "deflate/optimal_encoder.hpp"
+#include "zlib/decoder.hpp"
+#include "zlib/encoder.hpp"
+
+namespace zipper {
+
+static std::vector<uint8_t> bytes(const std::string& s) {
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+static const std::string dictionary_text = R"({"user":"","id":0,"status":"active","roles":["reader","writer"]})";
+static const std::string message_text = R"({"user":"alice","id":42,"status":"active","roles":["reader","writer"]})";
+
+static std::shared_ptr<const deflate::dictionary> make_dictionary() {
+    return std::make_shared<const deflate::dictionary>(reinterpret_cast<const uint8_t*>(dictionary_text.data()), dictionary_text.size());
+}
+
+TEST(Checksum, Adler32) {
+    auto data = bytes("Wikipedia");
+    EXPECT_EQ(adler32(data.data(), data.size()), 0x11E60398u);
+    EXPECT_EQ(adler32(data.data() + 4, data.size() - 4, adler32(data.data(), 4)), 0x11E60398u);
+}
+
+TEST(Dictionary, RawPrimingRoundTrip) {
+    auto dict = make_dictionary();
+    auto message = bytes(message_text);
+
+    std::vector<uint8_t> primed(deflate::compress_bound(message.size()));
+    deflate::optimal_encoder with_dict(deflate::optimal_options{}, dict);
+    auto r = with_dict.encode(message.data(), message.size(), primed.data(), primed.size());
+    ASSERT_TRUE(r) << r.error().message;
+    primed.resize(r->bytes_written);
+
+    std::vector<uint8_t> plain(deflate::compress_bound(message.size()));
+    deflate::optimal_encoder without_dict;
+    r = without_dict.encode(message.data(), message.size(), plain.data(), plain.size());
+    ASSERT_TRUE(r) << r.error().message;
+    EXPECT_LT(primed.size() * 2, r->bytes_written);
+
+    std::vector<uint8_t> actual(message.size());
+    deflate::decoder d(primed.data(), primed.size(), *dict);
+    auto result = d.decode(actual.data(), actual.size());
+    ASSERT_TRUE(result) << result.error().message;
+    EXPECT_EQ(actual, message);
+}
+
+TEST(Dictionary, DecoderRejectsReferenceBeforeHistory) {
+    auto dict = make_dictionary();
+    auto message = bytes(message_text);
+
+    std::vector<uint8_t> primed(deflate::compress_bound(message.size()));
+    deflate::optimal_encoder e(deflate::optimal_options{}, dict);
+    auto r = e.encode(message.data(), message.size(), primed.data(), primed.size());
+    ASSERT_TRUE(r);
+
+    std::vector<uint8_t> actual(message.size());
+    deflate::decoder d(primed.data(), r->bytes_written);
+    EXPECT_FALSE(d.decode(actual.data(), actual.size()));
+}
+
+TEST(Dictionary, ZlibWithDictionaryFromZlib) {
+    // zlib.compressobj(9, zlib.DEFLATED, 15, 9, zlib.Z_DEFAULT_STRATEGY, zdict=dictionary_text)
+    std::vector<uint8_t> compressed = {
+        0x78, 0xf9, 0x7e, 0x21, 0x14, 0x7a, 0xab, 0x86, 0xe9, 0x4f, 0xcc, 0xc9, 0x4c,
+        0x4e, 0x85, 0x1a, 0x62, 0x62, 0x44, 0xa2, 0x29, 0x00, 0x10, 0xca, 0x16, 0xae
+    };
+    auto expected = bytes(message_text);
+    std::vector<uint8_t> actual(256);
+
+    zlib::decoder d(compressed.data(), compressed.size(), make_dictionary());
+    auto result = d.decode(actual.data(), actual.size());
+    ASSERT_TRUE(result) << result.error().message;
+    actual.resize(result->bytes_written);
+    EXPECT_EQ(actual, expected);
+
+    zlib::decoder missing(compressed.data(), compressed.size());
+    EXPECT_FALSE(missing.decode(actual.data(), actual.size()));
+
+    auto other_text = bytes("another dictionary");
+    zlib::decoder mismatch(compressed.data(), compressed.size(), std::make_shared<const deflate::dictionary>(other_text.data(), other_text.size()));
+    EXPECT_FALSE(mismatch.decode(actual.data(), actual.size()));
+}
+
+TEST(Dictionary, ZlibRoundTrip) {
+    auto dict = make_dictionary();
+    auto message = bytes(message_text);
+
+    std::vector<uint8_t> compressed(zlib::compress_bound(message.size()));
+    zlib::encoder e(deflate::optimal_options{}, dict);
+    auto r = e.encode(message.data(), message.size(), compressed.data(), compressed.size());
+    ASSERT_TRUE(r) << r.error().message;
+    compressed.resize(r->bytes_written);
+    EXPECT_EQ(compressed[1] & 0x20, 0x20);
+
+    std::vector<uint8_t> actual(message.size());
+    zlib::decoder d(compressed.data(), compressed.size(), dict);
+    auto result = d.decode(actual.data(), actual.size());
+    ASSERT_TRUE(result) << result.error().message;
+    EXPECT_EQ(actual, message);
+
+    compressed[compressed.size() - 1] ^= 1;
+    zlib::decoder corrupted(compressed.data(), compressed.size(), dict);
+    EXPECT_FALSE(corrupted.decode(actual.data(), actual.size()));
+}
+
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "deflate/decoder.hpp"
+#include "deflate/lockstep_decode.hpp"
+#include "deflate/stream_encoder.hpp"
+#include "test_helpers.hpp"
+
+namespace zipper::deflate {
+
+static std::vector<uint8_t> text(size_t size, uint32_t seed) {
+    const std::string words[] = {"lanes ", "take ", "turns ", "one ", "symbol ", "each\n"};
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> result;
+    while (result.size() < size) {
+        const auto& w = words[rng() % 6];
+        result.insert(result.end(), w.begin(), w.end());
+    }
+    result.resize(size);
+    return result;
+}
+
+static std::vector<uint8_t> noise(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> result(size);
+    std::generate(result.begin(), result.end(), [&] { return static_cast<uint8_t>(rng()); });
+    return result;
+}
+
+static std::vector<uint8_t> static_blocks(const std::vector<uint8_t>& input) {
+    stream_encoder e(stream_options{.strategy = compression_strategy::static_only});
+    std::vector<uint8_t> output(compress_bound(input.size(), stream_options{.strategy = compression_strategy::static_only}));
+    auto r = e.encode(input.data(), input.size(), output.data(), output.size());
+    EXPECT_TRUE(r);
+    output.resize(r ? r->bytes_written : 0);
+    return output;
+}
+
+// streams of every block type and of different lengths, each with the target `decode` gets
+struct batch {
+    std::vector<std::vector<uint8_t>> compressed;
+    std::vector<std::vector<uint8_t>> targets;
+
+    void add(std::vector<uint8_t> stream, size_t target_length) {
+        compressed.push_back(std::move(stream));
+        targets.emplace_back(target_length);
+    }
+
+    std::vector<stream_job> jobs() {
+        std::vector<stream_job> result;
+        for (size_t i = 0; i < compressed.size(); i++) {
+            result.push_back(stream_job{compressed[i].data(), compressed[i].size(), targets[i].data(), targets[i].size()});
+        }
+        return result;
+    }
+};
+
+static void expect_as_decode(batch& b, size_t lanes) {
+    const auto results = decode_lockstep(b.jobs(), lanes);
+    ASSERT_EQ(results.size(), b.compressed.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        std::vector<uint8_t> expected(b.targets[i].size());
+        decoder d(b.compressed[i].data(), b.compressed[i].size());
+        const auto r = d.decode(expected.data(), expected.size());
+        ASSERT_EQ(results[i].has_value(), r.has_value()) << "lanes " << lanes << ", stream " << i;
+        if (r) {
+            EXPECT_EQ(results[i]->bytes_written, r->bytes_written) << "lanes " << lanes << ", stream " << i;
+            EXPECT_EQ(results[i]->bits_read, r->bits_read) << "lanes " << lanes << ", stream " << i;
+            EXPECT_EQ(b.targets[i], expected) << "lanes " << lanes << ", stream " << i;
+        } else {
+            EXPECT_STREQ(results[i].error().message, r.error().message);
+            EXPECT_EQ(results[i].error().bit_num, r.error().bit_num);
+        }
+    }
+}
+
+TEST(LockstepDecode, MatchesDecoder)
+{
+    batch b;
+    for (uint32_t i = 0; i < 9; i++) {
+        const auto input = text(1000 + 3000 * i, i);
+        b.add(test::deflate_compress(input), input.size());
+        b.add(static_blocks(input), input.size());
+    }
+    const auto random = noise(70000, 1);
+    b.add(test::deflate_compress(random), random.size());
+    b.add(test::deflate_compress({}), 0);
+
+    for (size_t lanes = 0; lanes <= MAX_LOCKSTEP_LANES + 1; lanes++) {
+        expect_as_decode(b, lanes);
+    }
+    EXPECT_EQ(b.targets[0], text(1000, 0));
+    EXPECT_EQ(b.targets[b.targets.size() - 2], random);
+}
+
+TEST(LockstepDecode, FailuresAndShortTargetsStayInTheirLane)
+{
+    batch b;
+    const auto input = text(20000, 7);
+    const auto good = test::deflate_compress(input);
+    b.add(good, input.size());
+    // only the prefix which fits
+    b.add(good, input.size() / 3);
+    b.add(static_blocks(input), 100);
+    // ends before its last block
+    b.add(std::vector<uint8_t>(good.begin(), good.begin() + good.size() / 2), input.size());
+    // reserved block type
+    b.add({0x07, 0x00}, 10);
+    auto corrupted = good;
+    for (size_t i = 20; i < corrupted.size(); i += 97) {
+        corrupted[i] ^= 0x5A;
+    }
+    b.add(corrupted, input.size());
+    b.add(good, input.size());
+
+    for (size_t lanes = 1; lanes <= MAX_LOCKSTEP_LANES; lanes++) {
+        expect_as_decode(b, lanes);
+    }
+    const auto results = decode_lockstep(b.jobs());
+    EXPECT_TRUE(results[0]);
+    EXPECT_FALSE(results[4]);
+    EXPECT_TRUE(results[6]);
+    EXPECT_EQ(b.targets[6], input);
+}
+
+TEST(LockstepDecode, StepsGiveTheSameResultAsDecode)
+{
+    const auto input = text(50000, 3);
+    auto compressed = test::deflate_compress(input);
+    std::vector<uint8_t> actual(input.size());
+    decoder d(compressed.data(), compressed.size());
+    d.start(actual.data(), actual.size());
+    size_t steps = 0;
+    while (d.step(5)) {
+        steps++;
+    }
+    ASSERT_TRUE(d.progress());
+    EXPECT_EQ(d.progress()->bytes_written, input.size());
+    EXPECT_TRUE(d.stream_end());
+    EXPECT_GT(steps, input.size() / 258 / 5);
+    EXPECT_EQ(actual, input);
+}
+
+}
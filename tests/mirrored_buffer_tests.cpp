@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <numeric>
+#include <unistd.h>
+#include <vector>
+
+#include "mirrored_buffer.hpp"
+
+namespace zipper {
+
+static size_t page_size() {
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+class MirroredBufferModes : public testing::Test,
+    public testing::WithParamInterface<bool>
+{
+};
+
+TEST_P(MirroredBufferModes, RunAcrossTheEnd)
+{
+    const size_t size = 4 * page_size();
+    mirrored_buffer ring(size, GetParam());
+    ASSERT_EQ(ring.size(), size);
+
+    // written linearly over the end of the first half, read back from both ends of the ring
+    std::vector<uint8_t> run(1000);
+    std::iota(run.begin(), run.end(), 0);
+    const size_t pos = size - 300;
+    std::memcpy(ring.data() + pos, run.data(), run.size());
+    ring.commit(pos, run.size());
+
+    EXPECT_EQ(std::memcmp(ring.data() + pos, run.data(), 300), 0);
+    EXPECT_EQ(std::memcmp(ring.data(), run.data() + 300, 700), 0);
+    EXPECT_EQ(std::memcmp(ring.data() + size, run.data() + 300, 700), 0);
+}
+
+TEST_P(MirroredBufferModes, RunInTheSecondHalf)
+{
+    const size_t size = page_size();
+    mirrored_buffer ring(size, GetParam());
+
+    std::vector<uint8_t> run(size / 2, 0xAB);
+    std::memcpy(ring.data() + size + 10, run.data(), run.size());
+    ring.commit(size + 10, run.size());
+    EXPECT_EQ(std::memcmp(ring.data() + 10, run.data(), run.size()), 0);
+}
+
+TEST_P(MirroredBufferModes, Move)
+{
+    mirrored_buffer ring(page_size(), GetParam());
+    ring.data()[1] = 42;
+    ring.commit(1, 1);
+
+    mirrored_buffer moved(std::move(ring));
+    EXPECT_EQ(moved.data()[1], 42);
+    EXPECT_EQ(moved.data()[moved.size() + 1], 42);
+    EXPECT_EQ(moved.mirrored(), GetParam());
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, MirroredBufferModes, ::testing::Values(true, false),
+    [](const testing::TestParamInfo<bool>& info) { return info.param ? "Mapped" : "Fallback"; });
+
+TEST(MirroredBuffer, OddSizeFallsBack)
+{
+    mirrored_buffer ring(1000);
+    EXPECT_FALSE(ring.mirrored());
+    ring.data()[999] = 7;
+    ring.commit(999, 1);
+    EXPECT_EQ(ring.data()[1999], 7);
+}
+
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "deflate/stream_decoder.hpp"
+#include "test_helpers.hpp"
+
+namespace zipper::deflate {
+
+static std::vector<uint8_t> mixed_data(size_t size) {
+    const std::string words[] = {"stream ", "decoder ", "resumes ", "where ", "input ", "ended\n"};
+    std::mt19937 rng(3);
+    std::vector<uint8_t> result;
+    while (result.size() < size) {
+        if (rng() % 16 == 0) {
+            for (int i = 0; i < 300; i++) {
+                result.push_back(static_cast<uint8_t>(rng()));
+            }
+        } else {
+            const auto& w = words[rng() % 6];
+            result.insert(result.end(), w.begin(), w.end());
+        }
+    }
+    result.resize(size);
+    return result;
+}
+
+static std::vector<uint8_t> compress(const std::vector<uint8_t>& input) {
+    return test::deflate_compress(input, optimal_options{.iterations = 1, .master_block_size = 8192});
+}
+
+struct chunking {
+    size_t input_chunk;
+    size_t output_chunk;
+};
+
+class StreamDecoderChunks : public testing::Test,
+    public testing::WithParamInterface<chunking>
+{
+};
+
+TEST_P(StreamDecoderChunks, MatchesInput)
+{
+    const auto [input_chunk, output_chunk] = GetParam();
+    const auto expected = mixed_data(100000);
+    const auto compressed = compress(expected);
+
+    stream_decoder d;
+    std::vector<uint8_t> actual;
+    std::vector<uint8_t> out(output_chunk);
+    size_t fed = 0;
+    for (;;) {
+        size_t written = 0;
+        auto status = d.decode(out.data(), out.size(), written);
+        ASSERT_TRUE(status) << status.error().message;
+        actual.insert(actual.end(), out.begin(), out.begin() + written);
+        if (*status == stream_status::done) {
+            break;
+        }
+        if (*status == stream_status::need_input) {
+            ASSERT_LT(fed, compressed.size());
+            const size_t n = std::min(input_chunk, compressed.size() - fed);
+            d.feed(compressed.data() + fed, n);
+            fed += n;
+        }
+    }
+
+    EXPECT_EQ(actual, expected);
+    EXPECT_EQ(d.total_in(), compressed.size());
+    EXPECT_EQ(d.total_out(), expected.size());
+}
+
+INSTANTIATE_TEST_SUITE_P(Chunks, StreamDecoderChunks, ::testing::Values(
+    chunking{1, 7},
+    chunking{13, 65536},
+    chunking{1 << 20, 1},
+    chunking{4096, 4096}
+));
+
+TEST(StreamDecoder, StoredBlocksAcrossTheRing)
+{
+    // incompressible bytes between text make stored blocks land anywhere in the history ring
+    auto expected = mixed_data(200000);
+    std::mt19937 rng(11);
+    for (size_t i = 50000; i < 120000; i++) {
+        expected[i] = static_cast<uint8_t>(rng());
+    }
+    const auto compressed = compress(expected);
+
+    stream_decoder d;
+    d.feed(compressed.data(), compressed.size());
+    std::vector<uint8_t> actual;
+    std::vector<uint8_t> out(1000);
+    for (;;) {
+        size_t written = 0;
+        auto status = d.decode(out.data(), out.size(), written);
+        ASSERT_TRUE(status) << status.error().message;
+        actual.insert(actual.end(), out.begin(), out.begin() + written);
+        if (*status == stream_status::done) {
+            break;
+        }
+        ASSERT_EQ(*status, stream_status::need_output);
+    }
+    EXPECT_EQ(actual, expected);
+}
+
+TEST(StreamDecoder, UnusedInputAfterEnd)
+{
+    const auto expected = mixed_data(1000);
+    auto compressed = compress(expected);
+    const std::vector<uint8_t> trailer = {1, 2, 3, 4};
+    compressed.insert(compressed.end(), trailer.begin(), trailer.end());
+
+    stream_decoder d;
+    d.feed(compressed.data(), compressed.size());
+    std::vector<uint8_t> actual(2000);
+    size_t written = 0;
+    auto status = d.decode(actual.data(), actual.size(), written);
+    ASSERT_TRUE(status);
+    EXPECT_EQ(*status, stream_status::done);
+    EXPECT_EQ(written, expected.size());
+    auto unused = d.unused_input();
+    EXPECT_EQ(std::vector<uint8_t>(unused.begin(), unused.end()), trailer);
+}
+
+TEST(StreamDecoder, RejectsReservedBlock)
+{
+    std::vector<uint8_t> input = {0x07};
+    stream_decoder d;
+    d.feed(input.data(), input.size());
+    uint8_t out[16];
+    size_t written = 0;
+    EXPECT_FALSE(d.decode(out, sizeof(out), written));
+}
+
+}
@@ -0,0 +1,393 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "deflate/decoder.hpp"
+#include "deflate/optimal_encoder.hpp"
+#include "deflate/stream_decoder.hpp"
+#include "deflate/stream_encoder.hpp"
+#include "gzip/encoder.hpp"
+#include "zlib/encoder.hpp"
+
+namespace zipper::deflate {
+
+static std::vector<uint8_t> log_lines(size_t size) {
+    const std::string words[] = {"GET ", "POST ", "/index.html ", "/api/v1/items ", "200 ", "404 ", "bytes=1024\n"};
+    std::mt19937 rng(5);
+    std::vector<uint8_t> result;
+    while (result.size() < size) {
+        if (rng() % 32 == 0) {
+            for (int i = 0; i < 100; i++) {
+                result.push_back(static_cast<uint8_t>(rng()));
+            }
+        } else {
+            const auto& w = words[rng() % 7];
+            result.insert(result.end(), w.begin(), w.end());
+        }
+    }
+    result.resize(size);
+    return result;
+}
+
+// feeds `input` in `input_chunk` pieces into targets of `output_chunk` bytes, completing `flush`
+static std::vector<uint8_t> encode_all(stream_encoder& e, const uint8_t* input, size_t length, size_t input_chunk, size_t output_chunk, flush_mode flush) {
+    std::vector<uint8_t> output;
+    std::vector<uint8_t> out(output_chunk);
+    size_t fed = 0;
+    for (;;) {
+        const size_t n = std::min(input_chunk, length - fed);
+        const flush_mode mode = fed + n == length ? flush : flush_mode::no_flush;
+        auto r = e.encode(input + fed, n, out.data(), out.size(), mode);
+        EXPECT_TRUE(r) << r.error().message;
+        if (!r) {
+            break;
+        }
+        fed += r->bytes_read;
+        output.insert(output.end(), out.begin(), out.begin() + r->bytes_written);
+        if (fed == length && mode == flush && e.pending() == 0) {
+            break;
+        }
+    }
+    return output;
+}
+
+static std::vector<uint8_t> decompress(std::vector<uint8_t> compressed, size_t size) {
+    std::vector<uint8_t> result(size);
+    decoder d(compressed.data(), compressed.size());
+    auto r = d.decode(result.data(), result.size());
+    EXPECT_TRUE(r) << r.error().message;
+    return result;
+}
+
+// decodes an unfinished stream, everything before its end has to come out
+static std::vector<uint8_t> decompress_prefix(const std::vector<uint8_t>& compressed) {
+    stream_decoder d;
+    d.feed(compressed.data(), compressed.size());
+    std::vector<uint8_t> result;
+    std::vector<uint8_t> out(4096);
+    for (;;) {
+        size_t written = 0;
+        auto status = d.decode(out.data(), out.size(), written);
+        EXPECT_TRUE(status) << status.error().message;
+        result.insert(result.end(), out.begin(), out.begin() + written);
+        if (!status || *status != stream_status::need_output) {
+            break;
+        }
+    }
+    return result;
+}
+
+struct encode_chunking {
+    size_t input_chunk;
+    size_t output_chunk;
+    stream_options options;
+};
+
+static std::string describe(const encode_chunking& p) {
+    return "in" + std::to_string(p.input_chunk) + "_out" + std::to_string(p.output_chunk)
+        + "_w" + std::to_string(p.options.window_bits) + "_m" + std::to_string(p.options.memory_level)
+        + (p.options.rsyncable ? "_rsyncable" : "");
+}
+
+void PrintTo(const encode_chunking& p, std::ostream* os) {
+    *os << describe(p);
+}
+
+class StreamEncoderChunks : public testing::Test,
+    public testing::WithParamInterface<encode_chunking>
+{
+};
+
+TEST_P(StreamEncoderChunks, RoundTrip)
+{
+    const auto [input_chunk, output_chunk, options] = GetParam();
+    const auto expected = log_lines(200000);
+
+    stream_encoder e(options);
+    const auto compressed = encode_all(e, expected.data(), expected.size(), input_chunk, output_chunk, flush_mode::finish);
+    EXPECT_TRUE(e.finished());
+    EXPECT_LT(compressed.size(), expected.size() / 2);
+    EXPECT_EQ(e.total_in(), expected.size());
+    EXPECT_EQ(e.total_out(), compressed.size());
+    EXPECT_EQ(decompress(compressed, expected.size()), expected);
+}
+
+INSTANTIATE_TEST_SUITE_P(Chunks, StreamEncoderChunks, ::testing::Values(
+    encode_chunking{1 << 20, 1 << 20, {}},
+    encode_chunking{1, 7, {}},
+    encode_chunking{4096, 1, {}},
+    encode_chunking{1000, 333, {.window_bits = 9, .memory_level = 1}},
+    encode_chunking{65536, 4096, {.window_bits = 12, .memory_level = 4, .max_chain = 4}},
+    encode_chunking{777, 1000, {.rsyncable = true}},
+    encode_chunking{1 << 20, 1 << 20, {.window_bits = 12, .rsyncable = true, .rsync_bits = 9}}
+), [](const testing::TestParamInfo<encode_chunking>& info) { return describe(info.param); });
+
+TEST(StreamEncoder, SyncFlushMakesPrefixDecodable)
+{
+    const auto input = log_lines(50000);
+    stream_encoder e;
+    std::vector<uint8_t> compressed;
+    for (size_t done = 0; done < input.size();) {
+        const size_t n = std::min<size_t>(1234, input.size() - done);
+        auto part = encode_all(e, input.data() + done, n, n, 100, flush_mode::sync_flush);
+        compressed.insert(compressed.end(), part.begin(), part.end());
+        done += n;
+
+        ASSERT_GE(compressed.size(), 4u);
+        EXPECT_EQ(std::vector<uint8_t>(compressed.end() - 4, compressed.end()), (std::vector<uint8_t>{0x00, 0x00, 0xFF, 0xFF}));
+        EXPECT_EQ(decompress_prefix(compressed), std::vector<uint8_t>(input.begin(), input.begin() + done));
+    }
+
+    auto tail = encode_all(e, nullptr, 0, 0, 100, flush_mode::finish);
+    compressed.insert(compressed.end(), tail.begin(), tail.end());
+    EXPECT_EQ(decompress(compressed, input.size()), input);
+}
+
+TEST(StreamEncoder, FullFlushResetsHistory)
+{
+    const auto message = log_lines(3000);
+    stream_encoder e;
+    auto first = encode_all(e, message.data(), message.size(), message.size(), 1 << 16, flush_mode::full_flush);
+    auto second = encode_all(e, message.data(), message.size(), message.size(), 1 << 16, flush_mode::full_flush);
+    // without history the repeated message costs about as much as the first one
+    EXPECT_GT(second.size() + 8, first.size());
+
+    // the part after a full flush decodes on its own
+    auto tail = encode_all(e, nullptr, 0, 0, 1 << 16, flush_mode::finish);
+    second.insert(second.end(), tail.begin(), tail.end());
+    EXPECT_EQ(decompress(second, message.size()), message);
+}
+
+TEST(StreamEncoder, SyncFlushKeepsHistory)
+{
+    const auto message = log_lines(3000);
+    stream_encoder e;
+    auto first = encode_all(e, message.data(), message.size(), message.size(), 1 << 16, flush_mode::sync_flush);
+    auto second = encode_all(e, message.data(), message.size(), message.size(), 1 << 16, flush_mode::sync_flush);
+    EXPECT_LT(second.size() * 10, first.size());
+}
+
+TEST(StreamEncoder, RepeatedFlushAddsNothing)
+{
+    const auto message = log_lines(100);
+    stream_encoder e;
+    auto first = encode_all(e, message.data(), message.size(), message.size(), 256, flush_mode::sync_flush);
+    EXPECT_FALSE(first.empty());
+    auto again = encode_all(e, nullptr, 0, 0, 256, flush_mode::sync_flush);
+    EXPECT_TRUE(again.empty());
+}
+
+TEST(StreamEncoder, EmptyStream)
+{
+    stream_encoder e;
+    auto compressed = encode_all(e, nullptr, 0, 0, 16, flush_mode::finish);
+    EXPECT_EQ(compressed, (std::vector<uint8_t>{0x03, 0x00}));
+
+    uint8_t out[16];
+    EXPECT_FALSE(e.encode(nullptr, 0, out, sizeof(out), flush_mode::finish));
+    e.reset();
+    EXPECT_TRUE(e.encode(nullptr, 0, out, sizeof(out), flush_mode::finish));
+}
+
+static std::string strategy_name(compression_strategy s) {
+    switch (s) {
+    case compression_strategy::lz77: return "lz77";
+    case compression_strategy::huffman_only: return "huffman_only";
+    case compression_strategy::rle: return "rle";
+    case compression_strategy::static_only: return "static_only";
+    }
+    return "unknown";
+}
+
+TEST(StreamEncoder, OneShotThroughEncoderInterface)
+{
+    std::mt19937 rng(12);
+    std::vector<uint8_t> noise(200000);
+    std::generate(noise.begin(), noise.end(), [&] { return static_cast<uint8_t>(rng()); });
+
+    stream_encoder e;
+    encoder_if& one_shot = e;
+    // every call is a stream of its own
+    for (const auto& input : {log_lines(100000), noise, log_lines(5000)}) {
+        std::vector<uint8_t> out(compress_bound(input.size(), stream_options{}));
+        auto r = one_shot.encode(input.data(), input.size(), out.data(), out.size());
+        ASSERT_TRUE(r) << r.error().message;
+        EXPECT_EQ(r->bytes_read, input.size());
+        out.resize(r->bytes_written);
+        EXPECT_EQ(decompress(out, input.size()), input);
+    }
+
+    std::vector<uint8_t> small(100);
+    const auto input = log_lines(10000);
+    EXPECT_FALSE(one_shot.encode(input.data(), input.size(), small.data(), small.size()));
+}
+
+TEST(StreamEncoder, RandomDataFitsTheBound)
+{
+    std::mt19937 rng(13);
+    std::vector<uint8_t> noise(200000);
+    std::generate(noise.begin(), noise.end(), [&] { return static_cast<uint8_t>(rng()); });
+
+    // small blocks and windows each end in a stored block of their own
+    for (uint32_t memory_level : {1u, 2u, 4u, 9u}) {
+        for (auto strategy : {compression_strategy::lz77, compression_strategy::huffman_only, compression_strategy::rle, compression_strategy::static_only}) {
+            for (const stream_options options : {
+                     stream_options{.memory_level = memory_level, .strategy = strategy},
+                     stream_options{.window_bits = 9, .memory_level = memory_level, .strategy = strategy, .rsyncable = true, .rsync_bits = 8}}) {
+                stream_encoder e(options);
+                std::vector<uint8_t> out(compress_bound(noise.size(), options));
+                auto r = e.encode(noise.data(), noise.size(), out.data(), out.size());
+                ASSERT_TRUE(r) << "memory_level " << memory_level << ": " << r.error().message;
+                out.resize(r->bytes_written);
+                EXPECT_EQ(decompress(out, noise.size()), noise);
+            }
+        }
+    }
+
+    const stream_options options{.memory_level = 1};
+    zlib::encoder z(options);
+    std::vector<uint8_t> z_out(zlib::compress_bound(noise.size(), options));
+    EXPECT_TRUE(z.encode(noise.data(), noise.size(), z_out.data(), z_out.size()));
+    gzip::encoder g(options);
+    std::vector<uint8_t> g_out(gzip::compress_bound(noise.size(), options));
+    EXPECT_TRUE(g.encode(noise.data(), noise.size(), g_out.data(), g_out.size()));
+}
+
+class StreamEncoderStrategy : public testing::Test,
+    public testing::WithParamInterface<compression_strategy>
+{
+};
+
+TEST_P(StreamEncoderStrategy, RoundTrip)
+{
+    std::mt19937 rng(11);
+    std::vector<uint8_t> noise(100000);
+    std::generate(noise.begin(), noise.end(), [&] { return static_cast<uint8_t>(rng()); });
+    // rows of runs, as in a bitmap
+    std::vector<uint8_t> runs;
+    while (runs.size() < 100000) {
+        runs.insert(runs.end(), 1 + rng() % 300, static_cast<uint8_t>(rng() % 4));
+    }
+
+    for (const auto& input : {log_lines(100000), noise, runs}) {
+        stream_encoder e(stream_options{.strategy = GetParam()});
+        const auto compressed = encode_all(e, input.data(), input.size(), 1000, 333, flush_mode::finish);
+        EXPECT_EQ(decompress(compressed, input.size()), input);
+        // incompressible data falls back to stored blocks, 5 bytes of overhead each
+        EXPECT_LE(compressed.size(), input.size() + input.size() / 1000 + 8);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Strategies, StreamEncoderStrategy, ::testing::Values(
+    compression_strategy::lz77, compression_strategy::huffman_only, compression_strategy::rle, compression_strategy::static_only
+), [](const testing::TestParamInfo<compression_strategy>& info) { return strategy_name(info.param); });
+
+TEST(StreamEncoder, StrategiesMatchWhatTheyMay)
+{
+    auto compressed_size = [](const std::vector<uint8_t>& input, compression_strategy strategy) {
+        stream_encoder e(stream_options{.strategy = strategy});
+        return encode_all(e, input.data(), input.size(), input.size(), 1 << 20, flush_mode::finish).size();
+    };
+    std::vector<uint8_t> repeats;
+    for (int i = 0; i < 10000; i++) {
+        repeats.insert(repeats.end(), {'a', 'b', 'c', 'd'});
+    }
+    const std::vector<uint8_t> run(40000, 'x');
+
+    // two bits per literal without matches
+    EXPECT_LT(compressed_size(repeats, compression_strategy::lz77), 1000u);
+    EXPECT_GT(compressed_size(repeats, compression_strategy::huffman_only), repeats.size() / 5);
+    EXPECT_GT(compressed_size(repeats, compression_strategy::rle), repeats.size() / 5);
+    EXPECT_LT(compressed_size(run, compression_strategy::rle), 1000u);
+    EXPECT_GT(compressed_size(run, compression_strategy::huffman_only), run.size() / 10);
+}
+
+TEST(StreamEncoder, StaticOnlyWritesStaticBlocks)
+{
+    const auto input = log_lines(20000);
+    stream_encoder e(stream_options{.strategy = compression_strategy::static_only});
+    const auto compressed = encode_all(e, input.data(), input.size(), input.size(), 1 << 20, flush_mode::finish);
+    ASSERT_FALSE(compressed.empty());
+    // BTYPE of the first block
+    EXPECT_EQ((compressed[0] >> 1) & 3, STATIC_HUFFMAN);
+    EXPECT_EQ(decompress(compressed, input.size()), input);
+}
+
+// the compressed stream cut after every empty stored block, the unit a deduplicating store sees
+static std::vector<std::vector<uint8_t>> flush_segments(const std::vector<uint8_t>& compressed) {
+    const std::vector<uint8_t> marker = {0x00, 0x00, 0xFF, 0xFF};
+    std::vector<std::vector<uint8_t>> result;
+    auto begin = compressed.begin();
+    for (auto it = compressed.begin(); (it = std::search(it, compressed.end(), marker.begin(), marker.end())) != compressed.end();) {
+        it += marker.size();
+        result.emplace_back(begin, it);
+        begin = it;
+    }
+    result.emplace_back(begin, compressed.end());
+    return result;
+}
+
+// fraction of the bytes of `b` in segments which also occur in `a`
+static double shared_fraction(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    const auto known = flush_segments(a);
+    size_t shared = 0;
+    for (const auto& segment : flush_segments(b)) {
+        if (std::find(known.begin(), known.end(), segment) != known.end()) {
+            shared += segment.size();
+        }
+    }
+    return static_cast<double>(shared) / b.size();
+}
+
+TEST(StreamEncoder, RsyncableIndependentOfCallPattern)
+{
+    const auto input = log_lines(150000);
+    const stream_options options{.rsyncable = true};
+    stream_encoder e(options);
+    const auto whole = encode_all(e, input.data(), input.size(), input.size(), 1 << 20, flush_mode::finish);
+    for (size_t chunk : {1, 999, 40000}) {
+        stream_encoder pieces(options);
+        EXPECT_EQ(encode_all(pieces, input.data(), input.size(), chunk, 100, flush_mode::finish), whole) << chunk;
+    }
+}
+
+TEST(StreamEncoder, RsyncableResynchronizesAfterEdit)
+{
+    const auto original = log_lines(300000);
+    auto edited = original;
+    edited.insert(edited.begin() + 5000, 'x');
+    edited[150000] ^= 1;
+
+    auto compress = [](const std::vector<uint8_t>& input, bool rsyncable) {
+        stream_encoder e(stream_options{.rsyncable = rsyncable});
+        return encode_all(e, input.data(), input.size(), input.size(), 1 << 20, flush_mode::finish);
+    };
+    const auto a = compress(original, true);
+    const auto b = compress(edited, true);
+    EXPECT_EQ(decompress(b, edited.size()), edited);
+    EXPECT_GT(shared_fraction(a, b), 0.9);
+    EXPECT_LT(shared_fraction(compress(original, false), compress(edited, false)), 0.1);
+
+    // resetting the history at every cut point costs some ratio
+    const auto plain = compress(original, false);
+    EXPECT_LT(a.size(), plain.size() + plain.size() / 10);
+
+    // a high setting is limited so that cuts still follow the content rather than the window
+    auto coarse = [](const std::vector<uint8_t>& input) {
+        stream_encoder e(stream_options{.rsyncable = true, .rsync_bits = 20});
+        return encode_all(e, input.data(), input.size(), input.size(), 1 << 20, flush_mode::finish);
+    };
+    EXPECT_GT(shared_fraction(coarse(original), coarse(edited)), 0.8);
+}
+
+TEST(StreamEncoder, SmallMemoryLevel)
+{
+    stream_encoder small(stream_options{.window_bits = 9, .memory_level = 1});
+    EXPECT_LT(small.memory_usage(), 4096u);
+    stream_encoder large;
+    EXPECT_GT(large.memory_usage(), 128u * 1024);
+}
+
+}
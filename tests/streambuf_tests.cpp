@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "compression_streambuf.hpp"
+#include "deflate/optimal_encoder.hpp"
+#include "deflate/stream_decoder.hpp"
+#include "gzip/decoder.hpp"
+#include "gzip/encoder.hpp"
+#include "zlib/decoder.hpp"
+#include "zlib/encoder.hpp"
+
+namespace zipper {
+
+static std::string csv(size_t rows) {
+    std::mt19937 rng(31);
+    std::string result = "id,name,score\n";
+    const char* names[] = {"alice", "bob", "carol", "dave"};
+    for (size_t i = 0; i < rows; i++) {
+        result += std::to_string(i) + "," + names[rng() % 4] + "," + std::to_string(rng() % 1000) + "\n";
+    }
+    return result;
+}
+
+static std::vector<uint8_t> bytes(const std::string& s) {
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+static std::string compress(const std::string& text, streambuf_options opts) {
+    std::ostringstream sink;
+    {
+        compress_streambuf buf(sink, opts);
+        std::ostream out(&buf);
+        out << text;
+        EXPECT_TRUE(buf.close());
+    }
+    return sink.str();
+}
+
+static std::string decompress(const std::string& compressed, streambuf_options opts, const char** error = nullptr) {
+    std::istringstream source(compressed);
+    decompress_streambuf buf(source, opts);
+    std::istream in(&buf);
+    std::string result((std::istreambuf_iterator<char>(in)), {});
+    if (error != nullptr) {
+        *error = buf.error();
+    } else {
+        EXPECT_EQ(buf.error(), nullptr) << buf.error();
+    }
+    return result;
+}
+
+class StreambufFormats : public testing::Test,
+    public testing::WithParamInterface<stream_format>
+{
+};
+
+TEST_P(StreambufFormats, RoundTripLineByLine)
+{
+    const std::string text = csv(20000);
+    const streambuf_options opts{.format = GetParam(), .buffer_size = 1000, .buffers = 3};
+    const std::string compressed = compress(text, opts);
+    EXPECT_LT(compressed.size(), text.size() / 2);
+
+    std::istringstream source(compressed);
+    decompress_streambuf buf(source, opts);
+    std::istream in(&buf);
+    std::string line, rebuilt;
+    size_t lines = 0;
+    while (std::getline(in, line)) {
+        rebuilt += line + "\n";
+        lines++;
+    }
+    EXPECT_EQ(buf.error(), nullptr);
+    EXPECT_EQ(lines, 20001u);
+    EXPECT_EQ(rebuilt, text);
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, StreambufFormats, ::testing::Values(stream_format::deflate, stream_format::zlib, stream_format::gzip));
+
+TEST(Streambuf, ReadsOneShotEncoders)
+{
+    const std::string text = csv(3000);
+    const auto data = bytes(text);
+
+    std::vector<uint8_t> member(gzip::compress_bound(data.size()));
+    gzip::encoder g(deflate::optimal_options{.iterations = 0});
+    auto r = g.encode(data.data(), data.size(), member.data(), member.size());
+    ASSERT_TRUE(r);
+    member.resize(r->bytes_written);
+    // two members read as one stream
+    std::string gz(member.begin(), member.end());
+    EXPECT_EQ(decompress(gz + gz, streambuf_options{.format = stream_format::gzip}), text + text);
+
+    std::vector<uint8_t> z(zlib::compress_bound(data.size()));
+    zlib::encoder ze(deflate::optimal_options{.iterations = 0});
+    r = ze.encode(data.data(), data.size(), z.data(), z.size());
+    ASSERT_TRUE(r);
+    EXPECT_EQ(decompress(std::string(z.begin(), z.begin() + r->bytes_written), streambuf_options{.format = stream_format::zlib, .buffer_size = 100}), text);
+}
+
+TEST(Streambuf, OneShotDecodersReadOutput)
+{
+    const std::string text = csv(3000);
+    auto gz = bytes(compress(text, streambuf_options{.format = stream_format::gzip}));
+    std::vector<uint8_t> actual(text.size());
+    gzip::decoder gd(gz.data(), gz.size());
+    ASSERT_TRUE(gd.decode(actual.data(), actual.size()));
+    EXPECT_EQ(actual, bytes(text));
+
+    auto z = bytes(compress(text, streambuf_options{.format = stream_format::zlib, .deflate = {.window_bits = 12}}));
+    zlib::decoder zd(z.data(), z.size());
+    ASSERT_TRUE(zd.decode(actual.data(), actual.size()));
+    EXPECT_EQ(actual, bytes(text));
+}
+
+TEST(Streambuf, FlushMakesWrittenDataDecodable)
+{
+    std::ostringstream sink;
+    compress_streambuf buf(sink, streambuf_options{.format = stream_format::deflate, .buffer_size = 512});
+    std::ostream out(&buf);
+    std::string sent;
+    for (int i = 0; i < 5; i++) {
+        const std::string message = "message " + std::to_string(i) + ": " + csv(10 * i);
+        out << message << std::flush;
+        sent += message;
+
+        const std::string so_far = sink.str();
+        deflate::stream_decoder d;
+        d.feed(reinterpret_cast<const uint8_t*>(so_far.data()), so_far.size());
+        std::vector<uint8_t> decoded(sent.size() + 16);
+        size_t written = 0;
+        auto status = d.decode(decoded.data(), decoded.size(), written);
+        ASSERT_TRUE(status);
+        EXPECT_EQ(*status, deflate::stream_status::need_input);
+        EXPECT_EQ(std::string(decoded.begin(), decoded.begin() + written), sent);
+    }
+    EXPECT_TRUE(buf.close());
+    EXPECT_FALSE(out << "after close" << std::flush);
+}
+
+TEST(Streambuf, CorruptDataEndsWithError)
+{
+    const std::string text = csv(3000);
+    std::string gz = compress(text, streambuf_options{.format = stream_format::gzip});
+    const char* error = nullptr;
+
+    std::string damaged = gz;
+    damaged[damaged.size() - 6] ^= 1;
+    decompress(damaged, streambuf_options{.format = stream_format::gzip}, &error);
+    EXPECT_NE(error, nullptr);
+
+    const std::string truncated = gz.substr(0, gz.size() / 2);
+    const std::string partial = decompress(truncated, streambuf_options{.format = stream_format::gzip}, &error);
+    EXPECT_NE(error, nullptr);
+    EXPECT_EQ(partial, text.substr(0, partial.size()));
+
+    decompress("plain text", streambuf_options{.format = stream_format::zlib}, &error);
+    EXPECT_NE(error, nullptr);
+}
+
+TEST(Streambuf, StopsReadingEarly)
+{
+    const std::string text = csv(50000);
+    const std::string gz = compress(text, streambuf_options{.format = stream_format::gzip});
+    std::istringstream source(gz);
+    decompress_streambuf buf(source, streambuf_options{.format = stream_format::gzip, .buffer_size = 256, .buffers = 2});
+    std::istream in(&buf);
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ(line, "id,name,score");
+    // the destructor has to stop the worker blocked on the full ring
+}
+
+}
@@ -0,0 +1,27 @@
+#ifndef TESTS_TEST_HELPERS_HPP
+#define TESTS_TEST_HELPERS_HPP
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+#include "deflate/optimal_encoder.hpp"
+
+namespace zipper::test {
+
+// Raw DEFLATE of `input`. A failing encoder fails the test and gives an empty stream.
+inline std::vector<uint8_t> deflate_compress(const std::vector<uint8_t>& input, deflate::optimal_options options = {}) {
+    std::vector<uint8_t> output(deflate::compress_bound(input.size()));
+    deflate::optimal_encoder e(options);
+    auto result = e.encode(input.data(), input.size(), output.data(), output.size());
+    if (!result) {
+        ADD_FAILURE() << "Encoding failed: " << result.error().message;
+        return {};
+    }
+    output.resize(result->bytes_written);
+    return output;
+}
+
+} // namespace zipper::test
+
+#endif
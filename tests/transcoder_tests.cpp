@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "compression_streambuf.hpp"
+#include "gzip/bgzf.hpp"
+#include "thread_pool.hpp"
+#include "transcoder.hpp"
+
+namespace zipper {
+
+static std::string log_lines(size_t lines) {
+    std::mt19937 rng(41);
+    const char* levels[] = {"INFO", "WARN", "DEBUG"};
+    std::string result;
+    for (size_t i = 0; i < lines; i++) {
+        result += "2024-05-0" + std::to_string(1 + rng() % 9) + " " + levels[rng() % 3] + " request " +
+                  std::to_string(rng() % 100000) + " took " + std::to_string(rng() % 500) + "ms\n";
+    }
+    return result;
+}
+
+static std::string pack(const std::string& text, stream_format format) {
+    std::ostringstream sink;
+    {
+        streambuf_options opts;
+        opts.format = format;
+        compress_streambuf buf(sink, opts);
+        std::ostream(&buf) << text;
+    }
+    return sink.str();
+}
+
+static std::string unpack(const std::string& compressed, stream_format format) {
+    std::istringstream source(compressed);
+    streambuf_options opts;
+    opts.format = format;
+    decompress_streambuf buf(source, opts);
+    std::istream in(&buf);
+    std::string result((std::istreambuf_iterator<char>(in)), {});
+    EXPECT_EQ(buf.error(), nullptr) << buf.error();
+    return result;
+}
+
+struct transcode_case {
+    stream_format from;
+    stream_format to;
+    bool bgzf;
+};
+
+static std::string format_name(stream_format f) {
+    return f == stream_format::deflate ? "Deflate" : f == stream_format::zlib ? "Zlib" : "Gzip";
+}
+
+void PrintTo(const transcode_case& c, std::ostream* os) {
+    *os << format_name(c.from) << "To" << (c.bgzf ? "Bgzf" : format_name(c.to));
+}
+
+class TranscodeFormats : public testing::Test,
+    public testing::WithParamInterface<transcode_case>
+{
+};
+
+TEST_P(TranscodeFormats, RoundTrip)
+{
+    const auto [from, to, bgzf] = GetParam();
+    const auto text = log_lines(8000);
+    std::istringstream in(pack(text, from));
+    std::ostringstream out;
+
+    thread_pool pool(3);
+    transcode_options opts;
+    opts.from = from;
+    opts.to = to;
+    opts.bgzf = bgzf;
+    opts.deflate.iterations = 1;
+    opts.chunk_size = 40000;
+    auto stats = transcode(pool, in, out, opts);
+    ASSERT_TRUE(stats) << stats.error().message;
+
+    const auto compressed = out.str();
+    EXPECT_EQ(unpack(compressed, to), text);
+    EXPECT_EQ(stats->decode.bytes, text.size());
+    EXPECT_EQ(stats->encode.bytes, compressed.size());
+    EXPECT_GT(stats->encode.busy.count(), 0);
+    if (bgzf) {
+        ASSERT_GT(compressed.size(), gzip::BGZF_EOF.size());
+        EXPECT_TRUE(std::equal(gzip::BGZF_EOF.begin(), gzip::BGZF_EOF.end(), compressed.end() - gzip::BGZF_EOF.size(),
+                               [](uint8_t a, char b) { return a == static_cast<uint8_t>(b); }));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, TranscodeFormats, ::testing::Values(
+    transcode_case{stream_format::gzip, stream_format::gzip, false},
+    transcode_case{stream_format::gzip, stream_format::gzip, true},
+    transcode_case{stream_format::zlib, stream_format::deflate, false},
+    transcode_case{stream_format::deflate, stream_format::zlib, false}
+), [](const testing::TestParamInfo<transcode_case>& info) {
+    std::ostringstream name;
+    PrintTo(info.param, &name);
+    return name.str();
+});
+
+TEST(Transcode, HistoryAcrossChunks)
+{
+    // chunks primed with the end of the previous one compress about as well as one chunk
+    const auto text = log_lines(8000);
+    thread_pool pool(2);
+    transcode_options opts;
+    opts.deflate.iterations = 1;
+
+    auto transcoded_size = [&](size_t chunk_size) {
+        std::istringstream in(pack(text, stream_format::gzip));
+        std::ostringstream out;
+        opts.chunk_size = chunk_size;
+        EXPECT_TRUE(transcode(pool, in, out, opts));
+        return out.str().size();
+    };
+    const size_t whole = transcoded_size(text.size());
+    const size_t chunked = transcoded_size(20000);
+    EXPECT_LT(chunked, whole + whole / 25);
+}
+
+TEST(Transcode, EmptyStream)
+{
+    std::istringstream in(pack("", stream_format::gzip));
+    std::ostringstream out;
+    thread_pool pool(1);
+    ASSERT_TRUE(transcode(pool, in, out));
+    EXPECT_EQ(unpack(out.str(), stream_format::gzip), "");
+}
+
+TEST(Transcode, CorruptInput)
+{
+    auto compressed = pack(log_lines(2000), stream_format::gzip);
+    compressed[compressed.size() - 6] ^= 0x55;
+    std::istringstream in(compressed);
+    std::ostringstream out;
+    thread_pool pool(2);
+    auto result = transcode(pool, in, out);
+    ASSERT_FALSE(result);
+    EXPECT_STREQ(result.error().message, "CRC-32 mismatch");
+}
+
+}
@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "checksum.hpp"
+#include "zip/archive_reader.hpp"
+#include "zip/archive_writer.hpp"
+
+namespace zipper::zip {
+
+namespace fs = std::filesystem;
+
+static std::vector<uint8_t> sample(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> result(size);
+    for (size_t i = 0; i < size; i++) {
+        result[i] = (i / 2048) % 3 == 0 ? static_cast<uint8_t>(rng()) : static_cast<uint8_t>('a' + (i * seed) % 11);
+    }
+    return result;
+}
+
+static std::vector<uint8_t> read_file(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+}
+
+class Zip : public ::testing::Test {
+protected:
+    fs::path dir;
+    std::map<std::string, std::vector<uint8_t>> contents;
+
+    void SetUp() override {
+        dir = fs::temp_directory_path() / ("zipper-zip-" + std::to_string(::getpid()) + "-"
+            + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        for (uint32_t i = 0; i < 24; i++) {
+            contents["data/file" + std::to_string(i) + ".bin"] = sample(200 * i * i, i + 1);
+        }
+        contents["empty"] = {};
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    fs::path build(writer_options opts = writer_options{}) {
+        thread_pool pool(4);
+        opts.deflate.iterations = 0;
+        archive_writer writer(pool, opts);
+        writer.add("data/", {});
+        for (const auto& [name, data] : contents) {
+            writer.add(name, data);
+        }
+        const auto path = dir / "archive.zip";
+        auto r = writer.write(path);
+        EXPECT_TRUE(r) << r.error().message;
+        return path;
+    }
+};
+
+TEST(Checksum, Crc32) {
+    const std::string text = "The quick brown fox jumps over the lazy dog";
+    const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+    EXPECT_EQ(crc32(data, text.size()), 0x414FA339u);
+    EXPECT_EQ(crc32(data + 10, text.size() - 10, crc32(data, 10)), 0x414FA339u);
+    EXPECT_EQ(crc32(data, 0), 0u);
+}
+
+TEST_F(Zip, RoundTripToSink) {
+    auto archive = archive_reader::open(build());
+    ASSERT_TRUE(archive) << archive.error().message;
+    ASSERT_EQ(archive->entries().size(), contents.size() + 1);
+    EXPECT_EQ(archive->entries()[0].name, "data/");
+
+    thread_pool pool(4);
+    std::mutex mutex;
+    std::map<std::string, std::vector<uint8_t>> extracted;
+    auto results = archive->extract_all(pool, [&](const entry& e, std::span<const uint8_t> data) {
+        std::lock_guard lock(mutex);
+        extracted[e.name].assign(data.begin(), data.end());
+        return true;
+    });
+    for (const auto& r : results) {
+        ASSERT_TRUE(r) << r.error().name << ": " << r.error().message;
+    }
+    for (const auto& [name, data] : contents) {
+        EXPECT_EQ(extracted[name], data) << name;
+    }
+    // compressible entries are deflated, the empty one is stored
+    for (const auto& e : archive->entries()) {
+        if (e.uncompressed_size > 4096) {
+            EXPECT_EQ(e.method, METHOD_DEFLATED) << e.name;
+            EXPECT_LT(e.compressed_size, e.uncompressed_size) << e.name;
+        } else if (e.uncompressed_size == 0) {
+            EXPECT_EQ(e.method, METHOD_STORED) << e.name;
+        }
+    }
+}
+
+TEST_F(Zip, ParallelExtractionToDirectory) {
+    auto archive = archive_reader::open(build());
+    ASSERT_TRUE(archive) << archive.error().message;
+
+    thread_pool pool(4);
+    const auto out = dir / "out";
+    for (const auto& r : archive->extract_all(pool, out)) {
+        ASSERT_TRUE(r) << r.error().name << ": " << r.error().message;
+    }
+    EXPECT_TRUE(fs::is_directory(out / "data"));
+    for (const auto& [name, data] : contents) {
+        EXPECT_EQ(read_file(out / name), data) << name;
+    }
+}
+
+TEST_F(Zip, DuplicateNamesExtractTheLastEntry) {
+    thread_pool pool(4);
+    archive_writer writer(pool, writer_options{.deflate = {.iterations = 0}});
+    for (uint32_t i = 0; i < 4; i++) {
+        writer.add("dup.bin", sample(100000 + i, i + 1));
+    }
+    writer.add("./dup.bin", sample(5000, 9));
+    ASSERT_TRUE(writer.write(dir / "duplicates.zip"));
+
+    auto archive = archive_reader::open(dir / "duplicates.zip");
+    ASSERT_TRUE(archive) << archive.error().message;
+    const auto out = dir / "out";
+    const auto results = archive->extract_all(pool, out);
+    ASSERT_EQ(results.size(), 5u);
+    for (const auto& r : results) {
+        ASSERT_TRUE(r) << r.error().name << ": " << r.error().message;
+    }
+    EXPECT_EQ(*results[0], 0u);
+    EXPECT_EQ(*results[4], 5000u);
+    EXPECT_EQ(read_file(out / "dup.bin"), sample(5000, 9));
+}
+
+TEST_F(Zip, StoredMethod) {
+    auto archive = archive_reader::open(build(writer_options{.method = METHOD_STORED}));
+    ASSERT_TRUE(archive) << archive.error().message;
+    for (const auto& e : archive->entries()) {
+        EXPECT_EQ(e.method, METHOD_STORED);
+        EXPECT_EQ(e.compressed_size, e.uncompressed_size);
+        std::vector<uint8_t> actual(e.uncompressed_size);
+        auto r = archive->extract(e, actual.data(), actual.size());
+        ASSERT_TRUE(r) << r.error().message;
+        if (!e.is_directory()) {
+            EXPECT_EQ(actual, contents[e.name]);
+        }
+    }
+}
+
+TEST_F(Zip, ForcedZip64) {
+    auto archive = archive_reader::open(build(writer_options{.force_zip64 = true}));
+    ASSERT_TRUE(archive) << archive.error().message;
+    ASSERT_EQ(archive->entries().size(), contents.size() + 1);
+    for (const auto& e : archive->entries()) {
+        std::vector<uint8_t> actual(e.uncompressed_size);
+        auto r = archive->extract(e, actual.data(), actual.size());
+        ASSERT_TRUE(r) << r.error().message;
+        if (!e.is_directory()) {
+            EXPECT_EQ(actual, contents[e.name]) << e.name;
+        }
+    }
+}
+
+TEST_F(Zip, DetectsCorruption) {
+    auto archive = archive_reader::open(build());
+    ASSERT_TRUE(archive);
+    const auto& entries = archive->entries();
+    const auto it = std::find_if(entries.begin(), entries.end(), [](const entry& e) { return e.method == METHOD_DEFLATED; });
+    ASSERT_NE(it, entries.end());
+    std::vector<uint8_t> actual(it->uncompressed_size);
+    ASSERT_TRUE(archive->extract(*it, actual.data(), actual.size()));
+
+    entry wrong_crc = *it;
+    wrong_crc.crc32 ^= 1;
+    auto r = archive->extract(wrong_crc, actual.data(), actual.size());
+    ASSERT_FALSE(r);
+    EXPECT_EQ(r.error().name, it->name);
+
+    entry truncated = *it;
+    truncated.compressed_size /= 2;
+    EXPECT_FALSE(archive->extract(truncated, actual.data(), actual.size()));
+
+    entry outside = *it;
+    outside.local_header_offset = 1u << 30;
+    EXPECT_FALSE(archive->extract(outside, actual.data(), actual.size()));
+}
+
+TEST_F(Zip, RejectsImplausibleSizes) {
+    // claim 2^60 bytes for one entry in the ZIP64 extra field of its central directory header
+    const auto path = build(writer_options{.force_zip64 = true});
+    auto bytes = read_file(path);
+    const std::string corrupted = "data/file5.bin";
+    bool patched = false;
+    for (size_t pos = 0; pos + CENTRAL_HEADER_SIZE <= bytes.size() && !patched; pos++) {
+        const uint8_t* p = bytes.data() + pos;
+        const uint16_t name_length = read_le16(p + 28);
+        if (read_le32(p) != CENTRAL_HEADER_SIGNATURE
+            || std::string(reinterpret_cast<const char*>(p + CENTRAL_HEADER_SIZE), name_length) != corrupted) {
+            continue;
+        }
+        uint8_t* extra = bytes.data() + pos + CENTRAL_HEADER_SIZE + name_length;
+        ASSERT_EQ(read_le16(extra), ZIP64_EXTRA_ID);
+        write_le64(extra + 4, uint64_t{1} << 60);
+        patched = true;
+    }
+    ASSERT_TRUE(patched);
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+    auto archive = archive_reader::open(path);
+    ASSERT_TRUE(archive) << archive.error().message;
+    thread_pool pool(4);
+    const auto results = archive->extract_all(pool, [](const entry&, std::span<const uint8_t>) { return true; });
+    ASSERT_EQ(results.size(), archive->entries().size());
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& e = archive->entries()[i];
+        if (e.name == corrupted) {
+            ASSERT_FALSE(results[i]);
+            EXPECT_EQ(results[i].error().name, corrupted);
+        } else {
+            EXPECT_TRUE(results[i]) << results[i].error().name << ": " << results[i].error().message;
+        }
+    }
+
+    const auto& e = *std::find_if(archive->entries().begin(), archive->entries().end(), [&](const entry& x) { return x.name == corrupted; });
+    EXPECT_FALSE(archive->extract_to(e, dir / "out"));
+    EXPECT_FALSE(fs::exists(dir / "out" / corrupted));
+
+    // a stored entry has to be as long as its data
+    entry stored = e;
+    stored.method = METHOD_STORED;
+    stored.uncompressed_size = stored.compressed_size + 1;
+    std::vector<uint8_t> target(stored.uncompressed_size);
+    EXPECT_FALSE(archive->extract(stored, target.data(), target.size()));
+}
+
+TEST_F(Zip, RejectsUnsafeNames) {
+    thread_pool pool(2);
+    archive_writer writer(pool);
+    writer.add("../escape", {1, 2, 3});
+    const auto path = dir / "evil.zip";
+    ASSERT_TRUE(writer.write(path));
+
+    auto archive = archive_reader::open(path);
+    ASSERT_TRUE(archive);
+    auto r = archive->extract_to(archive->entries()[0], dir / "out");
+    EXPECT_FALSE(r);
+    EXPECT_FALSE(fs::exists(dir / "escape"));
+}
+
+TEST_F(Zip, RejectsGarbage) {
+    const auto path = dir / "garbage.zip";
+    std::ofstream(path, std::ios::binary) << std::string(1000, 'x');
+    EXPECT_FALSE(archive_reader::open(path));
+    EXPECT_FALSE(archive_reader::open(dir / "missing.zip"));
+}
+
+}